@@ -17,10 +17,13 @@
 #include <brio_lang/version.h>
 #include <brio_lang/fcgi.h>
 #include <brio_lang/util.h>
+#include <brio_lang/heap.h>
+#include <brio_lang/http.h>
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstdlib>
 
 
 /**
@@ -49,7 +52,7 @@ void print_version(){
  */
 void print_help(){
     print_version();
-    std::cout << "usage: ./brio [-h] [-v] [-i] [-t] [-gv] [-sym] [-ast] FILE.brio" << std::endl;
+    std::cout << "usage: ./brio [-h] [-v] [-i] [-t] [-gv] [-sym] [-ast] [--engine=ENGINE] [--gc-stats] [--gc-growth=FACTOR] [--http-pool=SIZE] [--http-idle=SECONDS] FILE.brio" << std::endl;
     std::cout << std::endl;
     std::cout << "optional arguments:" << std::endl;
     
@@ -102,6 +105,44 @@ void print_help(){
     std::cout << args_fcgi;
     cout.width(PADDING - args_fcgi.size() + desc_fcgi.size());
     std::cout << desc_fcgi << std::endl;
+
+    string args_engine = "  --engine=ENGINE";
+    string desc_engine = "Selects the execution engine, 'tree' (default) or 'vm'";
+    std::cout << args_engine;
+    cout.width(PADDING - args_engine.size() + desc_engine.size());
+    std::cout << desc_engine << std::endl;
+
+    string args_gc_stats = "  --gc-stats";
+    string desc_gc_stats = "Prints garbage collector statistics on exit";
+    std::cout << args_gc_stats;
+    cout.width(PADDING - args_gc_stats.size() + desc_gc_stats.size());
+    std::cout << desc_gc_stats << std::endl;
+
+    string args_gc_growth = "  --gc-growth=FACTOR";
+    string desc_gc_growth = "Full collection once old objects grow by FACTOR (default 2)";
+    std::cout << args_gc_growth;
+    cout.width(PADDING - args_gc_growth.size() + desc_gc_growth.size());
+    std::cout << desc_gc_growth << std::endl;
+
+    string args_http_pool = "  --http-pool=SIZE";
+    string desc_http_pool = "Keeps up to SIZE idle HTTP connections for reuse (default 8)";
+    std::cout << args_http_pool;
+    cout.width(PADDING - args_http_pool.size() + desc_http_pool.size());
+    std::cout << desc_http_pool << std::endl;
+
+    string args_http_idle = "  --http-idle=SECONDS";
+    string desc_http_idle = "Drops HTTP connections idle for longer than SECONDS (default 60)";
+    std::cout << args_http_idle;
+    cout.width(PADDING - args_http_idle.size() + desc_http_idle.size());
+    std::cout << desc_http_idle << std::endl;
+}
+
+/**
+ * Prints the garbage collector statistics, registered with atexit so
+ * programs ending with exit() report as well.
+ */
+void print_gc_stats(){
+    std::cerr << Heap::instance().getStats() << std::endl;
 }
 
 void start_repl(){
@@ -127,6 +168,26 @@ bool option_exists(char * argv[], int argc, string option){
     return false;
 }
 
+/**
+ * Returns the value of an option in the form "--name=value", or the
+ * provided default when not specified. Must be provided before filename.
+ */
+string option_value(char * argv[], int argc, string option, string fallback){
+    string prefix = option + "=";
+    for (int i=0; i<argc; i++){
+        string arg = argv[i];
+        if (arg.compare(0, prefix.size(), prefix) == 0){
+            return arg.substr(prefix.size());
+        }
+
+        // determine if file path reached
+        if (Util::string_has_ending(arg, ".brio")){
+            return fallback;
+        }
+    }
+    return fallback;
+}
+
 /**
  * Returns the source file path and subsequent arguments.
  */
@@ -159,6 +220,10 @@ int main(int argc, char * argv[]){
     bool OUTPUT_SYM_TABLE = false;   // if enabled, prints the sym table globals
     bool OUTPUT_AST_NODES = false;   // if enabled, visits each ast node and prints the type
     bool OUTPUT_FAST_CGI = false;    // if enabled, initialize Fast CGI 
+    string ENGINE = "tree";          // execution engine, "tree" or "vm"
+    string GC_GROWTH = "";           // heap growth factor that triggers a collection
+    string HTTP_POOL = "";           // idle HTTP connections kept for reuse
+    string HTTP_IDLE = "";           // seconds before an idle HTTP connection is dropped
 
     // check the number of parameters
     if (argc < 2) {
@@ -195,6 +260,22 @@ int main(int argc, char * argv[]){
     if (option_exists(argv, argc, "-fcgi")){
         OUTPUT_FAST_CGI = true;
     }
+    if (option_exists(argv, argc, "--gc-stats")){
+        std::atexit(print_gc_stats);
+    }
+    ENGINE = option_value(argv, argc, "--engine", ENGINE);
+    GC_GROWTH = option_value(argv, argc, "--gc-growth", GC_GROWTH);
+    if (GC_GROWTH != ""){
+        Heap::instance().setGrowthFactor(std::stod(GC_GROWTH));
+    }
+    HTTP_POOL = option_value(argv, argc, "--http-pool", HTTP_POOL);
+    if (HTTP_POOL != ""){
+        HttpPool::instance().setPoolSize(std::stoul(HTTP_POOL));
+    }
+    HTTP_IDLE = option_value(argv, argc, "--http-idle", HTTP_IDLE);
+    if (HTTP_IDLE != ""){
+        HttpPool::instance().setIdleTimeout(std::stol(HTTP_IDLE));
+    }
 
     // get file path and optional args
     vector<string> file_args = get_file_args(argv, argc);
@@ -226,6 +307,10 @@ int main(int argc, char * argv[]){
     OperatorPrecedenceVisitor opVisitor;
     opVisitor.visit(&tree);
 
+    // decode literals once
+    ConstantVisitor constVisitor;
+    constVisitor.visit(&tree);
+
     if (OUTPUT_AST_NODES){
         // run a node type print visitor
         std::cout << std::endl << "AST Nodes:" << std::endl;
@@ -262,8 +347,9 @@ int main(int argc, char * argv[]){
     Ref ref(&symbol_table);
     ref.downUp(&tree);
 
-    // execute the tree-based interpreter
+    // execute with the selected engine
     Interpreter interpreter(&tree, &symbol_table, file_args, file_path);
+    interpreter.setEngine(ENGINE);
 
     if (OUTPUT_FAST_CGI){
         FastCGI fcgi;
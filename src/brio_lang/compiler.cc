@@ -0,0 +1,676 @@
+///
+/// Brio Lang
+/// compiler.cc
+///
+/// Bytecode Compiler
+///
+
+#include <brio_lang/compiler.h>
+#include <brio_lang/exceptions.h>
+#include <brio_lang/visitor.h>
+
+#include <string>
+
+
+CodeObject::CodeObject(string code_name){
+    name = code_name;
+};
+
+string CodeObject::getName(){
+    return this->name;
+};
+
+int CodeObject::addConstant(Object * value){
+    constants.push_back(value);
+    return int(constants.size()) - 1;
+};
+
+int CodeObject::addNode(AST * node){
+    nodes.push_back(node);
+    return int(nodes.size()) - 1;
+};
+
+int CodeObject::addName(string id){
+    for (int i=0; i<int(names.size()); i++){
+        if (names[i] == id) return i;
+    }
+    names.push_back(id);
+    return int(names.size()) - 1;
+};
+
+int CodeObject::addMethod(MethodSymbol * method){
+    for (int i=0; i<int(methods.size()); i++){
+        if (methods[i] == method) return i;
+    }
+    methods.push_back(method);
+    return int(methods.size()) - 1;
+};
+
+BytecodeCompiler::BytecodeCompiler(SymbolTable * symTable){
+    table = symTable;
+    code = nullptr;
+    tryDepth = 0;
+    inMethod = false;
+};
+
+/**
+ * Lowers the block of a method into bytecode. Must be called after the
+ * Def and Ref passes so scopes and symbols are available.
+ */
+CodeObject * BytecodeCompiler::compileMethod(MethodSymbol * method){
+    this->code = new CodeObject(method->getSymbolName());
+    this->tryDepth = 0;
+    this->inMethod = true;
+    this->block(method->def_node->getSibling(3));
+    this->emit(OP_RETURN_NONE);
+    return this->code;
+};
+
+/**
+ * Lowers a single node into bytecode; expressions return their value,
+ * statements return nothing.
+ */
+CodeObject * BytecodeCompiler::compileNode(AST * node){
+    this->code = new CodeObject(node->getType());
+    this->tryDepth = 0;
+    this->inMethod = false;
+    if (BytecodeCompiler::isExpression(node)){
+        this->expression(node);
+        this->emit(OP_RETURN);
+    }else{
+        this->statement(node);
+        this->emit(OP_RETURN_NONE);
+    }
+    return this->code;
+};
+
+bool BytecodeCompiler::isExpression(AST * node){
+    switch (node->getKind()){
+        case MethodCallNode::kind:
+        case ClassInstantiationNode::kind:
+        case AddExpressionNode::kind:
+        case SubtractExpressionNode::kind:
+        case MultiplyExpressionNode::kind:
+        case DivideExpressionNode::kind:
+        case ModulusExpressionNode::kind:
+        case ExponentExpressionNode::kind:
+        case BitAndExpressionNode::kind:
+        case BitOrExpressionNode::kind:
+        case BitXorExpressionNode::kind:
+        case BitShiftLeftNode::kind:
+        case BitShiftRightNode::kind:
+        case BoolAndNode::kind:
+        case BoolOrNode::kind:
+        case BoolEqualsNode::kind:
+        case BoolNotEqualsNode::kind:
+        case BoolLessThanNode::kind:
+        case BoolLessThanOrEqualNode::kind:
+        case BoolGreaterThanNode::kind:
+        case BoolGreaterThanOrEqualNode::kind:
+        case ParenthesesNode::kind:
+        case LiteralIntNode::kind:
+        case LiteralStringNode::kind:
+        case LiteralDecimalNode::kind:
+        case LiteralBooleanNode::kind:
+        case LiteralNoneNode::kind:
+        case IndexNode::kind:
+        case ArrayNode::kind:
+        case DictionaryNode::kind:
+        case MemberAccessNode::kind:
+        case IdentifierNode::kind:
+            return true;
+        default:
+            return false;
+    }
+};
+
+int BytecodeCompiler::emit(Opcode op){
+    return this->emit(op, 0, 0);
+};
+
+int BytecodeCompiler::emit(Opcode op, int a){
+    return this->emit(op, a, 0);
+};
+
+int BytecodeCompiler::emit(Opcode op, int a, int b){
+    Instruction ins = {op, a, b};
+    code->code.push_back(ins);
+    return int(code->code.size()) - 1;
+};
+
+/** Returns the index of the next instruction to be emitted. */
+int BytecodeCompiler::here(){
+    return int(code->code.size());
+};
+
+/** Resolves the jump target of a previously emitted instruction. */
+void BytecodeCompiler::patch(int at, int target){
+    code->code[at].a = target;
+};
+
+void BytecodeCompiler::block(AST * node){
+    for (int i=0; i<node->getChildCount(); i++){
+        this->statement(node->children[i]);
+    }
+};
+
+void BytecodeCompiler::statement(AST * node){
+    switch (node->getKind()){
+        case BlockNode::kind:
+            this->block(node);
+            break;
+        case VarDeclarationNode::kind:
+            this->varDeclaration(node);
+            break;
+        case VarAssignmentNode::kind:
+            this->varAssignment(node);
+            break;
+        case AdditionAssignNode::kind:
+            this->compoundAssign(node, OP_ADD);
+            break;
+        case SubtractionAssignNode::kind:
+            this->compoundAssign(node, OP_SUBTRACT);
+            break;
+        case MultiplicationAssignNode::kind:
+            this->compoundAssign(node, OP_MULTIPLY);
+            break;
+        case DivisionAssignNode::kind:
+            this->compoundAssign(node, OP_DIVIDE);
+            break;
+        case BitOrAssignNode::kind:
+            this->compoundAssign(node, OP_BIT_OR);
+            break;
+        case BitAndAssignNode::kind:
+            this->compoundAssign(node, OP_BIT_AND);
+            break;
+        case ReturnNode::kind:
+            this->returnStatement(node);
+            break;
+        case IfStatementNode::kind:
+            this->ifStatement(node);
+            break;
+        case WhileStatementNode::kind:
+            this->whileStatement(node);
+            break;
+        case ForStatementNode::kind:
+            this->forStatement(node);
+            break;
+        case EachStatementNode::kind:
+            this->eachStatement(node);
+            break;
+        case TryStatementNode::kind:
+            this->tryStatement(node);
+            break;
+        case RaiseStatementNode::kind:
+            this->raiseStatement(node);
+            break;
+        case SkipStatementNode::kind:
+            this->skipStatement(node);
+            break;
+        case MethodDeclarationNode::kind:
+            // nothing to do
+            break;
+        default:
+            // expression statement, result is discarded
+            this->expression(node);
+            this->emit(OP_POP);
+    }
+};
+
+void BytecodeCompiler::expression(AST * node){
+    switch (node->getKind()){
+        case LiteralIntNode::kind:
+        case LiteralStringNode::kind:
+        case LiteralDecimalNode::kind:
+        case LiteralBooleanNode::kind:
+        case LiteralNoneNode::kind:
+            this->emit(OP_LOAD_CONST, code->addConstant(ConstantVisitor::materialize(node)));
+            break;
+        case IdentifierNode::kind:
+            this->loadName(node);
+            break;
+        case MemberAccessNode::kind:
+            this->memberLoad(node);
+            break;
+        case IndexNode::kind:
+            this->expression(node->children[0]);
+            break;
+        case ParenthesesNode::kind:
+            if (node->getChildCount() != 1){
+                throw RuntimeError("parentheses must have one child node");
+            }
+            this->expression(node->children[0]);
+            break;
+        case ArrayNode::kind:
+            for (int i=0; i<node->getChildCount(); i++){
+                this->expression(node->children[i]);
+            }
+            this->emit(OP_BUILD_ARRAY, node->getChildCount());
+            break;
+        case DictionaryNode::kind:
+            for (int i=0; i<node->getChildCount(); i++){
+                AST * kvPair = node->children[i];
+                this->expression(kvPair->children[0]);
+                this->expression(kvPair->children[1]);
+            }
+            this->emit(OP_BUILD_DICTIONARY, node->getChildCount());
+            break;
+        case MethodCallNode::kind:
+            this->methodCall(node);
+            break;
+        case ClassInstantiationNode::kind:
+            this->classInstantiation(node);
+            break;
+        case AddExpressionNode::kind:
+            this->binary(node, OP_ADD);
+            break;
+        case SubtractExpressionNode::kind:
+            this->binary(node, OP_SUBTRACT);
+            break;
+        case MultiplyExpressionNode::kind:
+            this->binary(node, OP_MULTIPLY);
+            break;
+        case DivideExpressionNode::kind:
+            this->binary(node, OP_DIVIDE);
+            break;
+        case ModulusExpressionNode::kind:
+            this->binary(node, OP_MODULUS);
+            break;
+        case ExponentExpressionNode::kind:
+            this->binary(node, OP_EXPONENT);
+            break;
+        case BitAndExpressionNode::kind:
+            this->binary(node, OP_BIT_AND);
+            break;
+        case BitOrExpressionNode::kind:
+            this->binary(node, OP_BIT_OR);
+            break;
+        case BitXorExpressionNode::kind:
+            this->binary(node, OP_BIT_XOR);
+            break;
+        case BitShiftLeftNode::kind:
+            this->binary(node, OP_BIT_SHIFT_LEFT);
+            break;
+        case BitShiftRightNode::kind:
+            this->binary(node, OP_BIT_SHIFT_RIGHT);
+            break;
+        case BoolAndNode::kind:
+            this->binary(node, OP_BOOL_AND);
+            break;
+        case BoolOrNode::kind:
+            this->binary(node, OP_BOOL_OR);
+            break;
+        case BoolEqualsNode::kind:
+            this->binary(node, OP_BOOL_EQUALS);
+            break;
+        case BoolNotEqualsNode::kind:
+            this->binary(node, OP_BOOL_NOT_EQUALS);
+            break;
+        case BoolLessThanNode::kind:
+            this->binary(node, OP_BOOL_LESS_THAN);
+            break;
+        case BoolLessThanOrEqualNode::kind:
+            this->binary(node, OP_BOOL_LESS_THAN_OR_EQUAL);
+            break;
+        case BoolGreaterThanNode::kind:
+            this->binary(node, OP_BOOL_GREATER_THAN);
+            break;
+        case BoolGreaterThanOrEqualNode::kind:
+            this->binary(node, OP_BOOL_GREATER_THAN_OR_EQUAL);
+            break;
+        default:
+            throw NotImplementedError("compiler: unimplemented node: " + node->getType());
+    }
+};
+
+void BytecodeCompiler::binary(AST * node, Opcode op){
+    AST * lhs = node->children[0];
+    AST * rhs = node->children[1];
+    this->expression(lhs);
+    this->expression(rhs);
+    this->emit(op, 0, rhs->getLineNo());
+};
+
+void BytecodeCompiler::varDeclaration(AST * node){
+    // if node only has one child, assume 'none' value for rhs
+    if (node->getChildCount() > 1){
+        this->expression(node->children[1]);
+    }else{
+        this->emit(OP_LOAD_CONST, code->addConstant(None::get()));
+    }
+    this->declareName(node->children[0]);
+};
+
+void BytecodeCompiler::varAssignment(AST * node){
+    AST * lhs = node->children[0];
+    AST * rhs = node->children[1];
+    this->expression(rhs);
+
+    if (lhs->getKind() == MemberAccessNode::kind){
+        this->memberStore(lhs);
+    }else{
+        this->storeName(lhs);
+    }
+};
+
+/**
+ * Compiles "x += y" style assignments; like the tree-walker the right
+ * hand side is evaluated before the current value is loaded.
+ */
+void BytecodeCompiler::compoundAssign(AST * node, Opcode op){
+    AST * lhs = node->children[0];
+    AST * rhs = node->children[1];
+    this->expression(rhs);
+    this->load(lhs);
+    this->emit(OP_SWAP);
+    this->emit(op, 0, rhs->getLineNo());
+
+    if (lhs->getKind() == MemberAccessNode::kind){
+        this->memberStore(lhs);
+    }else{
+        this->storeName(lhs);
+    }
+};
+
+/** Loads an identifier or member access target. */
+void BytecodeCompiler::load(AST * node){
+    if (node->getKind() == MemberAccessNode::kind){
+        this->memberLoad(node);
+    }else{
+        this->loadName(node);
+    }
+};
+
+/**
+ * Brio methods do not nest, so Ref.cc resolves a local to depth 0 and a
+ * slot of the method space; any other name is looked up at runtime.
+ */
+bool BytecodeCompiler::isLocal(AST * node){
+    return this->inMethod && node->slotDepth == 0;
+};
+
+void BytecodeCompiler::loadName(AST * node){
+    if (this->isLocal(node)){
+        this->emit(OP_LOAD_LOCAL, node->slotIndex, code->addNode(node));
+    }else{
+        this->emit(OP_LOAD_NAME, code->addNode(node));
+    }
+};
+
+void BytecodeCompiler::storeName(AST * node){
+    if (this->isLocal(node)){
+        this->emit(OP_STORE_LOCAL, node->slotIndex, code->addNode(node));
+    }else{
+        this->emit(OP_STORE_NAME, code->addNode(node));
+    }
+};
+
+void BytecodeCompiler::declareName(AST * node){
+    if (this->isLocal(node)){
+        this->emit(OP_DECLARE_LOCAL, node->slotIndex);
+    }else{
+        this->emit(OP_DECLARE_NAME, code->addName(node->getNodeText()));
+    }
+};
+
+/**
+ * Load an object from a class instance or object
+ * E.g. @board[0][1]  z["key"].foo  x[0]  y["foo"]  @board.foo.bar
+ */
+void BytecodeCompiler::memberLoad(AST * node){
+    this->load(node->children[0]);
+    for (int i=1; i<node->getChildCount(); i++){
+        this->member(node->children[i]);
+    }
+};
+
+/**
+ * Assign the value on top of the stack to a class instance or object
+ * E.g. @board[0][1] = 1  z["key"].foo = 2  x[0] = 3  @board.foo.bar = 4
+ */
+void BytecodeCompiler::memberStore(AST * node){
+    AST * z = node->children[node->getChildCount() - 1];
+    this->load(node->children[0]);
+    for (int i=1; i<node->getChildCount() - 1; i++){
+        this->member(node->children[i]);
+    }
+
+    if (z->getKind() == IdentifierNode::kind){
+        this->emit(OP_STORE_ATTR, code->addName(z->getNodeText()));
+    }else{
+        this->expression(z);
+        this->emit(OP_STORE_INDEX);
+    }
+};
+
+/** Loads a single member of a member access chain. */
+void BytecodeCompiler::member(AST * node){
+    switch (node->getKind()){
+        case IdentifierNode::kind:
+            this->emit(OP_LOAD_ATTR, code->addName(node->getNodeText()));
+            break;
+        case IndexNode::kind:
+        case MemberAccessNode::kind:
+        case LiteralIntNode::kind:
+            this->expression(node);
+            this->emit(OP_INDEX);
+            break;
+        default:
+            throw AttributeError("Invalid member load expression");
+    }
+};
+
+void BytecodeCompiler::arguments(AST * node){
+    for (int i=0; i<node->getChildCount(); i++){
+        this->expression(node->children[i]);
+    }
+};
+
+void BytecodeCompiler::methodCall(AST * node){
+    AST * firstId = node->children[0];
+    AST * params = node->children[1];
+
+    // member call, e.g. "a.b.foo()", receiver is loaded before arguments
+    if (firstId->getKind() == MemberAccessNode::kind){
+        AST * a = firstId->children[0];
+        AST * z = firstId->children[firstId->getChildCount() - 1];
+        this->load(a);
+        for (int i=1; i<firstId->getChildCount() - 1; i++){
+            this->member(firstId->children[i]);
+        }
+        this->arguments(params);
+
+        Opcode op = (a->getNodeText() == Literals::SUPER) ? OP_CALL_SUPER : OP_CALL_MEMBER;
+        this->emit(op, code->addName(z->getNodeText()), params->getChildCount());
+        return;
+    }
+
+    string method_id = firstId->getNodeText();
+    Symbol * sym = this->table->globals.resolve(method_id);
+    if (dynamic_cast<BuiltInMethodSymbol*>(sym) != nullptr){
+        this->arguments(params);
+        this->emit(OP_CALL_BUILT_IN, code->addName(method_id), params->getChildCount());
+        return;
+    }
+
+    // resolve the method now that Def/Ref have run
+    MethodSymbol * method_sym = nullptr;
+    if (firstId->scope != nullptr){
+        method_sym = dynamic_cast<MethodSymbol*>(firstId->scope->resolve(method_id));
+    }
+    if (method_sym == nullptr){
+        this->emit(OP_NAME_ERROR, code->addName(method_id));
+        return;
+    }
+
+    this->arguments(params);
+    this->emit(OP_CALL, code->addMethod(method_sym), params->getChildCount());
+};
+
+void BytecodeCompiler::classInstantiation(AST * node){
+    AST * lhs = node->children[0];
+    AST * params = node->children[1];
+
+    if (lhs->getKind() == IdentifierNode::kind){
+        this->load(lhs);
+        this->arguments(params);
+        this->emit(OP_NEW, code->addName(lhs->getNodeText()), params->getChildCount());
+    }
+    else if (lhs->getKind() == MemberAccessNode::kind){
+        AST * z = lhs->children[lhs->getChildCount() - 1];
+        this->load(lhs->children[0]);
+        for (int i=1; i<lhs->getChildCount() - 1; i++){
+            this->member(lhs->children[i]);
+        }
+        this->arguments(params);
+        this->emit(OP_NEW_FROM_MODULE, code->addName(z->getNodeText()), params->getChildCount());
+    }
+    else{
+        throw RuntimeError("cannot initiatize class for " + lhs->getType());
+    }
+};
+
+void BytecodeCompiler::returnStatement(AST * node){
+    if (node->getChildCount() == 0){
+        this->emit(OP_RETURN_NONE);
+        return;
+    }
+    this->expression(node->children[0]);
+    this->emit(OP_RETURN);
+};
+
+void BytecodeCompiler::ifStatement(AST * node){
+    vector<int> exits;
+    for (int i=0; i<node->getChildCount(); i++){
+        AST * ifCondBlockNode = node->children[i];
+
+        if (ifCondBlockNode->getChildCount() == 2){
+            // if or elseif (with condition and block)
+            this->expression(ifCondBlockNode->children[0]);
+            int next = this->emit(OP_JUMP_IF_FALSE);
+            this->statement(ifCondBlockNode->children[1]);
+            exits.push_back(this->emit(OP_JUMP));
+            this->patch(next, this->here());
+        }
+        else{
+            // else block (with no condition)
+            this->statement(ifCondBlockNode->children[0]);
+        }
+    }
+
+    for (int i=0; i<int(exits.size()); i++){
+        this->patch(exits[i], this->here());
+    }
+};
+
+void BytecodeCompiler::whileStatement(AST * node){
+    int start = this->here();
+    this->expression(node->children[0]);
+    int exit = this->emit(OP_JUMP_IF_FALSE);
+
+    this->beginLoop();
+    this->statement(node->children[1]);
+    this->emit(OP_JUMP, start);
+
+    this->patch(exit, this->here());
+    this->endLoop(this->here());
+};
+
+void BytecodeCompiler::forStatement(AST * node){
+    this->statement(node->children[0]);
+    int start = this->here();
+    this->expression(node->children[1]);
+    int exit = this->emit(OP_JUMP_IF_FALSE);
+
+    this->beginLoop();
+    this->statement(node->children[3]);
+    this->statement(node->children[2]);
+    this->emit(OP_JUMP, start);
+
+    this->patch(exit, this->here());
+    this->endLoop(this->here());
+};
+
+/**
+ * The iterator stays on the operand stack for the duration of the loop,
+ * so 'skip' lands on a POP that discards it.
+ */
+void BytecodeCompiler::eachStatement(AST * node){
+    AST * varDeclaration = node->children[0];
+    this->statement(varDeclaration);
+
+    this->expression(node->children[1]);
+    this->emit(OP_ITER_INIT);
+    int start = this->emit(OP_ITER_NEXT);
+    this->declareName(varDeclaration->children[0]);
+
+    this->beginLoop();
+    this->statement(node->children[2]);
+    this->emit(OP_JUMP, start);
+
+    int breakTarget = this->emit(OP_POP);
+    this->patch(start, this->here());
+    this->endLoop(breakTarget);
+};
+
+void BytecodeCompiler::tryStatement(AST * node){
+    int handler = this->emit(OP_SETUP_TRY);
+    this->tryDepth++;
+    this->statement(node->children[0]);
+    this->tryDepth--;
+    this->emit(OP_POP_TRY);
+    vector<int> exits;
+    exits.push_back(this->emit(OP_JUMP));
+
+    // catch blocks are selected at runtime by the interpreter's rules
+    this->patch(handler, this->here());
+    this->emit(OP_CATCH, code->addNode(node));
+    for (int i=1; i<node->getChildCount(); i++){
+        AST * catchItem = node->children[i];
+        AST * catchBlock = catchItem->children[catchItem->getChildCount() - 1];
+        code->blockTargets[catchBlock] = this->here();
+        this->statement(catchBlock);
+        exits.push_back(this->emit(OP_JUMP));
+    }
+
+    for (int i=0; i<int(exits.size()); i++){
+        this->patch(exits[i], this->here());
+    }
+};
+
+void BytecodeCompiler::raiseStatement(AST * node){
+    bool hasMessage = false;
+    if (node->getChildCount() == 2 && node->children[1]->getChildCount() == 1){
+        this->expression(node->children[1]->children[0]);
+        hasMessage = true;
+    }
+    this->emit(OP_RAISE, code->addNode(node), hasMessage);
+};
+
+void BytecodeCompiler::skipStatement(AST * node){
+    if (this->loopBreaks.size() == 0 ||
+        !(node->hasAncestor(WhileStatementNode::kind) || node->hasAncestor(ForStatementNode::kind))){
+        this->emit(OP_SKIP_ERROR);
+        return;
+    }
+
+    // leave any try blocks opened inside the loop
+    for (int i=this->loopTryDepth.back(); i<this->tryDepth; i++){
+        this->emit(OP_POP_TRY);
+    }
+    this->loopBreaks.back().push_back(this->emit(OP_JUMP));
+};
+
+void BytecodeCompiler::beginLoop(){
+    this->loopBreaks.push_back(vector<int>());
+    this->loopTryDepth.push_back(this->tryDepth);
+};
+
+void BytecodeCompiler::endLoop(int breakTarget){
+    vector<int> breaks = this->loopBreaks.back();
+    for (int i=0; i<int(breaks.size()); i++){
+        this->patch(breaks[i], breakTarget);
+    }
+    this->loopBreaks.pop_back();
+    this->loopTryDepth.pop_back();
+};
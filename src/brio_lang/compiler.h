@@ -0,0 +1,144 @@
+#ifndef BRIOLANG_SRC_COMPILER_H_
+#define BRIOLANG_SRC_COMPILER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <brio_lang/tree.h>
+#include <brio_lang/symbol.h>
+#include <brio_lang/object.h>
+
+using namespace std;
+
+
+// bytecode instructions executed by the VM, operands are a and b
+enum Opcode {
+    OP_LOAD_CONST = 0,          // push constants[a]
+    OP_LOAD_NAME,               // push value of identifier nodes[a]
+    OP_STORE_NAME,              // pop value, assign to identifier nodes[a]
+    OP_DECLARE_NAME,            // pop value, define names[a] in current space
+    OP_LOAD_LOCAL,              // push slot a of the method space, nodes[b] if unset
+    OP_STORE_LOCAL,             // pop value, assign to slot a, nodes[b] if unset
+    OP_DECLARE_LOCAL,           // pop value, define slot a of the method space
+    OP_LOAD_ATTR,               // pop instance, push member names[a]
+    OP_STORE_ATTR,              // pop instance and value, set member names[a]
+    OP_INDEX,                   // pop index and object, push object[index]
+    OP_STORE_INDEX,             // pop index, object and value, set object[index]
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE,                  // b holds line number for ZeroDivisionError
+    OP_MODULUS,
+    OP_EXPONENT,
+    OP_BIT_AND,
+    OP_BIT_OR,
+    OP_BIT_XOR,
+    OP_BIT_SHIFT_LEFT,
+    OP_BIT_SHIFT_RIGHT,
+    OP_BOOL_AND,
+    OP_BOOL_OR,
+    OP_BOOL_EQUALS,
+    OP_BOOL_NOT_EQUALS,
+    OP_BOOL_LESS_THAN,
+    OP_BOOL_LESS_THAN_OR_EQUAL,
+    OP_BOOL_GREATER_THAN,
+    OP_BOOL_GREATER_THAN_OR_EQUAL,
+    OP_BUILD_ARRAY,             // pop a elements, push Array
+    OP_BUILD_DICTIONARY,        // pop a key/value pairs, push Dictionary
+    OP_POP,
+    OP_SWAP,
+    OP_JUMP,                    // continue at a
+    OP_JUMP_IF_FALSE,           // pop condition, continue at a unless true
+    OP_CALL,                    // call methods[a] with b arguments
+    OP_CALL_MEMBER,             // call names[a] on receiver below b arguments
+    OP_CALL_SUPER,              // call names[a] on super class of receiver
+    OP_CALL_BUILT_IN,           // call built-in names[a] with b arguments
+    OP_NEW,                     // instantiate class below b arguments
+    OP_NEW_FROM_MODULE,         // instantiate class names[a] of imported module
+    OP_RETURN,
+    OP_RETURN_NONE,
+    OP_ITER_INIT,               // pop iterable, push iterator
+    OP_ITER_NEXT,               // push next element, or pop iterator and continue at a
+    OP_SETUP_TRY,               // register handler continuing at a
+    OP_POP_TRY,
+    OP_CATCH,                   // select catch block of try statement nodes[a]
+    OP_RAISE,                   // raise nodes[a], message on stack when b is set
+    OP_NAME_ERROR,              // unresolved method names[a]
+    OP_SKIP_ERROR,              // 'skip' outside of a loop
+    OP_COUNT
+};
+
+struct Instruction {
+    Opcode op;
+    int a;
+    int b;
+};
+
+class CodeObject {
+    public:
+        CodeObject(string code_name);
+        string getName();
+        int addConstant(Object * value);
+        int addNode(AST * node);
+        int addName(string name);
+        int addMethod(MethodSymbol * method);
+        vector<Instruction> code;
+        vector<Object *> constants;
+        vector<AST *> nodes;
+        vector<string> names;
+        vector<MethodSymbol *> methods;
+        map<AST *, int> blockTargets;
+    private:
+        string name;
+};
+
+class BytecodeCompiler {
+    public:
+        BytecodeCompiler(SymbolTable * table);
+        CodeObject * compileMethod(MethodSymbol * method);
+        CodeObject * compileNode(AST * node);
+        static bool isExpression(AST * node);
+    private:
+        int emit(Opcode op);
+        int emit(Opcode op, int a);
+        int emit(Opcode op, int a, int b);
+        int here();
+        void patch(int at, int target);
+        void block(AST * node);
+        void statement(AST * node);
+        void expression(AST * node);
+        void varDeclaration(AST * node);
+        void varAssignment(AST * node);
+        void compoundAssign(AST * node, Opcode op);
+        void methodCall(AST * node);
+        void classInstantiation(AST * node);
+        void binary(AST * node, Opcode op);
+        void load(AST * node);
+        void loadName(AST * node);
+        void storeName(AST * node);
+        void declareName(AST * node);
+        bool isLocal(AST * node);
+        void memberLoad(AST * node);
+        void memberStore(AST * node);
+        void member(AST * node);
+        void arguments(AST * node);
+        void returnStatement(AST * node);
+        void ifStatement(AST * node);
+        void whileStatement(AST * node);
+        void forStatement(AST * node);
+        void eachStatement(AST * node);
+        void tryStatement(AST * node);
+        void raiseStatement(AST * node);
+        void skipStatement(AST * node);
+        void beginLoop();
+        void endLoop(int breakTarget);
+        SymbolTable * table;
+        CodeObject * code;
+        vector<vector<int>> loopBreaks;
+        vector<int> loopTryDepth;
+        int tryDepth;
+        bool inMethod;
+};
+
+#endif  // BRIOLANG_SRC_COMPILER_H_
@@ -0,0 +1,274 @@
+///
+/// Brio Lang
+/// csv.cc
+///
+/// Native CSV reader and writer
+///
+
+#include <brio_lang/csv.h>
+#include <brio_lang/exceptions.h>
+
+#include <cstring>
+
+
+/// ##################################################################
+/// CsvReader definition
+/// ##################################################################
+
+CsvReader::CsvReader(Object * source, char delimiter_char) : input(source, "csvReader"){
+    if (delimiter_char == '"' || delimiter_char == '\n' || delimiter_char == '\r'){
+        throw ValueError("CSV delimiter cannot be a quote or a line break");
+    }
+    delimiter = delimiter_char;
+    pos = 0;
+    row = 1;
+    done = false;
+};
+
+void CsvReader::error(string message){
+    this->done = true;
+    throw ValueError("invalid CSV, " + message + " on row " + std::to_string(this->row));
+};
+
+/** Returns the next row, or nullptr at the end of the input. */
+Object * CsvReader::next(){
+    if (this->done) return nullptr;
+
+    // drop the rows already returned, once they are at least a chunk
+    if (this->pos >= ChunkedInput::CHUNK_SIZE){
+        this->input.discard(this->pos);
+        this->pos = 0;
+    }
+
+    if (this->pos >= this->input.size() && !this->input.fill()){
+        this->done = true;
+        return nullptr;
+    }
+
+    Array * fields = new Array();
+    while (true){
+        bool isQuoted = this->pos < this->input.size() && this->input.data()[this->pos] == '"';
+        fields->value.push_back(isQuoted ? this->quoted() : this->unquoted());
+
+        // what ends the field: a delimiter, a line break or the input
+        if (this->pos >= this->input.size() && !this->input.fill()){
+            this->done = true;
+            break;
+        }
+        char c = this->input.data()[this->pos++];
+        if (c == this->delimiter) continue;
+        if (c == '\r'){
+            if ((this->pos < this->input.size() || this->input.fill()) && this->input.data()[this->pos] == '\n'){
+                this->pos++;
+            }
+            break;
+        }
+        if (c == '\n') break;
+
+        this->pos--;
+        this->error("unexpected '" + string(1, c) + "' after a quoted field");
+    }
+
+    this->row++;
+    return fields;
+};
+
+/**
+ * Reads a field up to the next delimiter or line break. Both are found
+ * with memchr, the line break only up to the delimiter, so each byte of
+ * a plain row is looked at about twice.
+ */
+String * CsvReader::unquoted(){
+    size_t scanned = this->pos;
+    size_t end;
+    while (true){
+        const char * data = this->input.data();
+        size_t size = this->input.size();
+
+        const char * found = (const char *) memchr(data + scanned, this->delimiter, size - scanned);
+        size_t limit = found != nullptr ? size_t(found - data) : size;
+        const char * newline = (const char *) memchr(data + scanned, '\n', limit - scanned);
+        if (newline != nullptr){
+            end = size_t(newline - data);
+            break;
+        }
+        if (found != nullptr){
+            end = limit;
+            break;
+        }
+
+        scanned = size;
+        if (!this->input.fill()){
+            end = size;
+            break;
+        }
+    }
+
+    // leave the CR of a CRLF for next() to consume
+    const char * data = this->input.data();
+    if (end > this->pos && data[end - 1] == '\r' && (end == this->input.size() || data[end] == '\n')){
+        end--;
+    }
+
+    String * field = new String(string(data + this->pos, end - this->pos));
+    this->pos = end;
+    return field;
+};
+
+/** Reads a quoted field, where a doubled quote stands for one quote. */
+String * CsvReader::quoted(){
+    this->pos++;
+
+    String * field = new String();
+    string & out = field->value;
+    while (true){
+        if (this->pos >= this->input.size() && !this->input.fill()){
+            this->error("unterminated quoted field");
+        }
+
+        const char * data = this->input.data();
+        size_t size = this->input.size();
+        const char * quote = (const char *) memchr(data + this->pos, '"', size - this->pos);
+        if (quote == nullptr){
+            out.append(data + this->pos, size - this->pos);
+            this->pos = size;
+            continue;
+        }
+
+        size_t at = size_t(quote - data);
+        out.append(data + this->pos, at - this->pos);
+        this->pos = at + 1;
+
+        if ((this->pos < this->input.size() || this->input.fill()) && this->input.data()[this->pos] == '"'){
+            out.push_back('"');
+            this->pos++;
+            continue;
+        }
+        return field;
+    }
+};
+
+Object * CsvReader::builtIn(string method_id, Array * params){
+    if (method_id == "next"){
+        Object * result = this->next();
+        if (result == nullptr) return None::get();
+        return result;
+    }
+    throw ValueError("method '" + method_id + "' not found in " + this->getType());
+};
+
+Object * CsvReader::builtIn(string attribute){
+    throw ValueError(this->getType() + " has no member '" + attribute + "'");
+};
+
+string CsvReader::toString(){
+    return "<CsvReader>";
+};
+
+void CsvReader::trace(Heap * heap){
+    this->input.trace(heap);
+};
+
+
+/// ##################################################################
+/// CsvWriter definition
+/// ##################################################################
+
+CsvWriter::CsvWriter(File * target, char delimiter_char){
+    if (delimiter_char == '"' || delimiter_char == '\n' || delimiter_char == '\r'){
+        throw ValueError("CSV delimiter cannot be a quote or a line break");
+    }
+    file = target;
+    delimiter = delimiter_char;
+};
+
+void CsvWriter::writerow(Object * row){
+    this->line.clear();
+    this->format(row);
+    this->file->writeRaw(this->line.data(), this->line.size());
+};
+
+/** Formats every row first, so the batch reaches the file in one call. */
+void CsvWriter::writerows(Object * rows){
+    Array * arr = dynamic_cast<Array*>(rows);
+    if (arr == nullptr){
+        throw TypeError("'writerows' expects an Array of rows, not " + rows->getType());
+    }
+
+    this->line.clear();
+    for (int i=0; i<arr->value.size(); i++){
+        this->format(arr->value[i]);
+    }
+    this->file->writeRaw(this->line.data(), this->line.size());
+};
+
+void CsvWriter::format(Object * row){
+    Array * fields = dynamic_cast<Array*>(row);
+    if (fields == nullptr){
+        throw TypeError("CSV row must be an Array, not " + row->getType());
+    }
+
+    for (int i=0; i<fields->value.size(); i++){
+        if (i > 0) this->line.push_back(this->delimiter);
+
+        Object * value = fields->value[i];
+        if (dynamic_cast<String*>(value) != nullptr){
+            this->field(static_cast<String*>(value)->value);
+        }else if (dynamic_cast<None*>(value) == nullptr){
+            this->field(value->toString());
+        }
+    }
+    this->line.push_back('\n');
+};
+
+void CsvWriter::field(const string & value){
+    char special[] = {this->delimiter, '"', '\n', '\r', '\0'};
+    if (value.find_first_of(special) == string::npos){
+        this->line.append(value);
+        return;
+    }
+
+    // quote the field and double the quotes inside it
+    this->line.push_back('"');
+    size_t start = 0;
+    size_t quote;
+    while ((quote = value.find('"', start)) != string::npos){
+        this->line.append(value, start, quote + 1 - start);
+        this->line.push_back('"');
+        start = quote + 1;
+    }
+    this->line.append(value, start, string::npos);
+    this->line.push_back('"');
+};
+
+Object * CsvWriter::builtIn(string method_id, Array * params){
+    if (method_id == "writerow" || method_id == "writerows"){
+        if (params->value.size() != 1){
+            throw TypeError("'" + method_id + "' takes exactly 1 argument");
+        }
+        if (method_id == "writerow"){
+            this->writerow(params->value[0]);
+        }else{
+            this->writerows(params->value[0]);
+        }
+    }
+    else if (method_id == "flush"){
+        this->file->flush();
+    }
+    else{
+        throw ValueError("method '" + method_id + "' not found in " + this->getType());
+    }
+    return nullptr;
+};
+
+Object * CsvWriter::builtIn(string attribute){
+    throw ValueError(this->getType() + " has no member '" + attribute + "'");
+};
+
+string CsvWriter::toString(){
+    return "<CsvWriter>";
+};
+
+void CsvWriter::trace(Heap * heap){
+    heap->mark(this->file);
+};
@@ -0,0 +1,61 @@
+#ifndef BRIOLANG_SRC_CSV_H_
+#define BRIOLANG_SRC_CSV_H_
+
+#include <string>
+#include <cstddef>
+
+#include <brio_lang/object.h>
+
+using namespace std;
+
+
+/**
+ * Reads CSV rows from a File or String one at a time, as Arrays of
+ * Strings. Fields may be quoted as in RFC 4180: a quoted field can hold
+ * the delimiter, line breaks and doubled quotes. Rows end with LF or CRLF.
+ */
+class CsvReader : public Iterator {
+    public:
+        CsvReader(Object * source, char delimiter);
+        string getType(){return "CsvReader";};
+        Object * next();
+        Iterator * iter(){return this;};
+        Object * builtIn(string method_id, Array * params);
+        Object * builtIn(string attribute);
+        string toString();
+        void trace(Heap * heap);
+    private:
+        String * quoted();
+        String * unquoted();
+        void error(string message);
+        ChunkedInput input;
+        char delimiter;
+        size_t pos;
+        size_t row;  // of the next row, for errors
+        bool done;
+};
+
+/**
+ * Writes rows of values to a File as CSV. Each row is formatted into one
+ * block and written in a single call; the File buffers the blocks. Fields
+ * are quoted only when they hold the delimiter, a quote or a line break.
+ */
+class CsvWriter : public Object {
+    public:
+        CsvWriter(File * file, char delimiter);
+        string getType(){return "CsvWriter";};
+        void writerow(Object * row);
+        void writerows(Object * rows);
+        Object * builtIn(string method_id, Array * params);
+        Object * builtIn(string attribute);
+        string toString();
+        void trace(Heap * heap);
+    private:
+        void format(Object * row);
+        void field(const string & value);
+        File * file;
+        char delimiter;
+        string line;  // formatted rows, reused between calls
+};
+
+#endif  // BRIOLANG_SRC_CSV_H_
@@ -16,24 +16,24 @@ Def::Def(SymbolTable * sym_table){
 
 void Def::downUp(AST * node){
     // pre-order actions
-    if (node->getType() == MethodDeclarationNode::type){
+    if (node->getKind() == MethodDeclarationNode::kind){
         this->enterMethod(node);
-    } else if (node->getType() == ImportNode::type){
+    } else if (node->getKind() == ImportNode::kind){
         this->importStatement(node);
-    } else if (node->getType() == ImportedModuleNode::type){
+    } else if (node->getKind() == ImportedModuleNode::kind){
         this->enterImportedModule(node);
-    } else if (node->getType() == VarDeclarationNode::type){
+    } else if (node->getKind() == VarDeclarationNode::kind){
         this->varDeclaration(node);
-    } else if (node->getType() == IdentifierNode::type){
+    } else if (node->getKind() == IdentifierNode::kind){
         this->identifier(node);
-    } else if (node->getType() == ClassDeclarationNode::type){
+    } else if (node->getKind() == ClassDeclarationNode::kind){
         this->enterClass(node);
-    } else if (node->getType() == BlockNode::type 
-                && node->parent->getType() != ClassDeclarationNode::type
-                && node->parent->getType() != MethodDeclarationNode::type
-                && node->parent->getType() != ImportedModuleNode::type
-                && node->parent->getType() != ImportNode::type
-                && node->parent->getType() != FromImportNode::type){
+    } else if (node->getKind() == BlockNode::kind 
+                && node->parent->getKind() != ClassDeclarationNode::kind
+                && node->parent->getKind() != MethodDeclarationNode::kind
+                && node->parent->getKind() != ImportedModuleNode::kind
+                && node->parent->getKind() != ImportNode::kind
+                && node->parent->getKind() != FromImportNode::kind){
         this->enterBlock(node);
     }
 
@@ -44,18 +44,18 @@ void Def::downUp(AST * node){
     }
 
     // post-order actions
-    if (node->getType() == MethodDeclarationNode::type){
+    if (node->getKind() == MethodDeclarationNode::kind){
         this->exitMethod();
-    } else if (node->getType() == ClassDeclarationNode::type){
+    } else if (node->getKind() == ClassDeclarationNode::kind){
         this->exitClass();
-    } else if (node->getType() == ImportedModuleNode::type){
+    } else if (node->getKind() == ImportedModuleNode::kind){
         this->exitImportedModule();
-    } else if (node->getType() == BlockNode::type 
-                && node->parent->getType() != ClassDeclarationNode::type
-                && node->parent->getType() != MethodDeclarationNode::type
-                && node->parent->getType() != ImportedModuleNode::type
-                && node->parent->getType() != ImportNode::type
-                && node->parent->getType() != FromImportNode::type){
+    } else if (node->getKind() == BlockNode::kind 
+                && node->parent->getKind() != ClassDeclarationNode::kind
+                && node->parent->getKind() != MethodDeclarationNode::kind
+                && node->parent->getKind() != ImportedModuleNode::kind
+                && node->parent->getKind() != ImportNode::kind
+                && node->parent->getKind() != FromImportNode::kind){
         this->exitBlock();
     }
 };
@@ -72,10 +72,10 @@ void Def::importStatement(AST * node){
     // define temporary symbol for import
     AST * id = node->children[0];
     string node_id;
-    if (id->getType() == IdentifierNode::type){
+    if (id->getKind() == IdentifierNode::kind){
         node_id = id->getNodeText();
     }
-    else if (id->getType() == MemberAccessNode::type){
+    else if (id->getKind() == MemberAccessNode::kind){
         node_id = id->children[size(id->children)-1]->getNodeText();
     }else{
         throw RuntimeError("unable to define import statement");
@@ -114,11 +114,17 @@ void Def::enterMethod(AST * node){
     currentScope->define(s);
     currentScope = s;
 
+    // reserve slots for 'this' and 'super' in class methods
+    if (SymbolTable::getEnclosingClass(s) != nullptr){
+        s->defineSlot(Literals::THIS);
+        s->defineSlot(Literals::SUPER);
+    }
+
     // define arguments
     AST * params = node->children[2];
     for (int i=0; i<params->children.size(); i++){
         AST * param = params->children[i];
-        if (param->getType() == IdentifierNode::type){
+        if (param->getKind() == IdentifierNode::kind){
 
             // define variable symbol for arguments
             VariableSymbol * var_sym = new VariableSymbol(param->getNodeText());
@@ -126,6 +132,7 @@ void Def::enterMethod(AST * node){
             param->symbol = var_sym;
             param->scope = currentScope;
             currentScope->define(var_sym);
+            s->defineSlot(param->getNodeText());
         }else{
             throw ValueError("method param list must be ids", param->getLineNo());
         }
@@ -162,13 +169,14 @@ void Def::exitClass(){
 void Def::identifier(AST * id){
     id->scope = currentScope;
 
-    if(id->hasAncestor(AsNode::type) && id->getNodeText() == id->parent->children[id->parent->children.size()-1]->getNodeText()){
+    if(id->hasAncestor(AsNode::kind) && id->getNodeText() == id->parent->children[id->parent->children.size()-1]->getNodeText()){
         string node_id = id->getNodeText();
         VariableSymbol * s = new VariableSymbol(node_id);
         s->def_node = id;  // point symbol to AST
         id->symbol = s;  // point AST to symbol
         id->scope = currentScope;  // point AST to scope
         currentScope->define(s);
+        this->defineSlot(node_id);
     }
 };
 
@@ -182,4 +190,13 @@ void Def::varDeclaration(AST * node){
     id->symbol = s;  // point AST to symbol
     id->scope = currentScope;  // point AST to scope
     currentScope->define(s);
+    this->defineSlot(node_id);
+};
+
+/** Reserves a slot for a local variable of the enclosing method, if any. */
+void Def::defineSlot(string id){
+    MethodSymbol * method = SymbolTable::getEnclosingMethod(currentScope);
+    if (method != nullptr){
+        method->defineSlot(id);
+    }
 };
\ No newline at end of file
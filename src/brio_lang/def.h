@@ -20,6 +20,7 @@ class Def {
         void exitImportedModule();
         void varDeclaration(AST * node);
         void identifier(AST * node);
+        void defineSlot(string id);
     private:
         SymbolTable * table;
         Scope * currentScope;
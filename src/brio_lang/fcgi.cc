@@ -3,6 +3,8 @@
 #include <brio_lang/fcgi.h>
 #include <brio_lang/util.h>
 #include <brio_lang/exceptions.h>
+#include <brio_lang/heap.h>
+#include <brio_lang/output.h>
 
 
 long STDIN_MAX = 100000000;
@@ -36,35 +38,33 @@ string FastCGI::getRequestContent(const FCGX_Request & request) {
         content_length = 0;
     }
     
-    char * content_buffer = new char[content_length];
-    cin.read(content_buffer, content_length);
-    content_length = cin.gcount();
-
-    string content(content_buffer, content_length);
-    delete [] content_buffer;
+    // read straight into the string rather than through a temporary buffer
+    string content(content_length, '\0');
+    cin.read(&content[0], content_length);
+    content.resize(cin.gcount());
     return content;
 }
 
 Dictionary* FastCGI::buildEnvDictionary(const FCGX_Request & request){
     Dictionary* envDict = new Dictionary();
-    envDict->value[new String("GATEWAY_INTERFACE")] = new String(FCGX_GetParam("GATEWAY_INTERFACE", request.envp));
-    envDict->value[new String("SERVER_SOFTWARE")] = new String(FCGX_GetParam("SERVER_SOFTWARE", request.envp));
-    envDict->value[new String("QUERY_STRING")] = new String(FCGX_GetParam("QUERY_STRING", request.envp));
-    envDict->value[new String("REQUEST_METHOD")] = new String(FCGX_GetParam("REQUEST_METHOD", request.envp));
-    envDict->value[new String("REQUEST_BODY")] = new String(this->getRequestContent(request));
-    envDict->value[new String("CONTENT_TYPE")] = new String(FCGX_GetParam("CONTENT_TYPE", request.envp));
-    envDict->value[new String("CONTENT_LENGTH")] = new String(FCGX_GetParam("CONTENT_LENGTH", request.envp));
-    envDict->value[new String("SCRIPT_FILENAME")] = new String(FCGX_GetParam("SCRIPT_FILENAME", request.envp));
-    envDict->value[new String("SCRIPT_NAME")] = new String(FCGX_GetParam("SCRIPT_NAME", request.envp));
-    envDict->value[new String("REQUEST_URI")] = new String(FCGX_GetParam("REQUEST_URI", request.envp));
-    envDict->value[new String("DOCUMENT_URI")] = new String(FCGX_GetParam("DOCUMENT_URI", request.envp));
-    envDict->value[new String("DOCUMENT_ROOT")] = new String(FCGX_GetParam("DOCUMENT_ROOT", request.envp));
-    envDict->value[new String("SERVER_PROTOCOL")] = new String(FCGX_GetParam("SERVER_PROTOCOL", request.envp));
-    envDict->value[new String("REMOTE_ADDR")] = new String(FCGX_GetParam("REMOTE_ADDR", request.envp));
-    envDict->value[new String("REMOTE_PORT")] = new String(FCGX_GetParam("REMOTE_PORT", request.envp));
-    envDict->value[new String("SERVER_ADDR")] = new String(FCGX_GetParam("SERVER_ADDR", request.envp));
-    envDict->value[new String("SERVER_PORT")] = new String(FCGX_GetParam("SERVER_PORT", request.envp));
-    envDict->value[new String("SERVER_NAME")] = new String(FCGX_GetParam("SERVER_NAME", request.envp));
+    envDict->value.put(new String("GATEWAY_INTERFACE"), new String(FCGX_GetParam("GATEWAY_INTERFACE", request.envp)));
+    envDict->value.put(new String("SERVER_SOFTWARE"), new String(FCGX_GetParam("SERVER_SOFTWARE", request.envp)));
+    envDict->value.put(new String("QUERY_STRING"), new String(FCGX_GetParam("QUERY_STRING", request.envp)));
+    envDict->value.put(new String("REQUEST_METHOD"), new String(FCGX_GetParam("REQUEST_METHOD", request.envp)));
+    envDict->value.put(new String("REQUEST_BODY"), new String(this->getRequestContent(request)));
+    envDict->value.put(new String("CONTENT_TYPE"), new String(FCGX_GetParam("CONTENT_TYPE", request.envp)));
+    envDict->value.put(new String("CONTENT_LENGTH"), new String(FCGX_GetParam("CONTENT_LENGTH", request.envp)));
+    envDict->value.put(new String("SCRIPT_FILENAME"), new String(FCGX_GetParam("SCRIPT_FILENAME", request.envp)));
+    envDict->value.put(new String("SCRIPT_NAME"), new String(FCGX_GetParam("SCRIPT_NAME", request.envp)));
+    envDict->value.put(new String("REQUEST_URI"), new String(FCGX_GetParam("REQUEST_URI", request.envp)));
+    envDict->value.put(new String("DOCUMENT_URI"), new String(FCGX_GetParam("DOCUMENT_URI", request.envp)));
+    envDict->value.put(new String("DOCUMENT_ROOT"), new String(FCGX_GetParam("DOCUMENT_ROOT", request.envp)));
+    envDict->value.put(new String("SERVER_PROTOCOL"), new String(FCGX_GetParam("SERVER_PROTOCOL", request.envp)));
+    envDict->value.put(new String("REMOTE_ADDR"), new String(FCGX_GetParam("REMOTE_ADDR", request.envp)));
+    envDict->value.put(new String("REMOTE_PORT"), new String(FCGX_GetParam("REMOTE_PORT", request.envp)));
+    envDict->value.put(new String("SERVER_ADDR"), new String(FCGX_GetParam("SERVER_ADDR", request.envp)));
+    envDict->value.put(new String("SERVER_PORT"), new String(FCGX_GetParam("SERVER_PORT", request.envp)));
+    envDict->value.put(new String("SERVER_NAME"), new String(FCGX_GetParam("SERVER_NAME", request.envp)));
     return envDict;
 };
 
@@ -90,6 +90,10 @@ int FastCGI::startLoop() {
         // redirect stdin
         cin.rdbuf(&cin_fcgi_streambuf);
 
+        // everything the request allocates comes from its own arena
+        Heap & heap = Heap::instance();
+        heap.openArena();
+
         // extract env parameters
         Dictionary * envDict = this->buildEnvDictionary(request);
 
@@ -97,13 +101,22 @@ int FastCGI::startLoop() {
         vector<Object*> mainParams;
         mainParams.push_back(envDict);
         Object * output = this->interpreter->main(mainParams);
+        Output::instance().flush();
 
         // redirect stdio streambufs
         cout.rdbuf(&cout_fcgi_streambuf);
         cerr.rdbuf(&cerr_fcgi_streambuf);
 
-        // write output
-        cout << Util::escape_raw_string(output->toString());
+        // write output, decoding escapes as the value is serialized
+        {
+            EscapeRawStringBuffer decoded(cout);
+            ostream response(&decoded);
+            output->writeTo(response);
+        }
+
+        // free the request, keeping only what the script stored in globals
+        heap.closeArena();
+        this->interpreter->collectGarbage();
 
         // restore stdio streambufs
         cin.rdbuf(cin_streambuf);
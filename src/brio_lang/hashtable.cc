@@ -0,0 +1,150 @@
+///
+/// Brio Lang
+/// hashtable.cc
+///
+/// Insertion ordered hash table for Dictionary
+///
+
+#include <brio_lang/hashtable.h>
+#include <brio_lang/object.h>
+
+
+HashTable::HashTable(){
+    count = 0;
+    used = 0;
+    shift = 64;
+};
+
+/**
+ * Spreads the key hash over the index with a Fibonacci hash. The slot is
+ * taken from the high bits of the product, which depend on every bit of
+ * the hash, so integer keys that differ only in their high bits (strided
+ * keys, since integers hash to themselves) still land apart.
+ */
+size_t HashTable::slotFor(size_t hash){
+    return size_t((uint64_t(hash) * 0x9E3779B97F4A7C15ULL) >> shift);
+};
+
+/** Returns the index slot that refers to an equal key, or -1. */
+int HashTable::lookup(Object * key, size_t hash){
+    if (count == 0) return -1;
+
+    size_t mask = indices.size() - 1;
+    for (size_t i = this->slotFor(hash); ; i = (i + 1) & mask){
+        int position = indices[i];
+        if (position == EMPTY) return -1;
+        if (position == DUMMY) continue;
+
+        Entry & entry = entries[position];
+        if (entry.hash == hash && entry.key->keyEquals(key)){
+            return int(i);
+        }
+    }
+};
+
+/** Returns the entry for an equal key, or nullptr if there is none. */
+HashTable::Entry * HashTable::find(Object * key){
+    int slot = this->lookup(key, key->hash());
+    if (slot < 0) return nullptr;
+    return &entries[indices[slot]];
+};
+
+/** Returns the value stored under key, or nullptr if there is none. */
+Object * HashTable::get(Object * key){
+    Entry * entry = this->find(key);
+    if (entry == nullptr) return nullptr;
+    return entry->value;
+};
+
+/**
+ * Stores value under key. An existing equal key keeps its key object and
+ * its place in the order; a new key is appended.
+ */
+void HashTable::put(Object * key, Object * value){
+    size_t hash = key->hash();
+    int slot = this->lookup(key, hash);
+    if (slot >= 0){
+        entries[indices[slot]].value = value;
+        return;
+    }
+
+    // keep at most two thirds of the index in use, removed entries included
+    if ((used + 1) * 3 > indices.size() * 2){
+        size_t capacity = MIN_CAPACITY;
+        while ((count + 1) * 3 > capacity) capacity *= 2;
+        this->resize(capacity);
+    }
+
+    size_t mask = indices.size() - 1;
+    size_t i = this->slotFor(hash);
+    while (indices[i] >= 0){
+        i = (i + 1) & mask;
+    }
+    if (indices[i] == EMPTY) used++;
+    indices[i] = int(entries.size());
+    entries.push_back(Entry{key, value, hash});
+    count++;
+};
+
+/** Removes the entry for key; returns false if there was none. */
+bool HashTable::remove(Object * key){
+    int slot = this->lookup(key, key->hash());
+    if (slot < 0) return false;
+
+    Entry & entry = entries[indices[slot]];
+    entry.key = nullptr;
+    entry.value = nullptr;
+    indices[slot] = DUMMY;
+    count--;
+    return true;
+};
+
+/** Drops removed entries and rebuilds an index of the given capacity. */
+void HashTable::resize(size_t capacity){
+    size_t live = 0;
+    for (size_t j = 0; j < entries.size(); j++){
+        if (entries[j].key != nullptr) entries[live++] = entries[j];
+    }
+    entries.resize(live);
+
+    indices.assign(capacity, EMPTY);
+    shift = 64;
+    for (size_t bits = capacity; bits > 1; bits >>= 1) shift--;
+    size_t mask = capacity - 1;
+    for (size_t j = 0; j < entries.size(); j++){
+        size_t i = this->slotFor(entries[j].hash);
+        while (indices[i] != EMPTY){
+            i = (i + 1) & mask;
+        }
+        indices[i] = int(j);
+    }
+    used = live;
+};
+
+HashTable::iterator HashTable::begin(){
+    Entry * first = entries.data();
+    return iterator(first, first + entries.size());
+};
+
+HashTable::iterator HashTable::end(){
+    Entry * last = entries.data() + entries.size();
+    return iterator(last, last);
+};
+
+HashTable::iterator::iterator(Entry * entry, Entry * end){
+    this->entry = entry;
+    this->end = end;
+    this->skipRemoved();
+};
+
+HashTable::iterator & HashTable::iterator::operator++(){
+    entry++;
+    this->skipRemoved();
+    return *this;
+};
+
+void HashTable::iterator::skipRemoved(){
+    while (entry != end && entry->key == nullptr){
+        entry++;
+    }
+};
@@ -0,0 +1,67 @@
+#ifndef BRIOLANG_SRC_HASHTABLE_H_
+#define BRIOLANG_SRC_HASHTABLE_H_
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+
+class Object;  // forward reference: object.h
+
+/**
+ * Hash table from Object keys to Object values, used by Dictionary. Keys
+ * are compared with Object::hash and Object::keyEquals, so equal strings
+ * or numbers find the same entry in constant time.
+ *
+ * Entries are kept densely in insertion order; a sparse open addressing
+ * index maps hashes to entry positions. Iteration is a linear scan in the
+ * order the keys were first added.
+ */
+class HashTable {
+    public:
+        struct Entry {
+            Object * key;  // nullptr once removed
+            Object * value;
+            size_t hash;
+        };
+
+        /** Visits the entries that have not been removed, in insertion order. */
+        class iterator {
+            public:
+                iterator(Entry * entry, Entry * end);
+                Entry & operator*(){ return *entry; };
+                Entry * operator->(){ return entry; };
+                iterator & operator++();
+                bool operator!=(const iterator & other){ return entry != other.entry; };
+                bool operator==(const iterator & other){ return entry == other.entry; };
+            private:
+                void skipRemoved();
+                Entry * entry;
+                Entry * end;
+        };
+
+        HashTable();
+        Entry * find(Object * key);
+        Object * get(Object * key);
+        void put(Object * key, Object * value);
+        bool remove(Object * key);
+        size_t size(){ return count; };
+        iterator begin();
+        iterator end();
+        inline static const size_t MIN_CAPACITY = 8;
+        inline static const int EMPTY = -1;  // index slot never used
+        inline static const int DUMMY = -2;  // index slot of a removed entry
+    private:
+        size_t slotFor(size_t hash);
+        int lookup(Object * key, size_t hash);
+        void resize(size_t capacity);
+        vector<Entry> entries;  // insertion order, removed entries until the next resize
+        vector<int> indices;  // entry position per slot, or EMPTY/DUMMY
+        size_t count;  // live entries
+        size_t used;  // index slots that are not EMPTY
+        int shift;  // 64 minus log2 of the index capacity
+};
+
+#endif  // BRIOLANG_SRC_HASHTABLE_H_
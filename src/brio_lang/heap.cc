@@ -0,0 +1,304 @@
+///
+/// Brio Lang
+/// heap.cc
+///
+/// Mark and Sweep Garbage Collector
+///
+
+#include <brio_lang/heap.h>
+#include <brio_lang/object.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+
+
+/** Returns the process wide heap, which is never destroyed. */
+Heap & Heap::instance(){
+    static Heap * heap = new Heap();
+    return *heap;
+};
+
+Heap::Heap(){
+    current = nullptr;
+    arenaOpen = false;
+    threshold = INITIAL_THRESHOLD;
+    minThreshold = INITIAL_THRESHOLD;
+    nurserySize = NURSERY_SIZE;
+    growthFactor = GROWTH_FACTOR;
+    collections = 0;
+    minorCollections = 0;
+    freed = 0;
+    allocated = 0;
+    peak = 0;
+    pauseMs = 0;
+};
+
+/**
+ * Memory for Object::operator new. Small objects are carved out of the
+ * current chunk by bumping its offset; a chunk is reused once every
+ * object in it has been freed.
+ */
+void * Heap::allocate(size_t size){
+    size_t needed = (sizeof(AllocationHeader) + size + 15) & ~size_t(15);
+    AllocationHeader * header;
+
+    if (needed > LARGE_OBJECT){
+        header = static_cast<AllocationHeader*>(::operator new(needed));
+        header->chunk = nullptr;
+    }else{
+        if (current == nullptr || current->top + needed > CHUNK_SIZE){
+            current = this->freshChunk();
+        }
+        header = reinterpret_cast<AllocationHeader*>(current->memory + current->top);
+        header->chunk = current;
+        current->top += needed;
+        current->live++;
+    }
+    header->size = size;
+
+    void * memory = header + 1;
+    this->allocating(memory, size);
+    return memory;
+};
+
+/** Returns memory from Object::operator delete to its chunk. */
+void Heap::deallocate(void * memory){
+    this->released(memory);
+    AllocationHeader * header = static_cast<AllocationHeader*>(memory) - 1;
+    Chunk * chunk = header->chunk;
+    if (chunk == nullptr){
+        ::operator delete(header);
+        return;
+    }
+
+    chunk->live--;
+    if (chunk->live > 0) return;
+    chunk->top = 0;
+    if (chunk == current) return;
+
+    if (freeChunks.size() < FREE_CHUNKS){
+        freeChunks.push_back(chunk);
+    }else{
+        ::operator delete(chunk->memory);
+        delete chunk;
+    }
+};
+
+Chunk * Heap::freshChunk(){
+    if (!freeChunks.empty()){
+        Chunk * chunk = freeChunks.back();
+        freeChunks.pop_back();
+        return chunk;
+    }
+    Chunk * chunk = new Chunk();
+    chunk->memory = static_cast<char*>(::operator new(CHUNK_SIZE));
+    chunk->top = 0;
+    chunk->live = 0;
+    return chunk;
+};
+
+/**
+ * Records memory returned by Object::operator new, so the Object
+ * constructor can tell heap objects from locals and thrown exceptions.
+ */
+void Heap::allocating(void * memory, size_t size){
+    Allocation allocation;
+    allocation.start = static_cast<char*>(memory);
+    allocation.size = size;
+    pending.push_back(allocation);
+};
+
+/** Forgets an allocation whose constructor threw before it was tracked. */
+void Heap::released(void * memory){
+    for (int i = int(pending.size()) - 1; i >= 0; i--){
+        if (pending[i].start == memory){
+            pending.erase(pending.begin() + i);
+            return;
+        }
+    }
+};
+
+/**
+ * Called from the Object constructor. Arguments of a new-expression may
+ * allocate themselves, so the matching allocation is searched newest first.
+ */
+void Heap::track(Object * obj){
+    char * address = reinterpret_cast<char*>(obj);
+    for (int i = int(pending.size()) - 1; i >= 0; i--){
+        Allocation allocation = pending[i];
+        if (address >= allocation.start && address < allocation.start + allocation.size){
+            pending.erase(pending.begin() + i);
+            obj->young = true;
+            nursery.push_back(obj);
+            allocated++;
+            if (this->getLiveCount() > peak) peak = this->getLiveCount();
+            return;
+        }
+    }
+};
+
+/**
+ * Excludes an object from collection for the rest of the run, e.g. shared
+ * constants. Pinned objects stay marked, so they must not refer to others.
+ */
+void Heap::pin(Object * obj){
+    if (obj->marked) return;
+    vector<Object *> * generations[] = {&nursery, &arena, &objects};
+    for (vector<Object *> * generation : generations){
+        vector<Object *>::iterator it = find(generation->begin(), generation->end(), obj);
+        if (it != generation->end()){
+            generation->erase(it);
+            break;
+        }
+    }
+    obj->young = false;
+    obj->old = false;
+    obj->marked = true;
+};
+
+/**
+ * Old objects are only traced by a major collection. Tagged integers are
+ * not objects and need no marking.
+ */
+void Heap::mark(Object * obj){
+    if (obj == nullptr || SmallInteger::isTagged(obj) || obj->marked) return;
+    if (!obj->young && !this->majorDue()) return;
+    obj->marked = true;
+    gray.push_back(obj);
+};
+
+/**
+ * Called after a reference to value is stored in owner. An old owner that
+ * now refers to a young object is traced by the next minor collection.
+ */
+void Heap::writeBarrier(Object * owner, Object * value){
+    if (value == nullptr || !value->young) return;
+    if (!owner->old || owner->remembered) return;
+    owner->remembered = true;
+    remembered.push_back(owner);
+};
+
+/**
+ * Starts a request arena, e.g. for a FastCGI request. Objects allocated
+ * from now on stay young until the arena is closed.
+ */
+void Heap::openArena(){
+    arenaOpen = true;
+};
+
+/**
+ * Ends the request arena. The next collection frees every object of the
+ * request that the roots no longer reach; objects stored into globals, or
+ * into old objects through the write barrier, are promoted.
+ */
+void Heap::closeArena(){
+    arenaOpen = false;
+};
+
+/**
+ * Traces everything reachable from the marked roots, then deletes the
+ * objects that were not reached and promotes the young survivors. The
+ * next major collection is scheduled once the old objects have grown by
+ * the growth factor.
+ */
+void Heap::collect(){
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool major = this->majorDue();
+
+    if (!major){
+        for (size_t i = 0; i < remembered.size(); i++){
+            remembered[i]->trace(this);
+        }
+    }
+    while (!gray.empty()){
+        Object * obj = gray.back();
+        gray.pop_back();
+        obj->trace(this);
+    }
+
+    // young survivors are promoted, so no old object refers to a young one,
+    // unless an arena is open and keeps them young
+    vector<Object *> stillRemembered;
+    for (size_t i = 0; i < remembered.size(); i++){
+        Object * obj = remembered[i];
+        if (arenaOpen && (!major || obj->marked)){
+            stillRemembered.push_back(obj);
+        }else{
+            obj->remembered = false;
+        }
+    }
+    remembered.swap(stillRemembered);
+
+    vector<Object *> survivors;
+    if (major){
+        this->sweep(objects, survivors, false);
+        objects.swap(survivors);
+    }
+    if (arenaOpen){
+        vector<Object *> kept;
+        this->sweep(arena, kept, false);
+        this->sweep(nursery, kept, false);
+        arena.swap(kept);
+    }else{
+        this->sweep(arena, objects, true);
+        this->sweep(nursery, objects, true);
+        arena.clear();
+    }
+    nursery.clear();
+
+    if (major){
+        threshold = size_t(objects.size() * growthFactor);
+        if (threshold < minThreshold) threshold = minThreshold;
+    }else{
+        minorCollections++;
+    }
+    collections++;
+
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    pauseMs += elapsed.count();
+};
+
+/** Deletes the unmarked objects of a generation; the rest join survivors. */
+void Heap::sweep(vector<Object *> & generation, vector<Object *> & survivors, bool promote){
+    for (size_t i = 0; i < generation.size(); i++){
+        Object * obj = generation[i];
+        if (obj->marked){
+            obj->marked = false;
+            if (promote){
+                obj->young = false;
+                obj->old = true;
+            }
+            survivors.push_back(obj);
+        }else{
+            delete obj;
+            freed++;
+        }
+    }
+};
+
+void Heap::setThreshold(size_t count){
+    minThreshold = count;
+    threshold = count;
+};
+
+void Heap::setNurserySize(size_t count){
+    nurserySize = count;
+};
+
+void Heap::setGrowthFactor(double factor){
+    growthFactor = factor;
+};
+
+string Heap::getStats(){
+    stringstream stats;
+    stats << "gc: " << collections << " collections "
+          << "(" << minorCollections << " minor), "
+          << allocated << " objects allocated, "
+          << freed << " objects freed, "
+          << this->getLiveCount() << " live, "
+          << "peak " << peak << ", "
+          << fixed << setprecision(3) << pauseMs << " ms paused";
+    return stats.str();
+};
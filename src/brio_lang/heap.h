@@ -0,0 +1,100 @@
+#ifndef BRIOLANG_SRC_HEAP_H_
+#define BRIOLANG_SRC_HEAP_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+
+class Object;  // forward reference: object.h
+
+struct Allocation {
+    char * start;
+    size_t size;
+};
+
+/** Region of the nursery that objects are bump allocated from. */
+struct Chunk {
+    char * memory;
+    size_t top;  // offset of the next allocation
+    size_t live;  // allocations not yet freed
+};
+
+/** Precedes every allocation, so it can be returned to its chunk. */
+struct AllocationHeader {
+    Chunk * chunk;  // nullptr for large objects
+    size_t size;
+};
+
+/**
+ * Tracks every Object allocated with new and frees the ones that are no
+ * longer reachable. Roots are marked by the Interpreter, after which
+ * collect() traces through Object::trace and sweeps everything unmarked.
+ *
+ * New objects start in the nursery. A minor collection only traces young
+ * objects, plus the old objects the write barrier has remembered, and
+ * promotes the survivors. A major collection traces everything once the
+ * heap, young objects included, has grown past its threshold.
+ *
+ * While a request arena is open, young survivors stay in the arena instead
+ * of being promoted. The collection after closeArena() frees whatever the
+ * request left unreachable in one step and promotes the rest.
+ */
+class Heap {
+    public:
+        static Heap & instance();
+        void * allocate(size_t size);
+        void deallocate(void * memory);
+        void allocating(void * memory, size_t size);
+        void released(void * memory);
+        void track(Object * obj);
+        void pin(Object * obj);
+        void mark(Object * obj);
+        void writeBarrier(Object * owner, Object * value);
+        void openArena();
+        void closeArena();
+        void collect();
+        bool shouldCollect(){ return nursery.size() >= nurserySize || majorDue(); };
+        void setThreshold(size_t count);
+        void setNurserySize(size_t count);
+        void setGrowthFactor(double factor);
+        size_t getLiveCount(){ return nursery.size() + arena.size() + objects.size(); };
+        size_t getCollections(){ return collections; };
+        size_t getMinorCollections(){ return minorCollections; };
+        size_t getAllocations(){ return allocated; };
+        string getStats();
+        inline static const size_t INITIAL_THRESHOLD = 100000;  // live objects before the first major collection
+        inline static const size_t NURSERY_SIZE = 20000;  // young objects before a minor collection
+        inline static const double GROWTH_FACTOR = 2.0;  // next major collection once old objects grow by this
+        inline static const size_t CHUNK_SIZE = 64 * 1024;
+        inline static const size_t LARGE_OBJECT = CHUNK_SIZE / 8;  // larger objects bypass the nursery chunks
+        inline static const size_t FREE_CHUNKS = 16;  // empty chunks kept for reuse
+    private:
+        Heap();
+        bool majorDue(){ return getLiveCount() >= threshold; };
+        Chunk * freshChunk();
+        void sweep(vector<Object *> & generation, vector<Object *> & survivors, bool promote);
+        vector<Object *> nursery;  // young objects
+        vector<Object *> arena;  // young objects that survived a collection in the open arena
+        vector<Object *> objects;  // old objects
+        vector<Object *> remembered;  // old objects that may refer to young ones
+        vector<Object *> gray;
+        vector<Allocation> pending;  // allocated, constructor not yet run
+        Chunk * current;
+        bool arenaOpen;
+        vector<Chunk *> freeChunks;
+        size_t threshold;
+        size_t minThreshold;
+        size_t nurserySize;
+        double growthFactor;
+        size_t collections;
+        size_t minorCollections;
+        size_t freed;
+        size_t allocated;
+        size_t peak;
+        double pauseMs;
+};
+
+#endif  // BRIOLANG_SRC_HEAP_H_
@@ -6,15 +6,84 @@
 #include <brio_lang/http.h>
 #include <brio_lang/exceptions.h>
 
+#include <exception>
 
-HttpClient::HttpClient(){
+
+/// ##################################################################
+/// HttpPool definition
+/// ##################################################################
+
+/** Returns the process wide pool, which is never destroyed. */
+HttpPool & HttpPool::instance(){
+    static HttpPool * pool = new HttpPool();
+    return *pool;
+};
+
+HttpPool::HttpPool(){
+    poolSize = POOL_SIZE;
+    idleTimeout = IDLE_TIMEOUT;
     curl_global_init(CURL_GLOBAL_DEFAULT);
-    this->curl = curl_easy_init();
+
+    // requests run one at a time, so the share needs no lock functions
+    share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+};
+
+/**
+ * Returns an idle handle, or a new one joined to the share. Options from
+ * the previous request are reset; connections and caches are kept.
+ */
+CURL * HttpPool::acquire(){
+    CURL * handle;
+    if (!this->idle.empty()){
+        handle = this->idle.back();
+        this->idle.pop_back();
+        curl_easy_reset(handle);
+    }else{
+        handle = curl_easy_init();
+        if (handle == nullptr){
+            throw IOError("unable to initialize an HTTP client");
+        }
+    }
+
+    curl_easy_setopt(handle, CURLOPT_SHARE, this->share);
+    curl_easy_setopt(handle, CURLOPT_MAXCONNECTS, long(this->poolSize));
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+#if LIBCURL_VERSION_NUM >= 0x074100
+    curl_easy_setopt(handle, CURLOPT_MAXAGE_CONN, this->idleTimeout);
+#endif
+    return handle;
+};
+
+void HttpPool::release(CURL * handle){
+    if (this->idle.size() < this->poolSize){
+        this->idle.push_back(handle);
+    }else{
+        curl_easy_cleanup(handle);
+    }
+};
+
+void HttpPool::setPoolSize(size_t size){
+    this->poolSize = size > 0 ? size : 1;
+    while (this->idle.size() > this->poolSize){
+        curl_easy_cleanup(this->idle.back());
+        this->idle.pop_back();
+    }
+};
+
+
+/// ##################################################################
+/// HttpClient definition
+/// ##################################################################
+
+HttpClient::HttpClient(){
+    this->curl = HttpPool::instance().acquire();
 };
 
 HttpClient::~HttpClient(){
-    curl_easy_cleanup(this->curl);
-    curl_global_cleanup();
+    HttpPool::instance().release(this->curl);
 };
 
 size_t CurlWrite_CallbackFunc_StdString(void *contents, size_t size, size_t nmemb, std::string *s)
@@ -32,92 +101,195 @@ size_t CurlWrite_CallbackFunc_StdString(void *contents, size_t size, size_t nmem
     return newLength;
 }
 
-/** Perform a basic HTTP GET method via libcurl 
- *  Reference: https://curl.haxx.se/libcurl/c/https.html
- *  Reference: https://stackoverflow.com/a/36401787
- **/
-string HttpClient::get(string url){
-    CURLcode resCode;
-    string resString = "";
-    const char * charUrl = url.c_str();
-
-    if(this->curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, charUrl);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &resString);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1L);
-
-        /* Perform the request, res will get the return code */ 
-        resCode = curl_easy_perform(curl);
-        /* Check for errors */ 
-        if(resCode != CURLE_OK)
-            fprintf(stderr, "curl_easy_perform() failed: %s\n",
-              curl_easy_strerror(resCode));
+/** State of a download while curl hands its body to the sink. */
+struct HttpDownload {
+    HttpSink * sink;
+    size_t total;
+    size_t limit;  // most bytes the body may have
+    exception_ptr error;  // raised by the sink, rethrown once curl returns
+};
+
+/** Passes each piece to the sink; exceptions must not unwind through curl. */
+size_t CurlWrite_CallbackFunc_Sink(void *contents, size_t size, size_t nmemb, HttpDownload *download)
+{
+    size_t length = size*nmemb;
+    try
+    {
+        if (length > download->limit - download->total){
+            throw ValueError("HTTP download is larger than " + std::to_string(download->limit) + " bytes");
+        }
+        (*download->sink)((const char *) contents, length);
+    }
+    catch(...)
+    {
+        download->error = current_exception();
+        return 0;
     }
+    download->total += length;
+    return length;
+}
+
+/** Sets the options every request shares, collecting the body in response. */
+void HttpClient::configure(CURL * handle, string * response){
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, response);
+    curl_easy_setopt(handle, CURLOPT_AUTOREFERER, 1L);
+};
+
+/**
+ * Performs the request set up on the handle and returns the response body.
+ * Reference: https://curl.haxx.se/libcurl/c/https.html
+ * Reference: https://stackoverflow.com/a/36401787
+ */
+string HttpClient::perform(){
+    string resString = "";
+    HttpClient::configure(curl, &resString);
+
+    /* Perform the request, res will get the return code */ 
+    CURLcode resCode = curl_easy_perform(curl);
+    /* Check for errors */ 
+    if(resCode != CURLE_OK)
+        fprintf(stderr, "curl_easy_perform() failed: %s\n",
+          curl_easy_strerror(resCode));
 
     return resString;
 };
 
-/** Perform a basic HTTP GET method via libcurl 
- *  Reference: https://curl.haxx.se/libcurl/c/https.html
- *  Reference: https://stackoverflow.com/a/36401787
- **/
+/** Perform a basic HTTP GET method via libcurl */
+string HttpClient::get(string url){
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    return this->perform();
+};
+
+/** Perform a basic HTTP GET method with one extra header via libcurl */
 string HttpClient::get(string url, string header){
-    CURLcode resCode;
-    string resString = "";
-    const char * charUrl = url.c_str();
-
-    if(this->curl) {
-        struct curl_slist *chunk = NULL;
-        chunk = curl_slist_append(chunk, header.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
-
-        curl_easy_setopt(curl, CURLOPT_URL, charUrl);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &resString);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1L);
-
-        /* Perform the request, res will get the return code */ 
-        resCode = curl_easy_perform(curl);
-        /* Check for errors */ 
-        if(resCode != CURLE_OK)
-            fprintf(stderr, "curl_easy_perform() failed: %s\n",
-              curl_easy_strerror(resCode));
-    }
+    struct curl_slist *chunk = NULL;
+    chunk = curl_slist_append(chunk, header.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
 
+    string resString = this->perform();
+    curl_slist_free_all(chunk);
     return resString;
 };
 
 /** Perform a basic HTTP POST method via libcurl */
 string HttpClient::post(string url, string user, string pass, string fields){
-    CURLcode resCode;
-    string resString = "";
-    const char * charUrl = url.c_str();
-
     // authorization
     curl_easy_setopt(curl, CURLOPT_USERNAME, user.c_str());
     curl_easy_setopt(curl, CURLOPT_PASSWORD, pass.c_str());
 
-    if(this->curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, charUrl);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &resString);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1L);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, fields.c_str());  // "name=daniel&project=curl"
-
-        /* Perform the request, res will get the return code */ 
-        resCode = curl_easy_perform(curl);
-        /* Check for errors */ 
-        if(resCode != CURLE_OK)
-            fprintf(stderr, "curl_easy_perform() failed: %s\n",
-              curl_easy_strerror(resCode));
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, fields.c_str());  // "name=daniel&project=curl"
+    return this->perform();
+};
+
+/**
+ * Performs a GET and hands the body to sink in pieces of at most
+ * CHUNK_SIZE bytes rather than collecting it, so large downloads run in
+ * constant memory. Returns the number of bytes received. Raises an
+ * IOError if the transfer fails or the server answers with an error
+ * status, a ValueError once the body grows past limit bytes, and
+ * rethrows whatever the sink raised.
+ */
+size_t HttpClient::download(string url, HttpSink sink, size_t limit){
+    HttpDownload download = {&sink, 0, limit, nullptr};
+    HttpClient::configure(curl, nullptr);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_Sink);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &download);
+    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, CHUNK_SIZE);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+
+    CURLcode resCode = curl_easy_perform(curl);
+    if (download.error != nullptr){
+        rethrow_exception(download.error);
+    }
+    if (resCode != CURLE_OK){
+        throw IOError("HTTP download of '" + url + "' failed: " + curl_easy_strerror(resCode));
     }
+    return download.total;
+};
 
-    return resString;
+
+/// ##################################################################
+/// HttpBatch definition
+/// ##################################################################
+
+/** Sets up the request at index on a pooled handle. */
+CURL * HttpBatch::start(size_t index, vector<HttpResponse> & responses, vector<curl_slist *> & headers){
+    HttpRequest & request = this->requests[index];
+    CURL * handle = HttpPool::instance().acquire();
+    HttpClient::configure(handle, &responses[index].body);
+    curl_easy_setopt(handle, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, (void *) index);
+
+    for (size_t i=0; i<request.headers.size(); i++){
+        headers[index] = curl_slist_append(headers[index], request.headers[i].c_str());
+    }
+    if (headers[index] != nullptr){
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers[index]);
+    }
+    if (request.post){
+        curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request.body.c_str());
+    }
+    if (request.timeoutMs > 0){
+        curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, request.timeoutMs);
+    }
+    return handle;
+};
+
+/**
+ * Runs the requests, starting the next one whenever one finishes so no
+ * more than limit are in flight. Failures are reported on stderr like
+ * HttpClient does, and leave their response not ok.
+ */
+vector<HttpResponse> HttpBatch::perform(size_t limit){
+    size_t count = this->requests.size();
+    vector<HttpResponse> responses(count, HttpResponse{false, ""});
+    vector<curl_slist *> headers(count, nullptr);
+    if (limit == 0) limit = 1;
+
+    CURLM * multi = curl_multi_init();
+    size_t next = 0;
+    size_t running = 0;
+    while (next < count || running > 0){
+        for (; next < count && running < limit; next++, running++){
+            curl_multi_add_handle(multi, this->start(next, responses, headers));
+        }
+
+        int active;
+        curl_multi_perform(multi, &active);
+
+        CURLMsg * message;
+        int queued;
+        while ((message = curl_multi_info_read(multi, &queued)) != nullptr){
+            if (message->msg != CURLMSG_DONE) continue;
+            CURL * handle = message->easy_handle;
+            void * index;
+            curl_easy_getinfo(handle, CURLINFO_PRIVATE, &index);
+
+            CURLcode resCode = message->data.result;
+            responses[size_t(index)].ok = resCode == CURLE_OK;
+            if (resCode != CURLE_OK){
+                fprintf(stderr, "curl_easy_perform() failed: %s\n", curl_easy_strerror(resCode));
+            }
+
+            curl_multi_remove_handle(multi, handle);
+            HttpPool::instance().release(handle);
+            curl_slist_free_all(headers[size_t(index)]);
+            headers[size_t(index)] = nullptr;
+            running--;
+        }
+
+        // sleep until there is activity, unless another request can start
+        bool canStart = next < count && running < limit;
+        if (active > 0 && !canStart){
+            curl_multi_wait(multi, nullptr, 0, 100, nullptr);
+        }
+    }
+    curl_multi_cleanup(multi);
+    return responses;
 };
\ No newline at end of file
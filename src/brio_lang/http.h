@@ -2,10 +2,43 @@
 #define BRIOLANG_SRC_HTTP_H_
 
 #include <string>
+#include <vector>
+#include <cstddef>
+#include <functional>
 #include <curl/curl.h>
 
 using namespace std;
 
+/**
+ * Process wide pool of curl handles. Every handle belongs to one share,
+ * so keep-alive connections, DNS lookups and TLS sessions are reused
+ * across requests, including those of later FastCGI requests. Idle
+ * handles beyond the pool size are cleaned up, and connections idle for
+ * longer than the idle timeout are not reused.
+ */
+class HttpPool {
+    public:
+        static HttpPool & instance();
+        CURL * acquire();
+        void release(CURL * handle);
+        void setPoolSize(size_t size);
+        void setIdleTimeout(long seconds){ idleTimeout = seconds; };
+        size_t getPoolSize(){ return poolSize; };
+        long getIdleTimeout(){ return idleTimeout; };
+        inline static const size_t POOL_SIZE = 8;  // idle handles and cached connections kept
+        inline static const long IDLE_TIMEOUT = 60;  // seconds before an idle connection is dropped
+    private:
+        HttpPool();
+        CURLSH * share;
+        vector<CURL *> idle;
+        size_t poolSize;
+        long idleTimeout;
+};
+
+/** Receives a response body one piece at a time, as curl reads it. */
+typedef function<void(const char * data, size_t size)> HttpSink;
+
+/** Performs a request on a handle borrowed from the HttpPool. */
 class HttpClient{
     public:
         HttpClient();
@@ -13,8 +46,41 @@ class HttpClient{
         string get(string url);
         string get(string url, string header);
         string post(string url, string user, string pass, string fields);
+        size_t download(string url, HttpSink sink, size_t limit);
+        static void configure(CURL * handle, string * response);
+        inline static const long CHUNK_SIZE = 64 * 1024;  // largest piece handed to a sink
     private:
+        string perform();
         CURL * curl;
 };
 
+/** One request of an HttpBatch; a POST if it has a body. */
+struct HttpRequest {
+    string url;
+    vector<string> headers;
+    string body;
+    bool post;
+    long timeoutMs;  // 0 for no timeout
+};
+
+/** Outcome of one request of an HttpBatch. */
+struct HttpResponse {
+    bool ok;  // false if the transfer failed or timed out
+    string body;
+};
+
+/**
+ * Performs several requests concurrently with curl_multi, at most limit
+ * at a time, on handles borrowed from the HttpPool. Responses are
+ * returned in the order the requests were added.
+ */
+class HttpBatch {
+    public:
+        void add(HttpRequest request){ requests.push_back(request); };
+        vector<HttpResponse> perform(size_t limit);
+    private:
+        CURL * start(size_t index, vector<HttpResponse> & responses, vector<curl_slist *> & headers);
+        vector<HttpRequest> requests;
+};
+
 #endif  // BRIOLANG_SRC_HTTP_H_
\ No newline at end of file
@@ -12,14 +12,19 @@
 #include <brio_lang/object.h>
 #include <brio_lang/util.h>
 #include <brio_lang/http.h>
+#include <brio_lang/json.h>
+#include <brio_lang/csv.h>
+#include <brio_lang/output.h>
 #include <brio_lang/parser.h>
 #include <brio_lang/lexer.h>
 #include <brio_lang/def.h>
 #include <brio_lang/ref.h>
+#include <brio_lang/vm.h>
 
 #include <string>
 #include <iostream>
 #include <cmath>
+#include <climits>
 
 
 Interpreter::Interpreter(ProgramNode * rootNode, SymbolTable * symTable){
@@ -46,6 +51,25 @@ void Interpreter::initialize(ProgramNode * rootNode, SymbolTable * symTable, str
     globalScope = &symTable->globals;
     globals = new MemorySpace("globals");
     currentSpace = globals;
+    completion = COMPLETION_NORMAL;
+    returnValue = nullptr;
+    vm = nullptr;
+};
+
+/**
+ * Selects the execution engine for methods, either the tree-walker
+ * ("tree") or the bytecode virtual machine ("vm").
+ */
+void Interpreter::setEngine(string engine){
+    if (engine == "tree"){
+        this->vm = nullptr;
+    }
+    else if (engine == "vm"){
+        this->vm = new VM(this);
+    }
+    else{
+        throw ValueError("unknown engine '" + engine + "'");
+    }
 };
 
 /**
@@ -55,7 +79,7 @@ Object * Interpreter::exec(){
     // invoke import statements
     for (int i=0; i<int(root->children.size()); i++){
         AST * node = root->children[i];
-        if (node->getType() == ImportNode::type){
+        if (node->getKind() == ImportNode::kind){
             this->exec(node);
         }
     }
@@ -63,10 +87,10 @@ Object * Interpreter::exec(){
     // invoke class and variable declarations
     for (int i=0; i<int(root->children.size()); i++){
         AST * node = root->children[i];
-        if (node->getType() == ClassDeclarationNode::type){
+        if (node->getKind() == ClassDeclarationNode::kind){
             this->exec(node);
         }
-        else if (node->getType() == VarDeclarationNode::type){
+        else if (node->getKind() == VarDeclarationNode::kind){
             this->exec(node);
         }
     }
@@ -79,7 +103,7 @@ Object * Interpreter::exec(){
 };
 
 void Interpreter::execImportedModules(AST * node){
-    if (node->getType() == ImportedModuleNode::type){
+    if (node->getKind() == ImportedModuleNode::kind){
         this->exec(node);
     }
     for (int i=0; i<node->children.size(); i++){
@@ -88,175 +112,152 @@ void Interpreter::execImportedModules(AST * node){
 };
 
 /**
- * Visitor dispatch according to AST node type.
+ * Executes a node. Its value stays on the shadow stack of temporaries
+ * until the enclosing statement completes, so a collection while the
+ * rest of the statement runs cannot free it.
  */
 Object * Interpreter::exec(AST * node){
-    string nodeType = node->getType();
+    Object * value = this->dispatch(node);
+    if (value != nullptr) this->temporaries.push_back(value);
+    return value;
+};
 
-    if (nodeType == ProgramNode::type ){
-        this->program(node);
-    }
-    else if (nodeType == ImportNode::type){
-        this->import(node);
-    }
-    else if (nodeType == ImportedModuleNode::type){
-        this->importedModule(node);
-    }
-    else if (nodeType == BlockNode::type ){
-        this->block(node);
-    }
-    else if (nodeType == VarAssignmentNode::type){
-        this->varAssignment(node);
-    }
-    else if (nodeType == AdditionAssignNode::type){
-        this->addAssign(node);
-    }
-    else if (nodeType == SubtractionAssignNode::type){
-        this->subtractAssign(node);
-    }
-    else if (nodeType == MultiplicationAssignNode::type){
-        this->multiplyAssign(node);
-    }
-    else if (nodeType == DivisionAssignNode::type){
-        this->divideAssign(node);
-    }
-    else if (nodeType == BitOrAssignNode::type){
-        this->bitOrAssign(node);
-    }
-    else if (nodeType == BitAndAssignNode::type){
-        this->bitAndAssign(node);
-    }
-    else if (nodeType == VarDeclarationNode::type){
-        this->varDeclaration(node);
-    }
-    else if (nodeType == MethodCallNode::type){
-        return this->methodCall(node);
-    }
-    else if (nodeType == ClassDeclarationNode::type){
-        this->classDeclaration(node);
-    }
-    else if (nodeType == ClassInstantiationNode::type){
-        return this->classInstantiation(node);
-    }
-    else if (nodeType == AddExpressionNode::type){
-        return this->add(node);
-    }
-    else if (nodeType == SubtractExpressionNode::type){
-        return this->subtract(node);
-    }
-    else if (nodeType == MultiplyExpressionNode::type){
-        return this->multiply(node);
-    }
-    else if (nodeType == DivideExpressionNode::type){
-        return this->divide(node);
-    }
-    else if (nodeType == ParenthesesNode::type){
-        return this->parentheses(node);
-    }
-    else if (nodeType == LiteralIntNode::type){
-        return this->literalInt(node);
-    }
-    else if (nodeType == LiteralStringNode::type){
-        return this->literalString(node);
-    }
-    else if (nodeType == LiteralDecimalNode::type){
-        return this->literalDecimal(node);
-    }
-    else if (nodeType == LiteralBooleanNode::type){
-        return this->literalBool(node);
-    }
-    else if (nodeType == LiteralNoneNode::type){
-        return this->literalNone(node);
-    }
-    else if (nodeType == ReturnNode::type){
-        return this->returnStatement(node);
-    }
-    else if (nodeType == IndexNode::type){
-        return this->index(node);
-    }
-    else if (nodeType == ArrayNode::type){
-        return this->array(node);
-    }
-    else if (nodeType == DictionaryNode::type){
-        return this->dictionary(node);
-    }
-    else if (nodeType == BoolAndNode::type){
-        return this->boolAnd(node);
-    }
-    else if (nodeType == BoolOrNode::type){
-        return this->boolOr(node);
-    }
-    else if (nodeType == BoolEqualsNode::type){
-        return this->boolEquals(node);
-    }
-    else if (nodeType == BoolNotEqualsNode::type){
-        return this->boolNotEquals(node);
-    }
-    else if (nodeType == BoolLessThanNode::type){
-        return this->boolLessThan(node);
-    }
-    else if (nodeType == BoolLessThanOrEqualNode::type){
-        return this->boolLessThanOrEqual(node);
-    }
-    else if (nodeType == BoolGreaterThanNode::type){
-        return this->boolGreaterThan(node);
-    }
-    else if (nodeType == BoolGreaterThanOrEqualNode::type){
-        return this->boolGreaterThanOrEqual(node);
-    }
-    else if (nodeType == BitShiftLeftNode::type){
-        return this->bitShiftLeft(node);
-    }
-    else if (nodeType == BitShiftRightNode::type){
-        return this->bitShiftRight(node);
-    }
-    else if (nodeType == ModulusExpressionNode::type){
-        return this->modulus(node);
-    }
-    else if (nodeType == ExponentExpressionNode::type){
-        return this->exponent(node);
-    }
-    else if (nodeType == BitAndExpressionNode::type){
-        return this->bitAnd(node);
-    }
-    else if (nodeType == BitOrExpressionNode::type){
-        return this->bitOr(node);
-    }
-    else if (nodeType == BitXorExpressionNode::type){
-        return this->bitXor(node);
-    }
-    else if (nodeType == IfStatementNode::type){
-        this->ifStatement(node);
-    }
-    else if (nodeType == TryStatementNode::type){
-        this->tryStatement(node);
-    }
-    else if (nodeType == RaiseStatementNode::type){
-        this->raiseStatement(node);
-    }
-    else if (nodeType == ForStatementNode::type){
-        this->forStatement(node);
-    }
-    else if (nodeType == EachStatementNode::type){
-        this->eachStatement(node);
-    }
-    else if (nodeType == WhileStatementNode::type){
-        this->whileStatement(node);
-    }
-    else if (nodeType == SkipStatementNode::type){
-        this->skipStatement(node);
-    }
-    else if (nodeType == MemberAccessNode::type){
-        return this->memberAccess(node);
-    }
-    else if (nodeType == IdentifierNode::type){
-        return this->identifier(node);
-    }
-    else if (nodeType == MethodDeclarationNode::type){
-        // nothing to do
-    }
-    else{
-        throw NotImplementedError("interpreter: unimplemented node: " + nodeType);
+/**
+ * Visitor dispatch according to AST node kind.
+ */
+Object * Interpreter::dispatch(AST * node){
+    switch (node->getKind()){
+        case ProgramNode::kind:
+            this->program(node);
+            break;
+        case ImportNode::kind:
+            this->import(node);
+            break;
+        case ImportedModuleNode::kind:
+            this->importedModule(node);
+            break;
+        case BlockNode::kind:
+            this->block(node);
+            break;
+        case VarAssignmentNode::kind:
+            this->varAssignment(node);
+            break;
+        case AdditionAssignNode::kind:
+            this->addAssign(node);
+            break;
+        case SubtractionAssignNode::kind:
+            this->subtractAssign(node);
+            break;
+        case MultiplicationAssignNode::kind:
+            this->multiplyAssign(node);
+            break;
+        case DivisionAssignNode::kind:
+            this->divideAssign(node);
+            break;
+        case BitOrAssignNode::kind:
+            this->bitOrAssign(node);
+            break;
+        case BitAndAssignNode::kind:
+            this->bitAndAssign(node);
+            break;
+        case VarDeclarationNode::kind:
+            this->varDeclaration(node);
+            break;
+        case MethodCallNode::kind:
+            return this->methodCall(node);
+        case ClassDeclarationNode::kind:
+            this->classDeclaration(node);
+            break;
+        case ClassInstantiationNode::kind:
+            return this->classInstantiation(node);
+        case AddExpressionNode::kind:
+            return this->add(node);
+        case SubtractExpressionNode::kind:
+            return this->subtract(node);
+        case MultiplyExpressionNode::kind:
+            return this->multiply(node);
+        case DivideExpressionNode::kind:
+            return this->divide(node);
+        case ParenthesesNode::kind:
+            return this->parentheses(node);
+        case LiteralIntNode::kind:
+            return this->literalInt(node);
+        case LiteralStringNode::kind:
+            return this->literalString(node);
+        case LiteralDecimalNode::kind:
+            return this->literalDecimal(node);
+        case LiteralBooleanNode::kind:
+            return this->literalBool(node);
+        case LiteralNoneNode::kind:
+            return this->literalNone(node);
+        case ReturnNode::kind:
+            return this->returnStatement(node);
+        case IndexNode::kind:
+            return this->index(node);
+        case ArrayNode::kind:
+            return this->array(node);
+        case DictionaryNode::kind:
+            return this->dictionary(node);
+        case BoolAndNode::kind:
+            return this->boolAnd(node);
+        case BoolOrNode::kind:
+            return this->boolOr(node);
+        case BoolEqualsNode::kind:
+            return this->boolEquals(node);
+        case BoolNotEqualsNode::kind:
+            return this->boolNotEquals(node);
+        case BoolLessThanNode::kind:
+            return this->boolLessThan(node);
+        case BoolLessThanOrEqualNode::kind:
+            return this->boolLessThanOrEqual(node);
+        case BoolGreaterThanNode::kind:
+            return this->boolGreaterThan(node);
+        case BoolGreaterThanOrEqualNode::kind:
+            return this->boolGreaterThanOrEqual(node);
+        case BitShiftLeftNode::kind:
+            return this->bitShiftLeft(node);
+        case BitShiftRightNode::kind:
+            return this->bitShiftRight(node);
+        case ModulusExpressionNode::kind:
+            return this->modulus(node);
+        case ExponentExpressionNode::kind:
+            return this->exponent(node);
+        case BitAndExpressionNode::kind:
+            return this->bitAnd(node);
+        case BitOrExpressionNode::kind:
+            return this->bitOr(node);
+        case BitXorExpressionNode::kind:
+            return this->bitXor(node);
+        case IfStatementNode::kind:
+            this->ifStatement(node);
+            break;
+        case TryStatementNode::kind:
+            this->tryStatement(node);
+            break;
+        case RaiseStatementNode::kind:
+            this->raiseStatement(node);
+            break;
+        case ForStatementNode::kind:
+            this->forStatement(node);
+            break;
+        case EachStatementNode::kind:
+            this->eachStatement(node);
+            break;
+        case WhileStatementNode::kind:
+            this->whileStatement(node);
+            break;
+        case SkipStatementNode::kind:
+            this->skipStatement(node);
+            break;
+        case MemberAccessNode::kind:
+            return this->memberAccess(node);
+        case IdentifierNode::kind:
+            return this->identifier(node);
+        case MethodDeclarationNode::kind:
+            // nothing to do
+            break;
+        default:
+            throw NotImplementedError("interpreter: unimplemented node: " + node->getType());
     }
     return nullptr;
 };
@@ -282,7 +283,7 @@ void Interpreter::importedModule(AST * node){
  * MemberAccessNode.
  */
 string Interpreter::getImportRelativePath(AST * node){
-    if (node->getType() == MemberAccessNode::type){
+    if (node->getKind() == MemberAccessNode::kind){
         string parts;
         for (int i=0; i<node->children.size(); i++){
             parts += node->children[i]->getNodeText();
@@ -292,7 +293,7 @@ string Interpreter::getImportRelativePath(AST * node){
         }
         return parts + ".brio";
     }
-    else if (node->getType() == IdentifierNode::type){
+    else if (node->getKind() == IdentifierNode::kind){
         return node->getNodeText() + ".brio";
     }
     else{
@@ -306,8 +307,8 @@ string Interpreter::getImportRelativePath(AST * node){
  * the path to the main program is returned. 
  */
 string Interpreter::getProgramPath(AST * node){
-    if (node->hasAncestor(ImportedModuleNode::type)){
-        AST * importedModule = node->getAncestor(ImportedModuleNode::type);
+    if (node->hasAncestor(ImportedModuleNode::kind)){
+        AST * importedModule = node->getAncestor(ImportedModuleNode::kind);
         return importedModule->children[1]->getNodeText();
     }
     return this->programPath;
@@ -350,7 +351,7 @@ void Interpreter::import(AST * node){
     // extract import identifier and token
     AST * targetId = node->children[0];
     Token targetToken = targetId->getToken();
-    if (targetId->getType() == MemberAccessNode::type){
+    if (targetId->getKind() == MemberAccessNode::kind){
         targetToken = targetId->children[size(targetId->children)-1]->getToken();
     }
 
@@ -362,6 +363,8 @@ void Interpreter::import(AST * node){
     ProgramNode importTree = importParser.program();
     OperatorPrecedenceVisitor opVisitor;
     opVisitor.visit(&importTree);
+    ConstantVisitor constVisitor;
+    constVisitor.visit(&importTree);
 
     // prepare the ImportedModuleNode to introduce to main AST
     ImportedModuleNode * importedModule = new ImportedModuleNode(targetToken);
@@ -386,12 +389,17 @@ void Interpreter::import(AST * node){
 
 /** Return scope holding id's value; current method space, imported module space, or globals. */
 MemorySpace * Interpreter::getSpaceWithSymbol(AST * node){
-    if (stack.size() > 0 && stack.peek()->get(node->getNodeText()) != nullptr){
-        return stack.peek();
+    if (stack.size() > 0){
+        MethodSpace * top = stack.methodSpace.back();
+        if (node->slotDepth == 0){
+            if (top->getSlot(node->slotIndex) != nullptr) return top;
+        }else if (top->get(node->getNodeText()) != nullptr){
+            return top;
+        }
     }
     
-    if (node->hasAncestor(ImportedModuleNode::type)){
-        AST * importParent = node->getAncestor(ImportedModuleNode::type);
+    if (node->hasAncestor(ImportedModuleNode::kind)){
+        AST * importParent = node->getAncestor(ImportedModuleNode::kind);
         ImportedInstance * importSpace = static_cast<ImportedInstance*>(globals->get(importParent->getNodeText()));
         if (importSpace->get(node->getNodeText()) != nullptr){
             return importSpace;
@@ -411,37 +419,92 @@ void Interpreter::program(AST * node){
 void Interpreter::block(AST * node){
     for (int i=0; i<node->children.size(); i++){
         AST * stmt = node->children[i];
+        size_t mark = this->temporaries.size();
+        this->safepoint();
         this->exec(stmt);
+        this->temporaries.resize(mark);
+        if (completion != COMPLETION_NORMAL) return;
+    }
+};
+
+/** Roots an object that is not the value of an exec() until the statement completes. */
+void Interpreter::protect(Object * obj){
+    if (obj != nullptr) this->temporaries.push_back(obj);
+};
+
+/**
+ * Collects garbage once the heap has grown past its threshold. Only called
+ * between statements, where every live value is reachable from a root.
+ */
+void Interpreter::safepoint(){
+    if (!Heap::instance().shouldCollect()) return;
+
+    // values held by the vm are only rooted at its own safepoints
+    if (this->vm != nullptr && this->vm->isRunning()) return;
+    this->collectGarbage();
+};
+
+/**
+ * Marks the roots: globals, every method space on the stack, the current
+ * space, temporaries and the pending return value; then frees the rest.
+ */
+void Interpreter::collectGarbage(){
+    Heap & heap = Heap::instance();
+    this->globals->trace(&heap);
+    for (int i=0; i<this->stack.methodSpace.size(); i++){
+        this->stack.methodSpace[i]->trace(&heap);
     }
+    heap.mark(dynamic_cast<Object*>(this->currentSpace));
+    this->currentSpace->trace(&heap);
+    for (int i=0; i<this->temporaries.size(); i++){
+        heap.mark(this->temporaries[i]);
+    }
+    heap.mark(this->returnValue);
+    if (this->vm != nullptr) this->vm->trace(&heap);
+    heap.collect();
+};
+
+/**
+ * Runs the block of a loop; returns false once the loop must stop, either
+ * for a 'skip' (consumed here) or a 'return' (left for the method call).
+ */
+bool Interpreter::loopBlock(AST * node){
+    this->block(node);
+    if (completion == COMPLETION_BREAK){
+        completion = COMPLETION_NORMAL;
+        return false;
+    }
+    return completion == COMPLETION_NORMAL;
 };
 
 /**
  * Temporary function to enable "size()" built-in method.
  * This will go away.
  */
-Integer * Interpreter::getSize(AST * node){
-    if (int(node->children.size()) != 1){
+Integer * Interpreter::getSize(vector<Object*> args){
+    if (int(args.size()) != 1){
         throw ValueError("size() takes 1 argument");
     }
-
-    Object * val = this->exec(node->children[0]);
-    return val->getSize();
+    return args[0]->getSize();
 };
 
 /**
  * Temporary function to enable "input()" built-in method.
  * This will go away.
  */
-Object * Interpreter::input(AST * node){
+Object * Interpreter::input(vector<Object*> args){
     String * strInput = new String();
 
-    if (int(node->children.size()) > 1){
+    if (int(args.size()) > 1){
         throw ValueError("input() takes zero or 1 argument");
     }
 
-    if (int(node->children.size()) == 1){
-        std::cout << node->children[0]->getNodeText();
+    // the prompt and anything printed before it show before reading
+    Output & output = Output::instance();
+    if (int(args.size()) == 1){
+        output.write(args[0]->toString());
     }
+    output.flush();
 
     getline(cin, strInput->value);
     return strInput;
@@ -451,97 +514,112 @@ Object * Interpreter::input(AST * node){
  * Temporary function to enable "boolean()" built-in method.
  * This will go away.
  */
-Boolean * Interpreter::boolean(AST * node){
-    Object * result = this->exec(node);
-    return new Boolean(result);
+Boolean * Interpreter::boolean(Object * obj){
+    return new Boolean(obj);
 };
 
 /**
  * Temporary function to enable "string()" built-in method.
  * This will go away.
  */
-String * Interpreter::str(AST * node){
-    Object * result = this->exec(node);
-    return new String(result);
+String * Interpreter::str(Object * obj){
+    return new String(obj);
 };
 
 /**
  * Temporary function to enable "integer()" built-in method.
  * This will go away.
  */
-Integer * Interpreter::integer(AST * node){
-    Object * result = this->exec(node);
-    return new Integer(result);
+Integer * Interpreter::integer(Object * obj){
+    return new Integer(obj);
 };
 
 /**
  * Temporary function to enable "decimal()" built-in method.
  * This will go away.
  */
-Decimal * Interpreter::decimal(AST * node){
-    Object * result = this->exec(node);
-    return new Decimal(result);
+Decimal * Interpreter::decimal(Object * obj){
+    return new Decimal(obj);
 };
 
 /**
  * Built-in function to retrieve an environment variable.
  */
-Object * Interpreter::getEnv(AST * node){
-    if (node->children.size() == 0){
-        return new None();
+Object * Interpreter::getEnv(vector<Object*> args){
+    if (args.size() == 0){
+        return None::get();
     }
-    if (getenv(node->children[0]->getNodeText().c_str()) != nullptr){
-        string value = getenv(node->children[0]->getNodeText().c_str());
+    string name = args[0]->toString();
+    if (getenv(name.c_str()) != nullptr){
+        string value = getenv(name.c_str());
         return new String(value);
     }
-    return new None();
+    return None::get();
 }
 
 /**
  * Temporary function to enable "print()" built-in method.
  * This will go away.
  */
-void Interpreter::print(AST * node){
-    Object * result = this->exec(node->children[0]);
-    if (result == nullptr) {
-        std::cout << std::endl;
+void Interpreter::print(vector<Object*> args){
+    Output & output = Output::instance();
+    if (args.size() == 0 || args[0] == nullptr) {
+        output.write("\n");
         return;
     }
 
+    // values are written into the buffer as they are serialized
+    args[0]->writeTo(output.stream());
+
     // if second argument to print function, use as terminating character
-    if (node->children.size() == 2){
-        std::cout << result->toString() << this->exec(node->children[1])->toString();
+    if (args.size() == 2){
+        args[1]->writeTo(output.stream());
     }else{
-        std::cout << result->toString() << std::endl;
+        output.write("\n");
     }
 }
 
 /**
- * Temporary function to enable "range()" built-in method.
- * This will go away.
+ * Built-in function "flush()", writes out whatever print() has buffered.
  */
-Object * Interpreter::range(AST * node){
-    Object * result = this->exec(node->children[0]);
+Object * Interpreter::flush(vector<Object*> args){
+    if (args.size() != 0){
+        throw ValueError("flush() takes no arguments");
+    }
+    Output::instance().flush();
+    return nullptr;
+}
 
-    if (static_cast<Integer*>(result) == nullptr){
-        throw ValueError("range accepts an Integer value only");
+/**
+ * Returns a lazy Range for "range(stop)", "range(start, stop)" or
+ * "range(start, stop, step)".
+ */
+Object * Interpreter::range(vector<Object*> args){
+    if (args.size() < 1 || args.size() > 3){
+        throw ValueError("range expects one to three arguments");
     }
 
-    Integer * intResult = static_cast<Integer*>(result);
+    vector<int> bounds;
+    for (int i=0; i<args.size(); i++){
+        Integer * intResult = dynamic_cast<Integer*>(args[i]);
+        if (intResult == nullptr){
+            throw ValueError("range accepts Integer values only");
+        }
+        bounds.push_back(intResult->value);
+    }
 
-    Array * rng = new Array();
-    for (int i = 0; i < intResult->value; i++){
-        rng->value.push_back(new Integer(i));
+    if (bounds.size() == 1){
+        return new Range(0, bounds[0], 1);
     }
-    return rng;
+    int step = bounds.size() == 3 ? bounds[2] : 1;
+    return new Range(bounds[0], bounds[1], step);
 }
 
 /**
  * Temporary function to enable "arg()" built-in method.
  * This will go away.
  */
-String * Interpreter::arg(AST * node){
-    Object * obj = this->exec(node);
+String * Interpreter::arg(Object * obj){
     if (dynamic_cast<Integer*>(obj) != nullptr){
         Integer * index = dynamic_cast<Integer*>(obj);
         if (index->value > this->arguments.size()-1){
@@ -558,27 +636,16 @@ String * Interpreter::arg(AST * node){
  * Temporary function to enable "open()" built-in method.
  * This will go away.
  */
-Object * Interpreter::open(AST * node){
-    if (node->children.size() == 1){
-        AST * astFilePath = node->children[0];
-        String * filePath = static_cast<String*>(this->exec(astFilePath));
-        return new File(filePath->toString());
-    }
-    else if (node->children.size() == 2){
-        AST * astFilePath = node->children[0];
-        AST * astFileMode = node->children[1];
-        String * filePath = static_cast<String*>(this->exec(astFilePath));
-        String * fileMode = static_cast<String*>(this->exec(astFileMode));
-        return new File(filePath->toString(), fileMode->toString());
-    }
-    else if (node->children.size() == 3){
-        AST * astFilePath = node->children[0];
-        AST * astFileMode = node->children[1];
-        AST * astNewLine = node->children[2];
-        String * filePath = static_cast<String*>(this->exec(astFilePath));
-        String * fileMode = static_cast<String*>(this->exec(astFileMode));
-        Boolean * newline = static_cast<Boolean*>(this->exec(astNewLine));
-        return new File(filePath->value, fileMode->value, newline->value);
+Object * Interpreter::open(vector<Object*> args){
+    if (args.size() == 1){
+        return new File(args[0]->toString());
+    }
+    else if (args.size() == 2){
+        return new File(args[0]->toString(), args[1]->toString());
+    }
+    else if (args.size() == 3){
+        Boolean * newline = static_cast<Boolean*>(args[2]);
+        return new File(args[0]->toString(), args[1]->toString(), newline->value);
     }
     else{
         throw ValueError("open() takes 1, 2, or 3 arguments");
@@ -589,8 +656,7 @@ Object * Interpreter::open(AST * node){
  * Temporary function to enable "close()" built-in method.
  * This will go away.
  */
-Object * Interpreter::close(AST * node){
-    Object * obj = this->exec(node);
+Object * Interpreter::close(Object * obj){
     if (dynamic_cast<File*>(obj) != nullptr){
         File * file = dynamic_cast<File*>(obj);
         file->close();
@@ -613,10 +679,9 @@ void Interpreter::exit(){
  * Temporary function to enable "exit(Integer)" built-in method.
  * This will go away.
  */
-void Interpreter::exit(AST * node){
-    Object * exitCode = this->exec(node);
-    if (static_cast<Integer*>(exitCode) != nullptr){
-        Integer * exitCodeInt = static_cast<Integer*>(exitCode);
+void Interpreter::exit(Object * exitCode){
+    if (dynamic_cast<Integer*>(exitCode) != nullptr){
+        Integer * exitCodeInt = dynamic_cast<Integer*>(exitCode);
         std::exit(exitCodeInt->value);
     }else{
         throw ValueError("invalid exit status code");
@@ -628,65 +693,295 @@ void Interpreter::exit(AST * node){
  * Temporary function to enable basic HTTP GETs for early development.
  * This will go away.
  */
-Object * Interpreter::httpGet(AST * node){
-    if (node->getChildCount() == 1){
-        AST * url = node->children[0];
-        Object * strUrl = this->exec(url);
+Object * Interpreter::httpGet(vector<Object*> args){
+    if (args.size() == 1){
         HttpClient client;
-        string response = client.get(strUrl->toString());
+        string response = client.get(args[0]->toString());
         return new String(response);
-    }else if (node->getChildCount() == 2){
-        AST * url = node->children[0];
-        AST * header = node->children[1];
-        Object * strUrl = this->exec(url);
-        Object * strHeader = this->exec(header);
+    }else if (args.size() == 2){
         HttpClient client;
         string response = client.get(
-            strUrl->toString(),
-            strHeader->toString()    
+            args[0]->toString(),
+            args[1]->toString()
         );
         return new String(response);
     }
     return nullptr;
 }
 
+/**
+ * Parses JSON text into Dictionaries, Arrays and primitive values.
+ */
+Object * Interpreter::jsonParse(vector<Object*> args){
+    if (args.size() != 1){
+        throw TypeError("'jsonParse' takes exactly 1 argument");
+    }
+    String * text = dynamic_cast<String*>(args[0]);
+    if (text == nullptr){
+        throw TypeError("'jsonParse' expects a String, not " + args[0]->getType());
+    }
+    JsonParser parser(text->value);
+    return parser.parse();
+}
+
+/**
+ * Converts a value to JSON text.
+ */
+Object * Interpreter::jsonStringify(vector<Object*> args){
+    if (args.size() != 1){
+        throw TypeError("'jsonStringify' takes exactly 1 argument");
+    }
+    JsonWriter writer;
+    return new String(writer.stringify(args[0]));
+}
+
+/**
+ * Returns a reader that yields the elements of a JSON document in a File
+ * or String one at a time, see JsonReader.
+ */
+Object * Interpreter::jsonReader(vector<Object*> args){
+    if (args.size() != 1){
+        throw TypeError("'jsonReader' takes exactly 1 argument");
+    }
+    return new JsonReader(args[0]);
+}
+
+/**
+ * Returns a reader that yields the rows of CSV data in a File or String
+ * one at a time, see CsvReader. The delimiter defaults to a comma.
+ */
+Object * Interpreter::csvReader(vector<Object*> args){
+    if (args.size() == 1){
+        return new CsvReader(args[0], ',');
+    }else if (args.size() == 2){
+        string delimiter = args[1]->toString();
+        if (dynamic_cast<String*>(args[1]) == nullptr || delimiter.size() != 1){
+            throw ValueError("CSV delimiter must be a single character");
+        }
+        return new CsvReader(args[0], delimiter[0]);
+    }
+    throw TypeError("'csvReader' takes 1 or 2 arguments");
+}
+
+/**
+ * Returns a writer that formats rows as CSV into a File, see CsvWriter.
+ * The delimiter defaults to a comma.
+ */
+Object * Interpreter::csvWriter(vector<Object*> args){
+    if (args.size() < 1 || args.size() > 2){
+        throw TypeError("'csvWriter' takes 1 or 2 arguments");
+    }
+    File * file = dynamic_cast<File*>(args[0]);
+    if (file == nullptr){
+        throw TypeError("'csvWriter' expects a File, not " + args[0]->getType());
+    }
+    if (args.size() == 1){
+        return new CsvWriter(file, ',');
+    }
+    string delimiter = args[1]->toString();
+    if (dynamic_cast<String*>(args[1]) == nullptr || delimiter.size() != 1){
+        throw ValueError("CSV delimiter must be a single character");
+    }
+    return new CsvWriter(file, delimiter[0]);
+}
+
 /**
  * Temporary function to enable basic HTTP POSTs for early development.
  * This will go away.
  */
-Object * Interpreter::httpPost(AST * node){
-    AST * url = node->children[0];
-    AST * user = node->children[1];
-    AST * pass = node->children[2];
-    AST * fields = node->children[3];
-
-    Object * strUrl = this->exec(url);
-    Object * strUser = this->exec(user);
-    Object * strPass = this->exec(pass);
-    Object * strFields = this->exec(fields);
+Object * Interpreter::httpPost(vector<Object*> args){
+    if (args.size() != 4){
+        throw TypeError("'httpPost' takes exactly 4 arguments");
+    }
 
     HttpClient client;
     string response = client.post(
-        strUrl->toString(), strUser->toString(), 
-        strPass->toString(), strFields->toString()
+        args[0]->toString(), args[1]->toString(),
+        args[2]->toString(), args[3]->toString()
     );
     return new String(response);
 }
 
+/**
+ * Performs an Array of requests concurrently and returns their response
+ * bodies in order, none for a request that failed or timed out. A
+ * request is a URL String or a Dictionary with a "url" and optionally
+ * "headers" (Array of Strings), "body" (sent as a POST) and "timeout" in
+ * seconds. The optional second argument limits how many run at once,
+ * by default the HTTP pool size.
+ */
+Object * Interpreter::httpMulti(vector<Object*> args){
+    if (args.size() < 1 || args.size() > 2){
+        throw TypeError("'httpMulti' takes 1 or 2 arguments");
+    }
+    Array * specs = dynamic_cast<Array*>(args[0]);
+    if (specs == nullptr){
+        throw TypeError("'httpMulti' expects an Array of requests, not " + args[0]->getType());
+    }
+    size_t limit = HttpPool::instance().getPoolSize();
+    if (args.size() == 2){
+        Integer * intLimit = dynamic_cast<Integer*>(args[1]);
+        if (intLimit == nullptr || intLimit->value < 1){
+            throw ValueError("'httpMulti' concurrency limit must be a positive Integer");
+        }
+        limit = intLimit->value;
+    }
+
+    HttpBatch batch;
+    String urlKey("url"), headersKey("headers"), bodyKey("body"), timeoutKey("timeout");
+    for (int i=0; i<specs->value.size(); i++){
+        HttpRequest request = {"", {}, "", false, 0};
+        Object * spec = specs->value[i];
+        Dictionary * dict = dynamic_cast<Dictionary*>(spec);
+        if (dynamic_cast<String*>(spec) != nullptr){
+            request.url = spec->toString();
+        }
+        else if (dict != nullptr && dynamic_cast<String*>(dict->value.get(&urlKey)) != nullptr){
+            request.url = dict->value.get(&urlKey)->toString();
+
+            Object * headers = dict->value.get(&headersKey);
+            if (headers != nullptr){
+                Array * headerArray = dynamic_cast<Array*>(headers);
+                if (headerArray == nullptr){
+                    throw TypeError("request headers must be an Array of Strings");
+                }
+                for (int j=0; j<headerArray->value.size(); j++){
+                    request.headers.push_back(headerArray->value[j]->toString());
+                }
+            }
+
+            Object * body = dict->value.get(&bodyKey);
+            if (body != nullptr && body != None::get()){
+                request.body = body->toString();
+                request.post = true;
+            }
+
+            Object * timeout = dict->value.get(&timeoutKey);
+            if (dynamic_cast<Integer*>(timeout) != nullptr){
+                request.timeoutMs = long(dynamic_cast<Integer*>(timeout)->value) * 1000;
+            }
+            else if (dynamic_cast<Decimal*>(timeout) != nullptr){
+                request.timeoutMs = long(dynamic_cast<Decimal*>(timeout)->value * 1000);
+            }
+            else if (timeout != nullptr && timeout != None::get()){
+                throw TypeError("request timeout must be a number of seconds");
+            }
+        }
+        else{
+            throw TypeError("each request must be a URL String or a Dictionary with a \"url\"");
+        }
+        batch.add(request);
+    }
+
+    vector<HttpResponse> responses = batch.perform(limit);
+    Array * results = new Array();
+    for (int i=0; i<responses.size(); i++){
+        if (responses[i].ok){
+            results->value.push_back(new String(responses[i].body));
+        }else{
+            results->value.push_back(None::get());
+        }
+    }
+    return results;
+}
+
+/**
+ * Streams the body of a GET to a File opened for writing, or to a class
+ * instance whose 'write' method is called with each piece as a String
+ * of at most 64KB. Returns the number of bytes received; bodies too
+ * large for an Integer raise a ValueError.
+ */
+Object * Interpreter::httpDownload(vector<Object*> args){
+    if (args.size() != 2){
+        throw TypeError("'httpDownload' takes exactly 2 arguments");
+    }
+    string url = args[0]->toString();
+    File * file = dynamic_cast<File*>(args[1]);
+    ClassInstance * class_inst = dynamic_cast<ClassInstance*>(args[1]);
+
+    HttpSink sink;
+    if (file != nullptr){
+        file->writeRaw("", 0);  // fails before the request if the file is closed or read-only
+        sink = [file](const char * data, size_t size){
+            file->writeRaw(data, size);
+        };
+    }
+    else if (class_inst != nullptr){
+        MethodSymbol * writeMethod = dynamic_cast<MethodSymbol*>(class_inst->symbol->resolveMember("write"));
+        if (writeMethod == nullptr){
+            throw TypeError(class_inst->symbol->getSymbolName() + " does not define 'write'");
+        }
+        sink = [this, class_inst, writeMethod](const char * data, size_t size){
+            vector<Object*> params;
+            params.push_back(new String(string(data, size)));
+            this->invoke(writeMethod, params, class_inst);
+        };
+    }
+    else{
+        throw TypeError("'httpDownload' writes to a File or an object with a 'write' method, not " + args[1]->getType());
+    }
+
+    HttpClient client;
+    return Integer::get(int(client.download(url, sink, INT_MAX)));
+}
+
 /**
  * Load an object
  */
 Object * Interpreter::load(AST * node){
-    if (node->getType() == MemberAccessNode::type){
+    return SmallInteger::box(this->loadValue(node));
+}
+
+/**
+ * Load a value without boxing it, so a local may come back as a tagged
+ * integer. Only for the arithmetic and comparison paths, see operand().
+ */
+Object * Interpreter::loadValue(AST * node){
+    if (node->getKind() == MemberAccessNode::kind){
         return this->memberLoad(node);
     }
 
+    // locals resolved by Ref.cc are read straight from their slot
+    if (node->slotDepth == 0 && stack.size() > 0){
+        Object * value = stack.methodSpace.back()->getSlot(node->slotIndex);
+        if (value != nullptr) return value;
+    }
+
     MemorySpace * space = this->getSpaceWithSymbol(node);
     if (space != nullptr) return space->get(node->getNodeText());
     throw NameError("no such variable " + node->getNodeText());
     return nullptr;
 }
 
+/**
+ * Store an object to an existing variable, or define it in the current space.
+ * Only method slots keep tagged integers; other spaces get them boxed.
+ */
+void Interpreter::store(AST * node, Object * value){
+    if (node->slotDepth == 0 && stack.size() > 0){
+        MethodSpace * top = stack.methodSpace.back();
+        if (top->getSlot(node->slotIndex) != nullptr){
+            top->putSlot(node->slotIndex, value);
+            return;
+        }
+    }
+
+    MemorySpace * space = this->getSpaceWithSymbol(node);
+    if (space == nullptr) space = currentSpace;
+    space->put(node->getNodeText(), SmallInteger::box(value));
+}
+
+/**
+ * Define a variable in the current space
+ */
+void Interpreter::declare(AST * node, Object * value){
+    if (node->slotDepth == 0 && stack.size() > 0 && currentSpace == stack.peek()){
+        stack.methodSpace.back()->putSlot(node->slotIndex, value);
+        return;
+    }
+    currentSpace->put(node->getNodeText(), SmallInteger::box(value));
+}
+
 /**
  * Load an object from a class instance or object
  * E.g. @board[0][1]  z["key"].foo  x[0]  y["foo"]  @board.foo.bar
@@ -702,7 +997,7 @@ Object * Interpreter::memberLoad(AST * node){
     for (int i=1; i<int(node->children.size()); i++){
         AST * memberNode = node->children[i];
 
-        if (memberNode->getType() == IdentifierNode::type){
+        if (memberNode->getKind() == IdentifierNode::kind){
             ClassInstance * class_inst = static_cast<ClassInstance*>(obj);
             if (class_inst == nullptr){
                 throw AttributeError(obj->toString() + " is not a class instance");
@@ -714,10 +1009,10 @@ Object * Interpreter::memberLoad(AST * node){
             }
             obj = class_inst->get(memberNode->getNodeText());
         }
-        else if (memberNode->getType() == MemberAccessNode::type){
+        else if (memberNode->getKind() == MemberAccessNode::kind){
             obj = obj->index(this->exec(memberNode));
         }
-        else if (memberNode->getType() == IndexNode::type){
+        else if (memberNode->getKind() == IndexNode::kind){
             obj = obj->index(this->exec(memberNode));
         }
         else{
@@ -747,7 +1042,7 @@ void Interpreter::memberAssign(AST * lhs, Object * value){
     for (int i=1; i<int(lhs->children.size()) - 1; i++){
         AST * member = lhs->children[i];
 
-        if (member->getType() == IdentifierNode::type){
+        if (member->getKind() == IdentifierNode::kind){
             ClassInstance * class_inst = static_cast<ClassInstance*>(obj);
             if (class_inst == nullptr){
                 throw AttributeError(obj->toString() + " is not a class instance");
@@ -757,13 +1052,13 @@ void Interpreter::memberAssign(AST * lhs, Object * value){
             }
             obj = class_inst->get(member->getNodeText());
         }
-        else if (member->getType() == MemberAccessNode::type){
+        else if (member->getKind() == MemberAccessNode::kind){
             obj = obj->index(this->exec(member));
         }
-        else if (member->getType() == IndexNode::type){
+        else if (member->getKind() == IndexNode::kind){
             obj = obj->index(this->exec(member));
         }
-        else if (member->getType() == LiteralIntNode::type){
+        else if (member->getKind() == LiteralIntNode::kind){
             obj = obj->index(this->exec(member));
         }
         else{
@@ -771,6 +1066,11 @@ void Interpreter::memberAssign(AST * lhs, Object * value){
         }
     }
 
+    // a range is copied into an Array the first time it is assigned to
+    if (dynamic_cast<Range*>(obj) != nullptr){
+        obj = static_cast<Range*>(obj)->materialize();
+    }
+
     // assign last member/index value
     if (dynamic_cast<ClassInstance*>(obj) != nullptr){
         ClassInstance * classInstObj = static_cast<ClassInstance*>(obj); 
@@ -794,24 +1094,16 @@ void Interpreter::memberAssign(AST * lhs, Object * value){
         }
         
         arrayObj->value[lastIndexInt] = value;
+        Heap::instance().writeBarrier(arrayObj, value);
     }
     else if (dynamic_cast<Dictionary*>(obj) != nullptr){
         Dictionary * dictObj = dynamic_cast<Dictionary*>(obj);
         Object * lastIndexObject = this->exec(z);
 
         // overwrite key if already exists, otherwise add new
-        map<Object*, Object *>::iterator it;
-        for (it = dictObj->value.begin(); it != dictObj->value.end(); it++ ){
-            Object * key = it->first;
-            if (key->toString() == lastIndexObject->toString()
-                && key->getType() == lastIndexObject->getType()){
-                dictObj->value[key] = value;
-                return;
-            }
-        }
-
-        // key not found, insert new value
-        dictObj->value[lastIndexObject] = value;
+        dictObj->value.put(lastIndexObject, value);
+        Heap::instance().writeBarrier(dictObj, lastIndexObject);
+        Heap::instance().writeBarrier(dictObj, value);
     }
     else{
         throw RuntimeError("invalid member assignment");
@@ -820,33 +1112,30 @@ void Interpreter::memberAssign(AST * lhs, Object * value){
 
 void Interpreter::varDeclaration(AST * node){
     AST * lhs = node->children[0];
-    string id = lhs->getNodeText();
 
     // if node only has one child, assume 'none' value for rhs
     Object * value = nullptr;
     if (node->getChildCount() > 1){
         AST * rhs = node->children[1];  
-        value = this->exec(rhs);
+        value = this->operand(rhs);
     }else{
-        value = new None();
+        value = None::get();
     }
 
-    currentSpace->put(id, value);
+    this->declare(lhs, value);
 };
 
 void Interpreter::varAssignment(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];
-    Object * value = this->exec(rhs);
+    Object * value = this->operand(rhs);
 
-    if (lhs->getType() == MemberAccessNode::type){
-        this->memberAssign(lhs, value);
+    if (lhs->getKind() == MemberAccessNode::kind){
+        this->memberAssign(lhs, SmallInteger::box(value));
         return;
     }
 
-    MemorySpace * space = this->getSpaceWithSymbol(lhs);
-    if (space == nullptr) space = currentSpace;
-    space->put(lhs->getNodeText(), value);
+    this->store(lhs, value);
 };
 
 Object * Interpreter::main(){
@@ -868,17 +1157,42 @@ Object * Interpreter::main(vector<Object*> params){
     if (method_sym == nullptr){
         throw NameError("method '" + MAIN + "' not found");
     }
-    MethodSpace * methSpace = new MethodSpace(method_sym);
-    MemorySpace * saveSpace = currentSpace;
-    currentSpace = methSpace;
+
+    return this->invoke(method_sym, params, nullptr);
+};
+
+/**
+ * Calls a method with arguments that are already evaluated, on the
+ * selected engine. class_inst is bound to 'this' when it is not nullptr.
+ */
+Object * Interpreter::invoke(MethodSymbol * method_sym, vector<Object*> params, ClassInstance * class_inst){
+    string method_id = method_sym->getSymbolName();
+
+    // run on the bytecode vm when selected
+    if (this->vm != nullptr){
+        return this->vm->invoke(method_sym, params, class_inst);
+    }
 
     // verify arguments
     AST * methDeclr = method_sym->def_node->parent;
     AST * methParams = methDeclr->children[2];
     if (methParams->getChildCount() > params.size()){
-        throw TypeError("too few parameters provided for '" + MAIN + "'");
+        throw TypeError("too few parameters provided for '" + method_id + "'");
     }else if (methParams->getChildCount() < params.size()){
-        throw TypeError("too many parameters provided for '" + MAIN + "'");
+        throw TypeError("too many parameters provided for '" + method_id + "'");
+    }
+
+    MethodSpace * methSpace = new MethodSpace(method_sym);
+    MemorySpace * saveSpace = currentSpace;
+    currentSpace = methSpace;
+
+    // add class instance and super to method space
+    if (class_inst != nullptr){
+        methSpace->put(Literals::THIS, class_inst);
+
+        if(class_inst->symbol->superClass != nullptr){
+            methSpace->put(Literals::SUPER, class_inst);
+        }
     }
 
     // define arguments
@@ -895,15 +1209,68 @@ Object * Interpreter::main(vector<Object*> params){
     this->stack.push(methSpace);
     try{
         this->exec(methBlock);
-    }catch (const ReturnValue rv){
-        result = rv.value;
+    }catch (...){
+        this->stack.pop();
+        currentSpace = saveSpace;
+        delete methSpace;
+        throw;
     }
+    if (completion == COMPLETION_RETURN) result = returnValue;
+    completion = COMPLETION_NORMAL;
     this->stack.pop();
     currentSpace = saveSpace;
+    delete methSpace;
     return result;
 };
 
-String * Interpreter::traceback(AST * node){
+/**
+ * Returns the iterator an 'each' loop steps through. Class instances
+ * take part by defining 'iter', returning the object to iterate, and/or
+ * 'next', returning each element and none once exhausted.
+ */
+Iterator * Interpreter::iter(Object * obj){
+    ClassInstance * class_inst = dynamic_cast<ClassInstance*>(obj);
+    if (class_inst == nullptr){
+        return obj->iter();
+    }
+
+    MethodSymbol * iterMethod = dynamic_cast<MethodSymbol*>(class_inst->symbol->resolveMember("iter"));
+    if (iterMethod != nullptr){
+        vector<Object*> emptyParams;
+        Object * iterable = this->invoke(iterMethod, emptyParams, class_inst);
+        if (iterable == nullptr){
+            throw TypeError("'iter' of " + class_inst->symbol->getSymbolName() + " did not return an iterable");
+        }
+        if (iterable != class_inst) return this->iter(iterable);
+    }
+
+    MethodSymbol * nextMethod = dynamic_cast<MethodSymbol*>(class_inst->symbol->resolveMember("next"));
+    if (nextMethod == nullptr){
+        throw TypeError(class_inst->symbol->getSymbolName() + " is not iterable, it does not define 'next'");
+    }
+    return new ClassIterator(this, class_inst, nextMethod);
+};
+
+ClassIterator::ClassIterator(Interpreter * interp, ClassInstance * inst, MethodSymbol * next_method){
+    interpreter = interp;
+    instance = inst;
+    method = next_method;
+};
+
+Object * ClassIterator::next(){
+    vector<Object*> emptyParams;
+    Object * element = this->interpreter->invoke(this->method, emptyParams, this->instance);
+    if (element == nullptr || dynamic_cast<None*>(element) != nullptr){
+        return nullptr;
+    }
+    return element;
+};
+
+void ClassIterator::trace(Heap * heap){
+    heap->mark(this->instance);
+};
+
+String * Interpreter::traceback(Object * obj){
     // TODO: determine file name and module name
     string traceback = "Traceback (most recent call last):\n";
 
@@ -917,7 +1284,7 @@ String * Interpreter::traceback(AST * node){
         traceback += "    " + space->getName() + "()\n";
     } 
     
-    traceback += this->exec(node)->toString();
+    traceback += obj->toString();
     return new String(traceback);
 };
 
@@ -928,93 +1295,129 @@ Object * Interpreter::builtInMethodCall(AST * node){
     string method_id = node->children[0]->getNodeText();
     AST * params = node->children[1];
 
+    // evaluate arguments before dispatching
+    vector<Object*> args;
+    for (int i=0; i<params->getChildCount(); i++){
+        args.push_back(this->exec(params->children[i]));
+    }
+    return this->builtInMethodCall(method_id, args);
+}
+
+/**
+ * Invokes a BuiltInMethod with evaluated arguments, shared by both engines.
+ */
+Object * Interpreter::builtInMethodCall(string method_id, vector<Object*> args){
     if (method_id == "arg"){
-        if (params->getChildCount() == 1){
-            return this->arg(params->children[0]);
+        if (args.size() == 1){
+            return this->arg(args[0]);
         }
         else{
             throw ValueError("arg expects a single argument");
         }
     }
     else if (method_id == "traceback"){
-        if (params->getChildCount() == 1){
-            return this->traceback(params->children[0]);
+        if (args.size() == 1){
+            return this->traceback(args[0]);
         }
         else{
             throw ValueError("traceback expects a single argument");
         }
     }
     else if (method_id == "boolean"){
-        if (params->getChildCount() == 1){
-            return this->boolean(params->children[0]);
+        if (args.size() == 1){
+            return this->boolean(args[0]);
         }
         else{
             throw ValueError("boolean expects a single argument");
         }
     }
     else if (method_id == "string"){
-        if (params->getChildCount() == 1){
-            return this->str(params->children[0]);
+        if (args.size() == 1){
+            return this->str(args[0]);
         }
         else{
             throw ValueError("string expects a single argument");
         }
     }
     else if (method_id == "integer"){
-        if (params->getChildCount() == 1){
-            return this->integer(params->children[0]);
+        if (args.size() == 1){
+            return this->integer(args[0]);
         }
         else{
             throw ValueError("integer expects a single argument");
         }
     }
     else if (method_id == "decimal"){
-        if (params->getChildCount() == 1){
-            return this->decimal(params->children[0]);
+        if (args.size() == 1){
+            return this->decimal(args[0]);
         }
         else{
             throw ValueError("decimal expects a single argument");
         }
     }
     else if (method_id == "size"){
-        return this->getSize(params);
+        return this->getSize(args);
     }
     else if (method_id == "input"){
-        return this->input(params);
+        return this->input(args);
     }
     else if (method_id == "print"){
-        this->print(params);
+        this->print(args);
+    }
+    else if (method_id == "flush"){
+        return this->flush(args);
     }
     else if (method_id == "getEnv"){
-        return this->getEnv(params);
+        return this->getEnv(args);
+    }
+    else if (method_id == "jsonParse"){
+        return this->jsonParse(args);
+    }
+    else if (method_id == "jsonStringify"){
+        return this->jsonStringify(args);
+    }
+    else if (method_id == "jsonReader"){
+        return this->jsonReader(args);
+    }
+    else if (method_id == "csvReader"){
+        return this->csvReader(args);
+    }
+    else if (method_id == "csvWriter"){
+        return this->csvWriter(args);
     }
     else if (method_id == "range"){
-        return this->range(params);
+        return this->range(args);
     }
     else if (method_id == "open"){
-        return this->open(params);
+        return this->open(args);
     }
     else if (method_id == "close"){ 
-        if (params->children.size() == 1){
-            this->close(params->children[0]);
+        if (args.size() == 1){
+            this->close(args[0]);
         }else{
             throw TypeError("'close' takes exactly 1 argument");
         }
     }
     else if (method_id == "exit"){
-        if (params->children.size() == 0){
+        if (args.size() == 0){
             this->exit();
-        }else if (params->children.size() == 1){
-            this->exit(params->children[0]);
+        }else if (args.size() == 1){
+            this->exit(args[0]);
         }else{
             throw TypeError("'exit' takes exactly 1 argument");
         }
     }
     else if (method_id == "httpGet"){
-        return this->httpGet(params);
+        return this->httpGet(args);
     }
     else if (method_id == "httpPost"){
-        return this->httpPost(params);
+        return this->httpPost(args);
+    }
+    else if (method_id == "httpMulti"){
+        return this->httpMulti(args);
+    }
+    else if (method_id == "httpDownload"){
+        return this->httpDownload(args);
     }
     return nullptr;
 }
@@ -1023,12 +1426,10 @@ Object * Interpreter::builtInMethodCall(AST * node){
  * Determines if a provided MethodCallNode is for a built-in method.
  */
 bool Interpreter::isBuiltInMethodCall(AST * node){
-    if (node->children[0]->getType() == IdentifierNode::type){
+    if (node->children[0]->getKind() == IdentifierNode::kind){
         string method_id = node->children[0]->getNodeText();
-        return (
-            this->table->globals.resolve(method_id) != nullptr &&
-            this->table->globals.resolve(method_id)->getSymbolType() == "BuiltInMethodSymbol"
-        );
+        Symbol * sym = this->table->globals.resolve(method_id);
+        return dynamic_cast<BuiltInMethodSymbol*>(sym) != nullptr;
     }
     return false;
 }
@@ -1044,10 +1445,14 @@ Object * Interpreter::builtInTypeAttribute(Object * obj, string attribute){
 
 Object * Interpreter::builtInTypeMethodCall(Object * obj, string method_id, AST * params){
     Array * paramsArray = new Array();
+    this->protect(obj);
+    this->protect(paramsArray);
 
     // populate array with exec'd params
     for (int i=0; i<params->children.size(); i++){
-        paramsArray->value.push_back(this->exec(params->children[i]));
+        Object * param = this->exec(params->children[i]);
+        paramsArray->value.push_back(param);
+        Heap::instance().writeBarrier(paramsArray, param);
     }
 
     return obj->builtIn(method_id, paramsArray);
@@ -1067,13 +1472,13 @@ Object * Interpreter::methodCall(AST * node){
     // determine method identifier name
     AST * firstId = node->children[0];
     string method_id;
-    if (firstId->getType() == MemberAccessNode::type){
+    if (firstId->getKind() == MemberAccessNode::kind){
         method_id = firstId->children[firstId->getChildCount()-1]->getNodeText();
     }else{
         method_id = firstId->getNodeText();
     }
 
-    if (firstId->getType() == MemberAccessNode::type){
+    if (firstId->getKind() == MemberAccessNode::kind){
         AST * a = firstId->children[0];
         AST * z = firstId->children[firstId->children.size() - 1];
 
@@ -1084,13 +1489,13 @@ Object * Interpreter::methodCall(AST * node){
         // for remaining siblings, load left to right
         for (int i=1; i<firstId->children.size()-1; i++){
             AST * member = firstId->children[i];
-            if (member->getType() == IdentifierNode::type){
+            if (member->getKind() == IdentifierNode::kind){
                 obj = dynamic_cast<ClassInstance*>(obj)->get(member->getNodeText());
             }
-            else if (member->getType() == IndexNode::type){
+            else if (member->getKind() == IndexNode::kind){
                 obj = obj->index(this->exec(member));
             }
-            else if (member->getType() == MemberAccessNode::type){
+            else if (member->getKind() == MemberAccessNode::kind){
                 obj = obj->index(this->exec(member));
             }
             else{
@@ -1133,6 +1538,7 @@ Object * Interpreter::methodCall(AST * node){
     MethodSpace * methSpace = new MethodSpace(method_sym);
     MemorySpace * saveSpace = currentSpace;
     currentSpace = methSpace;
+    this->protect(obj);
 
     // add class instance and super to method space
     if (class_inst != nullptr){
@@ -1168,11 +1574,17 @@ Object * Interpreter::methodCall(AST * node){
     this->stack.push(methSpace);
     try{
         this->exec(methBlock);
-    }catch (const ReturnValue rv){
-        result = rv.value;
+    }catch (...){
+        this->stack.pop();
+        currentSpace = saveSpace;
+        delete methSpace;
+        throw;
     }
+    if (completion == COMPLETION_RETURN) result = returnValue;
+    completion = COMPLETION_NORMAL;
     this->stack.pop();
     currentSpace = saveSpace;
+    delete methSpace;
     return result;
 };
 
@@ -1203,10 +1615,10 @@ ClassInstance * Interpreter::classInstantiation(AST * node){
     ClassInstance * class_instance;
     Object * obj = nullptr;
 
-    if (lhs->getType() == MemberAccessNode::type){
+    if (lhs->getKind() == MemberAccessNode::kind){
         className = lhs->children[int(lhs->children.size()) - 1]->getNodeText();
     }
-    else if (lhs->getType() == IdentifierNode::type){
+    else if (lhs->getKind() == IdentifierNode::kind){
         className = lhs->getNodeText();
     }
     else{
@@ -1214,7 +1626,7 @@ ClassInstance * Interpreter::classInstantiation(AST * node){
     }
 
     // TODO: consolidate with methodCall logic
-    if (lhs->getType() == MemberAccessNode::type){
+    if (lhs->getKind() == MemberAccessNode::kind){
         AST * a = lhs->children[0];
         AST * z = lhs->children[lhs->children.size() - 1];
         obj = this->load(a);
@@ -1222,13 +1634,13 @@ ClassInstance * Interpreter::classInstantiation(AST * node){
         // for remaining siblings, load left to right
         for (int i=1; i<lhs->children.size()-1; i++){
             AST * member = lhs->children[i];
-            if (member->getType() == IdentifierNode::type){
+            if (member->getKind() == IdentifierNode::kind){
                 obj = dynamic_cast<ClassInstance*>(obj)->get(member->getNodeText());
             }
-            else if (member->getType() == IndexNode::type){
+            else if (member->getKind() == IndexNode::kind){
                 obj = obj->index(this->exec(member));
             }
-            else if (member->getType() == MemberAccessNode::type){
+            else if (member->getKind() == MemberAccessNode::kind){
                 obj = obj->index(this->exec(member));
             }
             else{
@@ -1256,6 +1668,8 @@ ClassInstance * Interpreter::classInstantiation(AST * node){
         throw RuntimeError("invalid ClassSymbol '" + className + "'");
     }
  
+    this->protect(class_instance);
+
     // look for init method
     MethodSymbol * initSymbol = static_cast<MethodSymbol*>(class_instance->symbol->resolveMember("init"));
 
@@ -1297,11 +1711,17 @@ ClassInstance * Interpreter::classInstantiation(AST * node){
         this->stack.push(methSpace);
         try{
             this->exec(methBlock);
-        }catch (const ReturnValue rv){
-            result = rv.value;
+        }catch (...){
+            this->stack.pop();
+            currentSpace = saveSpace;
+            delete methSpace;
+            throw;
         }
+        if (completion == COMPLETION_RETURN) result = returnValue;
+        completion = COMPLETION_NORMAL;
         this->stack.pop();
         currentSpace = saveSpace;
+        delete methSpace;
     }
 
     return class_instance;
@@ -1311,38 +1731,56 @@ Object * Interpreter::identifier(AST * node){
     return this->load(node);
 };
 
+/**
+ * Evaluates an operand of arithmetic or a comparison. Unlike exec, locals
+ * and integer sums, differences and products may come back as tagged
+ * integers (see SmallInteger), so counting loops allocate nothing.
+ */
+Object * Interpreter::operand(AST * node){
+    Object * value = nullptr;
+    switch (node->getKind()){
+        case IdentifierNode::kind:
+            value = this->loadValue(node);
+            break;
+        case ParenthesesNode::kind:
+            if (node->getChildCount() != 1) return this->exec(node);
+            return this->operand(node->children[0]);
+        case AddExpressionNode::kind: {
+            Object * value1 = this->operand(node->children[0]);
+            value = SmallInteger::add(value1, this->operand(node->children[1]));
+            break;
+        }
+        case SubtractExpressionNode::kind: {
+            Object * value1 = this->operand(node->children[0]);
+            value = SmallInteger::subtract(value1, this->operand(node->children[1]));
+            break;
+        }
+        case MultiplyExpressionNode::kind: {
+            Object * value1 = this->operand(node->children[0]);
+            value = SmallInteger::multiply(value1, this->operand(node->children[1]));
+            break;
+        }
+        default:
+            return this->exec(node);
+    }
+    this->protect(value);
+    return value;
+};
+
 Object * Interpreter::memberAccess(AST * node){
     return this->load(node);
 };
 
 Object * Interpreter::add(AST * node){
-    AST * lhs = node->children[0];
-    AST * rhs = node->children[1];  
-
-    Object * value1 = this->exec(lhs);
-    Object * value2 = this->exec(rhs);
-
-    return value1->add(value2);
+    return SmallInteger::box(this->operand(node));
 };
 
 Object * Interpreter::subtract(AST * node){
-    AST * lhs = node->children[0];
-    AST * rhs = node->children[1];  
-
-    Object * value1 = this->exec(lhs);
-    Object * value2 = this->exec(rhs);
-
-    return value1->subtract(value2);
+    return SmallInteger::box(this->operand(node));
 };
 
 Object * Interpreter::multiply(AST * node){
-    AST * lhs = node->children[0];
-    AST * rhs = node->children[1];  
-
-    Object * value1 = this->exec(lhs);
-    Object * value2 = this->exec(rhs);
-
-    return value1->multiply(value2);
+    return SmallInteger::box(this->operand(node));
 };
 
 Object * Interpreter::divide(AST * node){
@@ -1371,55 +1809,46 @@ Object * Interpreter::divide(AST * node){
 void Interpreter::addAssign(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];
-    Object * value = this->exec(rhs);
+    Object * value = this->operand(rhs);
 
-    if (lhs->getType() == MemberAccessNode::type){
+    if (lhs->getKind() == MemberAccessNode::kind){
         Object * curValue = this->memberLoad(lhs);
-        this->memberAssign(lhs, curValue->add(value));
+        this->memberAssign(lhs, SmallInteger::box(SmallInteger::add(curValue, value)));
         return;
     }
 
-    MemorySpace * space = this->getSpaceWithSymbol(lhs);
-    if (space == nullptr) space = currentSpace;
-    
-    Object * curValue = space->get(lhs->getNodeText());
-    space->put(lhs->getNodeText(), curValue->add(value));
+    Object * curValue = this->loadValue(lhs);
+    this->store(lhs, SmallInteger::add(curValue, value));
 };
 
 void Interpreter::subtractAssign(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];
-    Object * value = this->exec(rhs);
+    Object * value = this->operand(rhs);
 
-    if (lhs->getType() == MemberAccessNode::type){
+    if (lhs->getKind() == MemberAccessNode::kind){
         Object * curValue = this->memberLoad(lhs);
-        this->memberAssign(lhs, curValue->subtract(value));
+        this->memberAssign(lhs, SmallInteger::box(SmallInteger::subtract(curValue, value)));
         return;
     }
 
-    MemorySpace * space = this->getSpaceWithSymbol(lhs);
-    if (space == nullptr) space = currentSpace;
-    
-    Object * curValue = space->get(lhs->getNodeText());
-    space->put(lhs->getNodeText(), curValue->subtract(value));
+    Object * curValue = this->loadValue(lhs);
+    this->store(lhs, SmallInteger::subtract(curValue, value));
 };
 
 void Interpreter::multiplyAssign(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];
-    Object * value = this->exec(rhs);
+    Object * value = this->operand(rhs);
 
-    if (lhs->getType() == MemberAccessNode::type){
+    if (lhs->getKind() == MemberAccessNode::kind){
         Object * curValue = this->memberLoad(lhs);
-        this->memberAssign(lhs, curValue->multiply(value));
+        this->memberAssign(lhs, SmallInteger::box(SmallInteger::multiply(curValue, value)));
         return;
     }
 
-    MemorySpace * space = this->getSpaceWithSymbol(lhs);
-    if (space == nullptr) space = currentSpace;
-    
-    Object * curValue = space->get(lhs->getNodeText());
-    space->put(lhs->getNodeText(), curValue->multiply(value));
+    Object * curValue = this->loadValue(lhs);
+    this->store(lhs, SmallInteger::multiply(curValue, value));
 };
 
 void Interpreter::divideAssign(AST * node){
@@ -1427,17 +1856,14 @@ void Interpreter::divideAssign(AST * node){
     AST * rhs = node->children[1];
     Object * value = this->exec(rhs);
 
-    if (lhs->getType() == MemberAccessNode::type){
+    if (lhs->getKind() == MemberAccessNode::kind){
         Object * curValue = this->memberLoad(lhs);
         this->memberAssign(lhs, curValue->divide(value));
         return;
     }
 
-    MemorySpace * space = this->getSpaceWithSymbol(lhs);
-    if (space == nullptr) space = currentSpace;
-    
-    Object * curValue = space->get(lhs->getNodeText());
-    space->put(lhs->getNodeText(), curValue->divide(value));
+    Object * curValue = this->load(lhs);
+    this->store(lhs, curValue->divide(value));
 };
 
 Object * Interpreter::parentheses(AST * node){
@@ -1450,34 +1876,34 @@ Object * Interpreter::parentheses(AST * node){
 };
 
 Integer * Interpreter::literalInt(AST * node){
-    return new Integer(node->getNodeText());
+    return static_cast<Integer*>(ConstantVisitor::materialize(node));
 };
 
 String * Interpreter::literalString(AST * node){
-    string data = Util::escape_raw_string(node->getNodeText());
-    return new String(data);
+    return static_cast<String*>(ConstantVisitor::materialize(node));
 };
 
 Decimal * Interpreter::literalDecimal(AST * node){
-    return new Decimal(node->getNodeText());
+    return static_cast<Decimal*>(ConstantVisitor::materialize(node));
 };
 
 Boolean * Interpreter::literalBool(AST * node){
-    return new Boolean(node->getNodeText());
+    return static_cast<Boolean*>(ConstantVisitor::materialize(node));
 };
 
 None * Interpreter::literalNone(AST * node){
-    // return new None(node->getNodeText());
-    return new None();
+    return static_cast<None*>(ConstantVisitor::materialize(node));
 };
 
 Object * Interpreter::returnStatement(AST * node){
-    this->sharedReturnValue.value = this->exec(node->children[0]);
-    throw this->sharedReturnValue;
+    this->returnValue = this->exec(node->children[0]);
+    this->completion = COMPLETION_RETURN;
+    return this->returnValue;
 };
 
 Dictionary * Interpreter::dictionary(AST * node){
     Dictionary * dict = new Dictionary();
+    this->protect(dict);
 
     // initialize dict value members
     for(int i=0; i<node->children.size(); i++){
@@ -1485,7 +1911,11 @@ Dictionary * Interpreter::dictionary(AST * node){
         AST * key = kvPair->children[0];
         AST * value = kvPair->children[1];
 
-        dict->value[this->exec(key)] = this->exec(value);
+        Object * keyObj = this->exec(key);
+        Object * valueObj = this->exec(value);
+        dict->value.put(keyObj, valueObj);
+        Heap::instance().writeBarrier(dict, keyObj);
+        Heap::instance().writeBarrier(dict, valueObj);
     }
     
     return dict;
@@ -1526,60 +1956,60 @@ Boolean * Interpreter::boolEquals(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];  
 
-    Object * value1 = this->exec(lhs);
-    Object * value2 = this->exec(rhs);
+    Object * value1 = this->operand(lhs);
+    Object * value2 = this->operand(rhs);
 
-    return dynamic_cast<Boolean *>(value1->equals(value2));
+    return SmallInteger::equals(value1, value2);
 };
 
 Boolean * Interpreter::boolNotEquals(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];  
 
-    Object * value1 = this->exec(lhs);
-    Object * value2 = this->exec(rhs);
+    Object * value1 = this->operand(lhs);
+    Object * value2 = this->operand(rhs);
 
-    return dynamic_cast<Boolean *>(value1->notEquals(value2));
+    return SmallInteger::notEquals(value1, value2);
 };
 
 Boolean * Interpreter::boolLessThan(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];  
 
-    Object * value1 = this->exec(lhs);
-    Object * value2 = this->exec(rhs);
+    Object * value1 = this->operand(lhs);
+    Object * value2 = this->operand(rhs);
 
-    return dynamic_cast<Boolean*>(value1->lessThan(value2));
+    return SmallInteger::lessThan(value1, value2);
 };
 
 Boolean * Interpreter::boolLessThanOrEqual(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];  
 
-    Object * value1 = this->exec(lhs);
-    Object * value2 = this->exec(rhs);
+    Object * value1 = this->operand(lhs);
+    Object * value2 = this->operand(rhs);
 
-    return dynamic_cast<Boolean *>(value1->lessThanOrEqual(value2));
+    return SmallInteger::lessThanOrEqual(value1, value2);
 };
 
 Boolean * Interpreter::boolGreaterThan(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];  
 
-    Object * value1 = this->exec(lhs);
-    Object * value2 = this->exec(rhs);
+    Object * value1 = this->operand(lhs);
+    Object * value2 = this->operand(rhs);
 
-    return dynamic_cast<Boolean*>(value1->greaterThan(value2));
+    return SmallInteger::greaterThan(value1, value2);
 };
 
 Boolean * Interpreter::boolGreaterThanOrEqual(AST * node){
     AST * lhs = node->children[0];
     AST * rhs = node->children[1];  
 
-    Object * value1 = this->exec(lhs);
-    Object * value2 = this->exec(rhs);
+    Object * value1 = this->operand(lhs);
+    Object * value2 = this->operand(rhs);
 
-    return dynamic_cast<Boolean *>(value1->greaterThanOrEqual(value2));
+    return SmallInteger::greaterThanOrEqual(value1, value2);
 };
 
 Integer * Interpreter::bitShiftLeft(AST * node){
@@ -1647,17 +2077,14 @@ void Interpreter::bitOrAssign(AST * node){
     AST * rhs = node->children[1];
     Object * value = this->exec(rhs);
 
-    if (lhs->getType() == MemberAccessNode::type){
+    if (lhs->getKind() == MemberAccessNode::kind){
         Object * curValue = this->memberLoad(lhs);
         this->memberAssign(lhs, curValue->bitOr(value));
         return;
     }
 
-    MemorySpace * space = this->getSpaceWithSymbol(lhs);
-    if (space == nullptr) space = currentSpace;
-    
-    Object * curValue = space->get(lhs->getNodeText());
-    space->put(lhs->getNodeText(), curValue->bitOr(value));
+    Object * curValue = this->load(lhs);
+    this->store(lhs, curValue->bitOr(value));
 };
 
 void Interpreter::bitAndAssign(AST * node){
@@ -1665,17 +2092,14 @@ void Interpreter::bitAndAssign(AST * node){
     AST * rhs = node->children[1];
     Object * value = this->exec(rhs);
 
-    if (lhs->getType() == MemberAccessNode::type){
+    if (lhs->getKind() == MemberAccessNode::kind){
         Object * curValue = this->memberLoad(lhs);
         this->memberAssign(lhs, curValue->bitAnd(value));
         return;
     }
 
-    MemorySpace * space = this->getSpaceWithSymbol(lhs);
-    if (space == nullptr) space = currentSpace;
-    
-    Object * curValue = space->get(lhs->getNodeText());
-    space->put(lhs->getNodeText(), curValue->bitAnd(value));
+    Object * curValue = this->load(lhs);
+    this->store(lhs, curValue->bitAnd(value));
 };
 
 Integer * Interpreter::bitXor(AST * node){
@@ -1695,14 +2119,7 @@ void Interpreter::tryStatement(AST * node){
     }
     catch(const AST * raiseNode){
         string exceptionId = raiseNode->children[0]->getNodeText();
-        string exceptionMessage;
-        if (raiseNode->children.size() == 2){
-            if (raiseNode->children[1]->getChildCount() == 1){
-                AST * excMsg = raiseNode->children[1]->children[0];
-                exceptionMessage = this->exec(excMsg)->toString();
-            }
-        }
-        this->catchStatement(node, exceptionId, exceptionMessage, nullptr);
+        this->catchStatement(node, exceptionId, this->raiseMessage, nullptr);
     }
     catch(TimeoutError e){
         this->catchStatement(node, e.getType(), e.what(), &e);
@@ -1812,15 +2229,24 @@ AST * Interpreter::getGenericCatch(AST * node){
             return catchItem;
         }
     }
+    return nullptr;
+};
+
+void Interpreter::catchStatement(AST * node, string exceptionId, string exceptionMessage, void * exception){
+    this->block(this->selectCatch(node, exceptionId, exceptionMessage, exception));
 };
 
-void Interpreter::catchStatement(AST * node, string exceptionId, string exceptionMessage, void * exception){    
+/**
+ * Binds the exception for an 'as' statement and returns the block of the
+ * matching catch, or the generic catch. Throws if none applies.
+ */
+AST * Interpreter::selectCatch(AST * node, string exceptionId, string exceptionMessage, void * exception){
     AST * catchNode = nullptr;
     for(int i = 1; i<node->children.size(); i++){
         AST * catchItem = node->children[i];
 
         // skip if no params list, it's a generic catch block
-        if (catchItem->children[0]->getType() != ParamsListNode::type){
+        if (catchItem->children[0]->getKind() != ParamsListNode::kind){
             continue; 
         }
 
@@ -1830,7 +2256,7 @@ void Interpreter::catchStatement(AST * node, string exceptionId, string exceptio
             AST * paramItem = paramsList->children[z];
 
             // if 'as' statement
-            if (paramItem->getType() == AsNode::type){
+            if (paramItem->getKind() == AsNode::kind){
                 AST * lhs = paramItem->children[0];
                 AST * rhs = paramItem->children[1];
             
@@ -1841,13 +2267,8 @@ void Interpreter::catchStatement(AST * node, string exceptionId, string exceptio
                     Symbol * catchNodeIdSym = lhs->scope->resolve(catchNodeId);
 
                     if (dynamic_cast<BuiltInTypeSymbol*>(catchNodeIdSym) != nullptr){
-                        if (exception != nullptr){
-                            // cast built-in exception
-                            this->currentSpace->put(catchNodeAsId, ExceptionUtil::castException(exceptionId, exception));
-                        }else{
-                            // create built-in exception
-                            this->currentSpace->put(catchNodeAsId, ExceptionUtil::createException(exceptionId, exceptionMessage));
-                        }
+                        // create built-in exception, a caught one only lives until its catch ends
+                        this->currentSpace->put(catchNodeAsId, ExceptionUtil::createException(exceptionId, exceptionMessage));
                     }
                     else if (dynamic_cast<ClassSymbol*>(catchNodeIdSym) != nullptr){
                         ClassException * classExc = new ClassException(catchNodeId, exceptionMessage);
@@ -1867,18 +2288,17 @@ void Interpreter::catchStatement(AST * node, string exceptionId, string exceptio
         }
     }
 
-    // if specific catchnode was found, call it
+    // if specific catchnode was found, use it
     if (catchNode != nullptr){
-        this->block(catchNode->children[1]);
-        return;
+        return catchNode->children[1];
     }
 
-    // if generic catch was found, call it, else throw exception
+    // if generic catch was found, use it, else throw exception
     AST * genericCatch = this->getGenericCatch(node);
     if (genericCatch != nullptr){
-        this->block(genericCatch->children[0]);
+        return genericCatch->children[0];
     }
-    else throw Exception();
+    throw Exception();
 };
 
 bool Interpreter::isClassOrInheritsFrom(string className, string match){
@@ -1903,6 +2323,13 @@ bool Interpreter::isClassOrInheritsFrom(string className, string match){
 }
 
 void Interpreter::raiseStatement(AST * node){
+    this->raiseMessage = "";
+    if (node->children.size() == 2){
+        if (node->children[1]->getChildCount() == 1){
+            AST * excMsg = node->children[1]->children[0];
+            this->raiseMessage = this->exec(excMsg)->toString();
+        }
+    }
     throw node;
 };
 
@@ -1932,20 +2359,17 @@ void Interpreter::whileStatement(AST * node){
     AST * lhs = node->children[0];  // bool condition
     AST * rhs = node->children[1];  // block of events
 
+    size_t mark = this->temporaries.size();
     while (this->exec(lhs)->toString() == Literals::TRUE){
-        try{
-            this->block(rhs);
-        }
-        catch(const BreakInterrupt){
-            break;
-        }
+        if (!this->loopBlock(rhs)) break;
+        this->temporaries.resize(mark);
     }
 };
 
 void Interpreter::skipStatement(AST * node){
-    if (node->hasAncestor(WhileStatementNode::type) || 
-        node->hasAncestor(ForStatementNode::type)){
-            throw BreakInterrupt();
+    if (node->hasAncestor(WhileStatementNode::kind) || 
+        node->hasAncestor(ForStatementNode::kind)){
+            this->completion = COMPLETION_BREAK;
     }
     else{
         throw SyntaxError("syntax error: 'skip' not properly in loop");
@@ -1958,13 +2382,11 @@ void Interpreter::forStatement(AST * node){
     AST * increment = node->children[2];
     AST * block = node->children[3];
 
-    for(this->exec(varDeclaration); this->exec(condition)->toString() == Literals::TRUE; this->exec(increment)){
-        try{
-            this->block(block);
-        }
-        catch(const BreakInterrupt){
-            break;
-        }
+    this->exec(varDeclaration);
+    size_t mark = this->temporaries.size();
+    for(; this->exec(condition)->toString() == Literals::TRUE; this->exec(increment)){
+        if (!this->loopBlock(block)) break;
+        this->temporaries.resize(mark);
     }
 };
 
@@ -1973,49 +2395,65 @@ void Interpreter::eachStatement(AST * node){
     AST * iterable = node->children[1];
     AST * block = node->children[2];
 
-    string varId = varDeclaration->children[0]->getNodeText();
+    AST * varId = varDeclaration->children[0];
     this->exec(varDeclaration);
     
     // iterate through each element
-    Object * iterObj = this->exec(iterable);
+    Iterator * iterator = this->iter(this->exec(iterable));
+    this->protect(iterator);
+    size_t mark = this->temporaries.size();
 
-    if (dynamic_cast<Dictionary*>(iterObj) != nullptr){
-        // string index
-        Dictionary * iterDict = dynamic_cast<Dictionary*>(iterObj);
-        for(map<Object*,Object*>::iterator it = iterDict->value.begin(); it != iterDict->value.end(); ++it) {
-            Object * key = it->first;
+    for (Object * element = iterator->next(); element != nullptr; element = iterator->next()){
+        this->declare(varId, element);
 
-            currentSpace->put(varId, key);
-            
-            try{
-                this->block(block);
-            }
-            catch(const BreakInterrupt){
-                break;
-            }
-        }
-    }else{
-        // integer index
-        for(int i = 0; i < iterObj->getSize()->value; i++){
-            Object * element = iterObj->index(new Integer(i));
-
-            currentSpace->put(varId, element);
-            
-            try{
-                this->block(block);
-            }
-            catch(const BreakInterrupt){
-                break;
-            }
-        }
+        if (!this->loopBlock(block)) break;
+        this->temporaries.resize(mark);
     }
 };
 
 MethodSpace::MethodSpace(MethodSymbol * symbol) : 
     MemorySpace(symbol->getSymbolName()) { 
         def_symbol = symbol;
+        slots.resize(symbol->getSlotCount(), nullptr);
     };
 
+/** Returns a local from its slot, or any other name from the members map. */
+Object * MethodSpace::get(string id){
+    int index = def_symbol->resolveSlot(id);
+    if (index >= 0) return SmallInteger::box(slots[index]);
+    return MemorySpace::get(id);
+};
+
+void MethodSpace::put(string id, Object * value){
+    int index = def_symbol->resolveSlot(id);
+    if (index >= 0){
+        slots[index] = value;
+        return;
+    }
+    MemorySpace::put(id, value);
+};
+
+void MethodSpace::trace(Heap * heap){
+    for (int i=0; i<slots.size(); i++){
+        heap->mark(slots[i]);
+    }
+    MemorySpace::trace(heap);
+};
+
+string MethodSpace::toString(){
+    string output = "<MemorySpace: " + this->getName() + ">\n";
+    for (int i=0; i<slots.size(); i++){
+        if (slots[i] == nullptr) continue;
+        output += def_symbol->slotNames[i] + " - " + SmallInteger::box(slots[i])->toString() + "\n";
+    }
+    map<string, Object *>::iterator it;
+    for (it = members.begin(); it != members.end(); it++ )
+    {
+        output += it->first + " - " + it->second->toString() + "\n";
+    }
+    return output;
+};
+
 Stack::Stack(){};
 
 /** Returns the MemorySpace on the top of the stack. */
@@ -2040,14 +2478,18 @@ void Stack::pop(){
 
 MemorySpace::MemorySpace(string space_name){
     name = space_name;
+    owner = nullptr;
 };
 
 Object * MemorySpace::get(string id){
-    return members[id];
+    map<string, Object *>::iterator it = members.find(id);
+    if (it == members.end()) return nullptr;
+    return it->second;
 };
 
 void MemorySpace::put(string id, Object * value){
     members[id] = value;
+    if (owner != nullptr) Heap::instance().writeBarrier(owner, value);
 };
 
 string MemorySpace::toString(){
@@ -2060,16 +2502,20 @@ string MemorySpace::toString(){
     return output;
 };
 
+void MemorySpace::trace(Heap * heap){
+    map<string, Object *>::iterator it;
+    for (it = members.begin(); it != members.end(); it++){
+        heap->mark(it->second);
+    }
+};
+
 string MemorySpace::getName(){
     return this->name;
 }
 
-ReturnValue::ReturnValue(){};
-
-BreakInterrupt::BreakInterrupt(){};
-
 ClassInstance::ClassInstance(ClassSymbol * sym) : MemorySpace(sym->getScopeName() + " instance"){
     this->symbol = sym;
+    this->owner = this;
 };
 
 string ClassInstance::toString(){
@@ -2088,8 +2534,13 @@ Object * ClassInstance::clone(){
     return copy;
 }
 
+void ClassInstance::trace(Heap * heap){
+    MemorySpace::trace(heap);
+};
+
 ImportedInstance::ImportedInstance(ImportedModuleSymbol * sym) : MemorySpace(sym->getScopeName() + " instance"){
     this->symbol = sym;
+    this->owner = this;
 };
 
 string ImportedInstance::toString(){
@@ -2098,4 +2549,8 @@ string ImportedInstance::toString(){
 
 Object * ImportedInstance::clone(){
     return new ImportedInstance(this->symbol);
-}
\ No newline at end of file
+}
+
+void ImportedInstance::trace(Heap * heap){
+    MemorySpace::trace(heap);
+};
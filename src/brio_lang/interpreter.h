@@ -17,11 +17,14 @@ using namespace std;
 class MemorySpace {
     public:
         MemorySpace(string space_name);
-        Object * get(string id);
-        void put(string id, Object * value);
-        string toString();
+        virtual ~MemorySpace(){};
+        virtual Object * get(string id);
+        virtual void put(string id, Object * value);
+        virtual string toString();
+        virtual void trace(Heap * heap);
         string getName();
         map<string, Object *> members;
+        Object * owner;  // heap object this space belongs to, for the write barrier
     private:
         string name;
 };
@@ -29,7 +32,14 @@ class MemorySpace {
 class MethodSpace : public MemorySpace {
     public:
         MethodSpace(MethodSymbol * method);
+        Object * get(string id);
+        void put(string id, Object * value);
+        string toString();
+        void trace(Heap * heap);
+        Object * getSlot(int index){return index < slots.size() ? slots[index] : nullptr;};
+        void putSlot(int index, Object * value){slots[index] = value;};
         MethodSymbol * def_symbol;
+        vector<Object *> slots;  // locals indexed by their slot from Def.cc
     private:
 };
 
@@ -44,17 +54,13 @@ class Stack {
     private:
 };
 
-class ReturnValue{
-    public:
-        ReturnValue();
-        Object * value;
-    private:
-};
+class VM;  // forward reference: vm.h
 
-class BreakInterrupt{
-    public: 
-        BreakInterrupt();
-    private:
+// how the last statement completed, block() stops early unless normal
+enum Completion {
+    COMPLETION_NORMAL = 0,
+    COMPLETION_RETURN,          // 'return', value held in returnValue
+    COMPLETION_BREAK            // 'skip' out of the enclosing loop
 };
 
 class ClassInstance : public MemorySpace, public Object{
@@ -63,6 +69,7 @@ class ClassInstance : public MemorySpace, public Object{
         ClassSymbol * symbol;
         string toString();
         Object * clone();
+        void trace(Heap * heap);
     private:
 };
 
@@ -72,7 +79,22 @@ class ImportedInstance : public MemorySpace, public Object{
         ImportedModuleSymbol * symbol;
         string toString();
         Object * clone();
+        void trace(Heap * heap);
+    private:
+};
+
+class Interpreter;  // forward reference
+
+/** Iterates a class instance by calling its 'next' method until it returns none. */
+class ClassIterator : public Iterator {
+    public:
+        ClassIterator(Interpreter * interpreter, ClassInstance * instance, MethodSymbol * method);
+        Object * next();
+        void trace(Heap * heap);
     private:
+        Interpreter * interpreter;
+        ClassInstance * instance;
+        MethodSymbol * method;
 };
 
 class Interpreter {
@@ -81,23 +103,33 @@ class Interpreter {
         Interpreter(ProgramNode * rootNode, SymbolTable * table, string path);
         Interpreter(ProgramNode * rootNode, SymbolTable * table, vector<string> args, string path);
         void initialize(ProgramNode * rootNode, SymbolTable * symTable, string path);
+        void setEngine(string engine);
         Object * exec();
         Object * exec(AST * node);
+        Object * dispatch(AST * node);
+        void collectGarbage();
+        void safepoint();
+        void protect(Object * obj);
         void program(AST * node);
         void block(AST * node);
+        bool loopBlock(AST * node);
         void varAssignment(AST * node);
         void varDeclaration(AST * node);
         Object * methodCall(AST * node);
         bool isBuiltInType(Object * obj);
         bool isBuiltInMethodCall(AST * node);
         Object * builtInMethodCall(AST * node);
+        Object * builtInMethodCall(string method_id, vector<Object*> args);
         Object * builtInTypeMethodCall(Object * obj, string method_id, AST * params);
         Object * builtInTypeAttribute(Object * obj, string attribute);
         Object * main();
         Object * main(vector<Object*> params);
+        Object * invoke(MethodSymbol * method, vector<Object*> params, ClassInstance * class_inst);
+        Iterator * iter(Object * obj);
         void classDeclaration(AST * node);
         ClassInstance * classInstantiation(AST * node);
         Object * identifier(AST * node);
+        Object * operand(AST * node);
         Object * memberAccess(AST * node);
         Object * add(AST * node);
         Object * subtract(AST * node);
@@ -114,7 +146,7 @@ class Interpreter {
         string getImportRelativePath(AST * node);
         string getProgramPath(AST * node);
         string findImportFile(AST * node);
-        Integer * getSize(AST * node);
+        Integer * getSize(vector<Object*> args);
         Object * parentheses(AST * node);
         Integer * literalInt(AST * node);
         String * literalString(AST * node);
@@ -143,35 +175,47 @@ class Interpreter {
         Integer * bitXor(AST * node);
         void tryStatement(AST * node);
         void catchStatement(AST * node, string id, string msg, void * e);
+        AST * selectCatch(AST * node, string id, string msg, void * e);
         bool isClassOrInheritsFrom(string className, string match);
         AST * getGenericCatch(AST * node);
         AST * getSpecificCatch(string name, AST * node);
         void raiseStatement(AST * node);
-        String * traceback(AST * node);
+        String * traceback(Object * obj);
         void ifStatement(AST * node);
         void whileStatement(AST * node);
         void skipStatement(AST * node);
         void forStatement(AST * node);
         void eachStatement(AST * node);
-        void print(AST * node);
-        Object * getEnv(AST * node);
-        Object * range(AST * node);
-        Object * input(AST * node);
+        void print(vector<Object*> args);
+        Object * flush(vector<Object*> args);
+        Object * getEnv(vector<Object*> args);
+        Object * range(vector<Object*> args);
+        Object * input(vector<Object*> args);
+        Object * jsonParse(vector<Object*> args);
+        Object * jsonStringify(vector<Object*> args);
+        Object * jsonReader(vector<Object*> args);
+        Object * csvReader(vector<Object*> args);
+        Object * csvWriter(vector<Object*> args);
         Object * index(AST * node);
 
-        Boolean * boolean(AST * node);
-        String * str(AST * node);
-        Integer * integer(AST * node);
-        Decimal * decimal(AST * node);
-        String * arg(AST * node);
-
-        Object * open(AST * node);
-        Object * close(AST * node);
-        Object * httpGet(AST * node);
-        Object * httpPost(AST * node);
+        Boolean * boolean(Object * obj);
+        String * str(Object * obj);
+        Integer * integer(Object * obj);
+        Decimal * decimal(Object * obj);
+        String * arg(Object * obj);
+
+        Object * open(vector<Object*> args);
+        Object * close(Object * obj);
+        Object * httpGet(vector<Object*> args);
+        Object * httpPost(vector<Object*> args);
+        Object * httpMulti(vector<Object*> args);
+        Object * httpDownload(vector<Object*> args);
         void exit();
-        void exit(AST * node);
+        void exit(Object * obj);
         Object * load (AST *);
+        Object * loadValue(AST *);
+        void store(AST *, Object *);
+        void declare(AST *, Object *);
         Object * memberLoad (AST *);
         void memberAssign(AST *, Object *);
         MemorySpace * getSpaceWithSymbol(AST * node);
@@ -184,7 +228,12 @@ class Interpreter {
         MemorySpace * globals;
         MemorySpace * currentSpace;
         Stack stack;
-        ReturnValue sharedReturnValue;
+        Completion completion;
+        Object * returnValue;
+        vector<Object *> temporaries;  // shadow stack of values held by statements being run
+        string raiseMessage;  // evaluated in the raising frame, read by the catch
+        VM * vm;
+        friend class VM;
 };
 
 #endif  // BRIOLANG_SRC_INTERPRETER_H_
\ No newline at end of file
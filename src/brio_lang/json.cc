@@ -0,0 +1,662 @@
+///
+/// Brio Lang
+/// json.cc
+///
+/// Native JSON parser and writer
+///
+
+#include <brio_lang/json.h>
+#include <brio_lang/exceptions.h>
+
+#include <cerrno>
+#include <cmath>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+/**
+ * Returns the position of the first character at or after pos that is
+ * not JSON whitespace, or size. Compact JSON has no whitespace between
+ * tokens, so the first character is checked before scanning in blocks.
+ */
+static size_t skipWhitespace(const char * data, size_t pos, size_t size){
+    if (pos < size && data[pos] != ' ' && data[pos] != '\n' && data[pos] != '\r' && data[pos] != '\t'){
+        return pos;
+    }
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i ret = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (pos + 16 <= size){
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + pos));
+        __m128i blank = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, ret), _mm_cmpeq_epi8(chunk, tab)));
+        int other = ~_mm_movemask_epi8(blank) & 0xFFFF;
+        if (other != 0) return pos + __builtin_ctz(other);
+        pos += 16;
+    }
+#endif
+    while (pos < size && (data[pos] == ' ' || data[pos] == '\n' || data[pos] == '\r' || data[pos] == '\t')){
+        pos++;
+    }
+    return pos;
+};
+
+/**
+ * Returns the position of the first quote, backslash or control character
+ * at or after pos, or size. Everything before it is copied verbatim, both
+ * when reading and when writing a string.
+ */
+static size_t scanString(const char * data, size_t pos, size_t size){
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while (pos + 16 <= size){
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + pos));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));  // unsigned chunk <= 0x1F
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0) return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+#endif
+    while (pos < size){
+        unsigned char c = data[pos];
+        if (c == '"' || c == '\\' || c < 0x20) return pos;
+        pos++;
+    }
+    return pos;
+};
+
+static void appendUtf8(string & out, unsigned int code){
+    if (code < 0x80){
+        out.push_back(char(code));
+    }else if (code < 0x800){
+        out.push_back(char(0xC0 | (code >> 6)));
+        out.push_back(char(0x80 | (code & 0x3F)));
+    }else if (code < 0x10000){
+        out.push_back(char(0xE0 | (code >> 12)));
+        out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(char(0x80 | (code & 0x3F)));
+    }else{
+        out.push_back(char(0xF0 | (code >> 18)));
+        out.push_back(char(0x80 | ((code >> 12) & 0x3F)));
+        out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(char(0x80 | (code & 0x3F)));
+    }
+};
+
+
+/// ##################################################################
+/// JsonParser definition
+/// ##################################################################
+
+JsonParser::JsonParser(const string & text){
+    data = text.data();
+    size = text.size();
+    pos = 0;
+    offset = 0;
+};
+
+JsonParser::JsonParser(const char * text, size_t text_size, size_t text_offset){
+    data = text;
+    size = text_size;
+    pos = 0;
+    offset = text_offset;
+};
+
+/** Parses the whole text as a single JSON value. */
+Object * JsonParser::parse(){
+    this->whitespace();
+    Object * result = this->value(0);
+    this->whitespace();
+    if (this->pos != this->size){
+        this->error("unexpected data after the JSON value");
+    }
+    return result;
+};
+
+void JsonParser::error(string message){
+    throw ValueError("invalid JSON, " + message + " at position " + std::to_string(this->offset + this->pos));
+};
+
+void JsonParser::whitespace(){
+    this->pos = skipWhitespace(this->data, this->pos, this->size);
+};
+
+void JsonParser::expect(char c){
+    if (this->pos >= this->size || this->data[this->pos] != c){
+        this->error("expected '" + string(1, c) + "'");
+    }
+    this->pos++;
+};
+
+Object * JsonParser::value(int depth){
+    if (this->pos >= this->size){
+        this->error("unexpected end of input");
+    }
+
+    switch (this->data[this->pos]){
+        case '{': return this->object(depth + 1);
+        case '[': return this->array(depth + 1);
+        case '"': return this->str();
+        case 't': return this->keyword("true", Boolean::get(true));
+        case 'f': return this->keyword("false", Boolean::get(false));
+        case 'n': return this->keyword("null", None::get());
+        default: return this->number();
+    }
+};
+
+Object * JsonParser::object(int depth){
+    if (depth > MAX_DEPTH) this->error("too deeply nested");
+    this->expect('{');
+
+    Dictionary * result = new Dictionary();
+    this->whitespace();
+    if (this->pos < this->size && this->data[this->pos] == '}'){
+        this->pos++;
+        return result;
+    }
+
+    while (true){
+        if (this->pos >= this->size || this->data[this->pos] != '"'){
+            this->error("expected a string key");
+        }
+        String * key = this->str();
+        this->whitespace();
+        this->expect(':');
+        this->whitespace();
+        result->value.put(key, this->value(depth));
+        this->whitespace();
+
+        if (this->pos < this->size && this->data[this->pos] == ','){
+            this->pos++;
+            this->whitespace();
+            continue;
+        }
+        this->expect('}');
+        return result;
+    }
+};
+
+Object * JsonParser::array(int depth){
+    if (depth > MAX_DEPTH) this->error("too deeply nested");
+    this->expect('[');
+
+    Array * result = new Array();
+    this->whitespace();
+    if (this->pos < this->size && this->data[this->pos] == ']'){
+        this->pos++;
+        return result;
+    }
+
+    while (true){
+        result->value.push_back(this->value(depth));
+        this->whitespace();
+
+        if (this->pos < this->size && this->data[this->pos] == ','){
+            this->pos++;
+            this->whitespace();
+            continue;
+        }
+        this->expect(']');
+        return result;
+    }
+};
+
+/** Reads a quoted string, copying runs between escapes in one step. */
+String * JsonParser::str(){
+    this->expect('"');
+
+    String * result = new String();
+    string & out = result->value;
+    while (true){
+        size_t end = scanString(this->data, this->pos, this->size);
+        out.append(this->data + this->pos, end - this->pos);
+        this->pos = end;
+
+        if (this->pos >= this->size){
+            this->error("unterminated string");
+        }
+        char c = this->data[this->pos];
+        if (c == '"'){
+            this->pos++;
+            return result;
+        }
+        if (c != '\\'){
+            this->error("control character in string");
+        }
+
+        // escape sequence
+        if (this->pos + 1 >= this->size){
+            this->error("unterminated string");
+        }
+        char escape = this->data[this->pos + 1];
+        this->pos += 2;
+        switch (escape){
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                unsigned int code = 0;
+                for (int i=0; i<4; i++){
+                    if (this->pos >= this->size || !isxdigit((unsigned char) this->data[this->pos])){
+                        this->error("invalid unicode escape");
+                    }
+                    char h = this->data[this->pos++];
+                    code = code * 16 + (isdigit((unsigned char) h) ? h - '0' : (tolower(h) - 'a' + 10));
+                }
+
+                // a high surrogate combines with the low surrogate after it
+                if (code >= 0xD800 && code <= 0xDBFF && this->pos + 6 <= this->size
+                    && this->data[this->pos] == '\\' && this->data[this->pos + 1] == 'u'){
+                    char * end;
+                    string low(this->data + this->pos + 2, 4);
+                    unsigned int second = strtoul(low.c_str(), &end, 16);
+                    if (*end == '\0' && second >= 0xDC00 && second <= 0xDFFF){
+                        code = 0x10000 + ((code - 0xD800) << 10) + (second - 0xDC00);
+                        this->pos += 6;
+                    }
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                this->pos -= 2;
+                this->error("invalid escape");
+        }
+    }
+};
+
+/**
+ * Reads a number: an Integer without a fraction or exponent, a Decimal
+ * otherwise. Integers that do not fit an Integer and numbers that do not
+ * fit a Decimal raise rather than come back as a different value.
+ */
+Object * JsonParser::number(){
+    size_t start = this->pos;
+    bool integral = true;
+
+    if (this->pos < this->size && this->data[this->pos] == '-') this->pos++;
+    size_t digits = this->pos;
+    while (this->pos < this->size && isdigit((unsigned char) this->data[this->pos])) this->pos++;
+    if (this->pos == digits){
+        this->pos = start;
+        this->error("unexpected character '" + string(1, this->data[start]) + "'");
+    }
+    if (this->data[digits] == '0' && this->pos - digits > 1){
+        this->pos = digits;
+        this->error("leading zero in number");
+    }
+
+    if (this->pos < this->size && this->data[this->pos] == '.'){
+        integral = false;
+        this->pos++;
+        size_t fraction = this->pos;
+        while (this->pos < this->size && isdigit((unsigned char) this->data[this->pos])) this->pos++;
+        if (this->pos == fraction) this->error("expected digits after '.'");
+    }
+
+    if (this->pos < this->size && (this->data[this->pos] == 'e' || this->data[this->pos] == 'E')){
+        integral = false;
+        this->pos++;
+        if (this->pos < this->size && (this->data[this->pos] == '+' || this->data[this->pos] == '-')) this->pos++;
+        size_t exponent = this->pos;
+        while (this->pos < this->size && isdigit((unsigned char) this->data[this->pos])) this->pos++;
+        if (this->pos == exponent) this->error("expected digits in exponent");
+    }
+
+    string text(this->data + start, this->pos - start);
+    if (integral){
+        errno = 0;
+        long long parsed = strtoll(text.c_str(), nullptr, 10);
+        if (errno != 0 || parsed < INT_MIN || parsed > INT_MAX){
+            this->pos = start;
+            this->error("number out of range");
+        }
+        return Integer::get(int(parsed));
+    }
+    float parsed = float(strtod(text.c_str(), nullptr));
+    if (!std::isfinite(parsed)){
+        this->pos = start;
+        this->error("number out of range");
+    }
+    return new Decimal(parsed);
+};
+
+Object * JsonParser::keyword(const char * word, Object * result){
+    size_t length = strlen(word);
+    if (this->size - this->pos < length || memcmp(this->data + this->pos, word, length) != 0){
+        this->error("unexpected character '" + string(1, this->data[this->pos]) + "'");
+    }
+    this->pos += length;
+    return result;
+};
+
+
+/// ##################################################################
+/// JsonReader definition
+/// ##################################################################
+
+JsonReader::JsonReader(Object * source) : input(source, "jsonReader"){
+    pos = 0;
+    state = START;
+};
+
+/** Returns true if there is a character at pos, reading more as needed. */
+bool JsonReader::available(){
+    while (this->pos >= this->input.size()){
+        if (!this->input.fill()) return false;
+    }
+    return true;
+};
+
+void JsonReader::whitespace(){
+    while (true){
+        this->pos = skipWhitespace(this->input.data(), this->pos, this->input.size());
+        if (this->pos < this->input.size() || !this->input.fill()) return;
+    }
+};
+
+void JsonReader::expect(char c){
+    if (!this->available() || this->input.data()[this->pos] != c){
+        this->error("expected '" + string(1, c) + "'");
+    }
+    this->pos++;
+};
+
+void JsonReader::error(string message){
+    this->state = DONE;
+    throw ValueError("invalid JSON, " + message + " at position " + std::to_string(this->input.getConsumed() + this->pos));
+};
+
+/** Checks that nothing but whitespace follows the document. */
+void JsonReader::finish(){
+    this->whitespace();
+    if (this->available()){
+        this->error("unexpected data after the JSON value");
+    }
+    this->state = DONE;
+};
+
+/**
+ * Returns the offset just past the value at pos, reading chunks until
+ * the value is complete. Only nesting and strings are tracked here, the
+ * value itself is checked when it is parsed.
+ */
+size_t JsonReader::valueEnd(){
+    size_t i = this->pos;
+    int depth = 0;
+    bool inString = false;
+
+    while (true){
+        if (i >= this->input.size()){
+            if (this->input.fill()) continue;
+            if (depth == 0 && !inString && i > this->pos) return i;
+            this->error("unexpected end of input");
+        }
+
+        if (inString){
+            i = scanString(this->input.data(), i, this->input.size());
+            if (i >= this->input.size()) continue;
+
+            char c = this->input.data()[i];
+            if (c == '\\'){
+                i += 2;
+            }else{
+                i++;
+                if (c == '"'){
+                    inString = false;
+                    if (depth == 0) return i;
+                }
+            }
+            continue;
+        }
+
+        switch (this->input.data()[i]){
+            case '"':
+                inString = true;
+                break;
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0) return i;
+                if (--depth == 0) return i + 1;
+                break;
+            case ',':
+            case ' ':
+            case '\n':
+            case '\r':
+            case '\t':
+                if (depth == 0) return i;
+                break;
+        }
+        i++;
+    }
+};
+
+/** Parses the value at pos with JsonParser, once it is fully buffered. */
+Object * JsonReader::value(){
+    size_t end = this->valueEnd();
+    if (end == this->pos){
+        this->error("unexpected character '" + string(1, this->input.data()[this->pos]) + "'");
+    }
+    JsonParser parser(this->input.data() + this->pos, end - this->pos, this->input.getConsumed() + this->pos);
+    Object * result = parser.parse();
+    this->pos = end;
+    return result;
+};
+
+/** Returns the next element, or nullptr once the document is read. */
+Object * JsonReader::next(){
+    if (this->state == DONE) return nullptr;
+
+    // drop what has been read, once that is at least a chunk
+    if (this->pos >= ChunkedInput::CHUNK_SIZE){
+        this->input.discard(this->pos);
+        this->pos = 0;
+    }
+
+    this->whitespace();
+    if (this->state == START){
+        if (!this->available()){
+            this->error("unexpected end of input");
+        }
+
+        char c = this->input.data()[this->pos];
+        if (c == '['){
+            this->state = ARRAY;
+        }else if (c == '{'){
+            this->state = OBJECT;
+        }else{
+            // a single value is the only element
+            Object * result = this->value();
+            this->finish();
+            return result;
+        }
+        this->pos++;
+        this->whitespace();
+
+        // empty array or object
+        char closing = this->state == ARRAY ? ']' : '}';
+        if (this->available() && this->input.data()[this->pos] == closing){
+            this->pos++;
+            this->finish();
+            return nullptr;
+        }
+    }else{
+        // separator after the previous element
+        if (!this->available()){
+            this->error("unexpected end of input");
+        }
+        if (this->input.data()[this->pos] != ','){
+            this->expect(this->state == ARRAY ? ']' : '}');
+            this->finish();
+            return nullptr;
+        }
+        this->pos++;
+        this->whitespace();
+    }
+
+    if (this->state == ARRAY){
+        return this->value();
+    }
+
+    if (!this->available() || this->input.data()[this->pos] != '"'){
+        this->error("expected a string key");
+    }
+    Object * key = this->value();
+    this->whitespace();
+    this->expect(':');
+    this->whitespace();
+
+    Array * pair = new Array();
+    pair->value.push_back(key);
+    pair->value.push_back(this->value());
+    return pair;
+};
+
+Object * JsonReader::builtIn(string method_id, Array * params){
+    if (method_id == "next"){
+        Object * result = this->next();
+        if (result == nullptr) return None::get();
+        return result;
+    }
+    throw ValueError("method '" + method_id + "' not found in " + this->getType());
+};
+
+Object * JsonReader::builtIn(string attribute){
+    throw ValueError(this->getType() + " has no member '" + attribute + "'");
+};
+
+string JsonReader::toString(){
+    return "<JsonReader>";
+};
+
+void JsonReader::trace(Heap * heap){
+    this->input.trace(heap);
+};
+
+
+/// ##################################################################
+/// JsonWriter definition
+/// ##################################################################
+
+string JsonWriter::stringify(Object * obj){
+    this->output.clear();
+    this->value(obj, 0);
+    return this->output;
+};
+
+void JsonWriter::value(Object * obj, int depth){
+    if (depth > MAX_DEPTH){
+        throw ValueError("cannot convert to JSON, too deeply nested");
+    }
+
+    if (dynamic_cast<String*>(obj) != nullptr){
+        this->str(static_cast<String*>(obj)->value);
+    }
+    else if (dynamic_cast<Decimal*>(obj) != nullptr){
+        if (!std::isfinite(static_cast<Decimal*>(obj)->value)){
+            throw ValueError("cannot convert to JSON, " + obj->toString() + " is not a finite number");
+        }
+        this->output += obj->toString();
+    }
+    else if (dynamic_cast<Integer*>(obj) != nullptr || dynamic_cast<Boolean*>(obj) != nullptr){
+        this->output += obj->toString();
+    }
+    else if (dynamic_cast<None*>(obj) != nullptr){
+        this->output += "null";
+    }
+    else if (dynamic_cast<Dictionary*>(obj) != nullptr){
+        Dictionary * dict = static_cast<Dictionary*>(obj);
+        this->output.push_back('{');
+        bool first = true;
+        for (HashTable::iterator it = dict->value.begin(); it != dict->value.end(); ++it){
+            if (!first) this->output += ", ";
+            first = false;
+
+            // JSON keys are always strings
+            if (dynamic_cast<String*>(it->key) != nullptr){
+                this->str(static_cast<String*>(it->key)->value);
+            }else{
+                this->str(it->key->toString());
+            }
+            this->output += ": ";
+            this->value(it->value, depth + 1);
+        }
+        this->output.push_back('}');
+    }
+    else if (dynamic_cast<Array*>(obj) != nullptr){
+        Array * arr = static_cast<Array*>(obj);
+        this->output.push_back('[');
+        for (int i=0; i<arr->value.size(); i++){
+            if (i > 0) this->output += ", ";
+            this->value(arr->value[i], depth + 1);
+        }
+        this->output.push_back(']');
+    }
+    else if (dynamic_cast<Range*>(obj) != nullptr){
+        Range * range = static_cast<Range*>(obj);
+        if (range->elements != nullptr){
+            this->value(range->elements, depth);
+        }
+        else{
+            this->output += obj->toString();
+        }
+    }
+    else{
+        throw TypeError(obj->getType() + " cannot be converted to JSON");
+    }
+};
+
+/** Writes a quoted string, copying runs that need no escaping in one step. */
+void JsonWriter::str(const string & value){
+    const char * data = value.data();
+    size_t size = value.size();
+    size_t pos = 0;
+
+    this->output.push_back('"');
+    while (pos < size){
+        size_t end = scanString(data, pos, size);
+        this->output.append(data + pos, end - pos);
+        if (end >= size) break;
+
+        char c = data[end];
+        switch (c){
+            case '"': this->output += "\\\""; break;
+            case '\\': this->output += "\\\\"; break;
+            case '\b': this->output += "\\b"; break;
+            case '\f': this->output += "\\f"; break;
+            case '\n': this->output += "\\n"; break;
+            case '\r': this->output += "\\r"; break;
+            case '\t': this->output += "\\t"; break;
+            default: {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", (unsigned char) c);
+                this->output += escape;
+            }
+        }
+        pos = end + 1;
+    }
+    this->output.push_back('"');
+};
@@ -0,0 +1,80 @@
+#ifndef BRIOLANG_SRC_JSON_H_
+#define BRIOLANG_SRC_JSON_H_
+
+#include <string>
+#include <cstddef>
+
+#include <brio_lang/object.h>
+
+using namespace std;
+
+
+/**
+ * Single pass JSON parser. Objects become Dictionaries with String keys,
+ * arrays become Arrays, null becomes none, and numbers become Integers
+ * unless they have a fraction, an exponent or do not fit in an Integer.
+ */
+class JsonParser {
+    public:
+        JsonParser(const string & text);
+        JsonParser(const char * text, size_t text_size, size_t text_offset);
+        Object * parse();
+        inline static const int MAX_DEPTH = 512;  // nested arrays and objects
+    private:
+        Object * value(int depth);
+        Object * object(int depth);
+        Object * array(int depth);
+        String * str();
+        Object * number();
+        Object * keyword(const char * word, Object * result);
+        void whitespace();
+        void expect(char c);
+        void error(string message);
+        const char * data;
+        size_t size;
+        size_t pos;
+        size_t offset;  // of data in the whole document, for errors
+};
+
+/**
+ * Reads a JSON document from a File or a String one element at a time.
+ * A top-level array yields its elements, a top-level object yields
+ * [key, value] pairs and any other value is yielded once. Files are read
+ * in chunks, so only the current element and one chunk are in memory.
+ */
+class JsonReader : public Iterator {
+    public:
+        JsonReader(Object * source);
+        string getType(){return "JsonReader";};
+        Object * next();
+        Iterator * iter(){return this;};
+        Object * builtIn(string method_id, Array * params);
+        Object * builtIn(string attribute);
+        string toString();
+        void trace(Heap * heap);
+    private:
+        enum State { START, ARRAY, OBJECT, DONE };
+        bool available();
+        void whitespace();
+        void expect(char c);
+        void finish();
+        void error(string message);
+        Object * value();
+        size_t valueEnd();
+        ChunkedInput input;
+        size_t pos;
+        State state;
+};
+
+/** Serializes Dictionaries, Arrays and primitive values to JSON text. */
+class JsonWriter {
+    public:
+        string stringify(Object * obj);
+        inline static const int MAX_DEPTH = 512;
+    private:
+        void value(Object * obj, int depth);
+        void str(const string & value);
+        string output;
+};
+
+#endif  // BRIOLANG_SRC_JSON_H_
@@ -7,15 +7,84 @@
 #include <brio_lang/token.h>
 #include <brio_lang/exceptions.h>
 #include <brio_lang/util.h>
+#include <brio_lang/output.h>
 
 #include <math.h>
+#include <functional>
+#include <cstring>
+#include <climits>
+#include <sstream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BRIO_X86_DISPATCH
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 
+/**
+ * Excludes a shared instance from garbage collection
+ */
+template <class T> T * pinned(T * obj){
+    Heap::instance().pin(obj);
+    return obj;
+};
+
+#ifdef BRIO_X86_DISPATCH
+/**
+ * Scans 32 bytes at a time for a '\r'. Compiled for AVX2 whatever the
+ * build flags, so it must only run once the cpu is known to support it.
+ * Returns the match, or where fewer than 32 bytes are left.
+ */
+__attribute__((target("avx2")))
+static size_t findCarriageReturnAvx2(const char * data, size_t pos, size_t size){
+    const __m256i ret = _mm256_set1_epi8('\r');
+    while (pos + 32 <= size){
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(data + pos));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, ret));
+        if (mask != 0) return pos + __builtin_ctz(mask);
+        pos += 32;
+    }
+    return pos;
+};
+
+static bool supportsAvx2(){
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+};
+#endif
+
+/**
+ * Returns the position of the first '\r' at or after pos, or size. Scans
+ * 32 bytes at a time on cpus with AVX2, detected at run time since builds
+ * target baseline x86-64, and 16 at a time with SSE2.
+ */
+static size_t findCarriageReturn(const char * data, size_t pos, size_t size){
+#ifdef BRIO_X86_DISPATCH
+    static const bool avx2 = supportsAvx2();
+    if (avx2) pos = findCarriageReturnAvx2(data, pos, size);
+#endif
+#ifdef __SSE2__
+    const __m128i ret16 = _mm_set1_epi8('\r');
+    while (pos + 16 <= size){
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + pos));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, ret16));
+        if (mask != 0) return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+#endif
+    while (pos < size && data[pos] != '\r'){
+        pos++;
+    }
+    return pos;
+};
+
 /**
  * Generic error message if an operrator is not supported
  */
 Object * invalidOp(Object* lhs, string op, Object* rhs){
-    std::cout << lhs->getType() + " does not support '" + op + "' with " + rhs->getType() << std::endl;
+    Output::instance().write(lhs->getType() + " does not support '" + op + "' with " + rhs->getType() + "\n");
     return nullptr;
 };
 
@@ -24,7 +93,33 @@ Object * invalidOp(Object* lhs, string op, Object* rhs){
 /// Object definition
 /// ##################################################################
 
-Object::Object(){};
+/**
+ * Objects allocated with new register with the Heap and are freed once
+ * unreachable; locals and thrown exceptions are left alone.
+ */
+Object::Object(){
+    this->marked = false;
+    this->young = false;
+    this->old = false;
+    this->remembered = false;
+    Heap::instance().track(this);
+};
+
+Object::Object(const Object & obj){
+    this->marked = false;
+    this->young = false;
+    this->old = false;
+    this->remembered = false;
+    Heap::instance().track(this);
+};
+
+void * Object::operator new(size_t size){
+    return Heap::instance().allocate(size);
+};
+
+void Object::operator delete(void * memory){
+    Heap::instance().deallocate(memory);
+};
 
 Object * Object::clone(){return nullptr;};
 
@@ -48,6 +143,24 @@ Boolean * Object::notEquals(Object * o){
     return static_cast<Boolean*>(invalidOp(this, "!=", o));
 };
 
+/**
+ * Objects without their own key protocol are equal keys when they print
+ * the same and have the same type.
+ */
+size_t Object::hash(){
+    return std::hash<string>()(this->getType() + ":" + this->toString());
+};
+
+bool Object::keyEquals(Object * o){
+    if (o == this) return true;
+    return o->toString() == this->toString() && o->getType() == this->getType();
+};
+
+/** Objects without their own iterator are stepped through by index. */
+Iterator * Object::iter(){
+    return new IndexIterator(this);
+};
+
 Object * Object::add(Object * o){
     return invalidOp(this, "add", o);
 };
@@ -124,14 +237,33 @@ Boolean * Object::lessThanOrEqual(Object* o){
 /// String definition
 /// ##################################################################
 
-String::String(){};
+String::String(){
+    this->hashed = false;
+};
 
 String::String(Object * obj){
     this->value = obj->toString();
+    this->hashed = false;
 };
 
 String::String(string str_value){
     this->value = str_value;
+    this->hashed = false;
+};
+
+/**
+ * Returns the shared single character string for c; strings are never
+ * modified in place, so indexing and iteration can hand out the same one.
+ */
+String * String::character(char c){
+    static String * cache[256] = {};
+    String *& cached = cache[(unsigned char) c];
+    if (cached == nullptr) cached = pinned(new String(string(1, c)));
+    return cached;
+};
+
+Iterator * String::iter(){
+    return new StringIterator(this);
 };
 
 Object * String::builtIn(string method_id, Array * params){
@@ -200,19 +332,23 @@ String * String::format(Array * params){
 }
 
 Boolean * String::isDigit(Array * params){
-    return new Boolean(isdigit(this->value[0]));
+    return Boolean::get(isdigit(this->value[0]));
 };
 
 Boolean * String::isAlpha(Array * params){
-    return new Boolean(isalpha(this->value[0]));
+    return Boolean::get(isalpha(this->value[0]));
 };
 
 string String::toString(){
     return this->value;
 };
 
+void String::writeTo(ostream & out){
+    out << this->value;
+};
+
 Integer * String::getSize(){
-    return new Integer(size(this->value));
+    return Integer::get(this->value.size());
 }
 
 Object * String::add(Object * obj){
@@ -245,7 +381,7 @@ Boolean * String::greaterThan(Object * obj){
     if (dynamic_cast<String *>(obj) != nullptr){
         String * s = dynamic_cast<String *>(obj);
         bool result = size(this->value) > size(s->value);
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error String GT");
     }
@@ -255,7 +391,7 @@ Boolean * String::greaterThanOrEqual(Object * obj){
     if (dynamic_cast<String *>(obj) != nullptr){
         String * s = dynamic_cast<String *>(obj);
         bool result = size(this->value) >= size(s->value);
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error String GTE");
     }
@@ -265,7 +401,7 @@ Boolean * String::lessThan(Object * obj){
     if (dynamic_cast<String *>(obj) != nullptr){
         String * s = dynamic_cast<String *>(obj);
         bool result = size(this->value) < size(s->value);
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error String LT");
     }
@@ -275,7 +411,7 @@ Boolean * String::lessThanOrEqual(Object * obj){
     if (dynamic_cast<String *>(obj) != nullptr){
         String * s = dynamic_cast<String *>(obj);
         bool result = size(this->value) <= size(s->value);
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error String LTE");
     }
@@ -285,6 +421,20 @@ Object * String::clone(){
     return new String(this);
 };
 
+size_t String::hash(){
+    if (!this->hashed){
+        this->hashValue = std::hash<string>()(this->value);
+        this->hashed = true;
+    }
+    return this->hashValue;
+};
+
+bool String::keyEquals(Object * o){
+    if (o == this) return true;
+    String * str = dynamic_cast<String*>(o);
+    return str != nullptr && str->value == this->value;
+};
+
 Object * String::index(Object * obj){
     if (static_cast<Integer*>(obj) != nullptr){
         Integer * index = static_cast<Integer*>(obj);
@@ -293,9 +443,7 @@ Object * String::index(Object * obj){
         }else if (index->value < 0){
             throw IndexError("cannot access index less than 0");
         }
-        string chr_str;
-        chr_str.push_back(this->value[index->value]);
-        return new String(chr_str);
+        return String::character(this->value[index->value]);
     }else{
         throw TypeError("cannot access array index with this type");
     }
@@ -305,7 +453,7 @@ Boolean * String::equals(Object * obj){
     if (dynamic_cast<String *>(obj) != nullptr){
         String * i = dynamic_cast<String *>(obj);
         bool result = this->value == i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with String equals");
     }
@@ -315,12 +463,129 @@ Boolean * String::notEquals(Object * obj){
     if (dynamic_cast<String *>(obj) != nullptr){
         String * i = dynamic_cast<String *>(obj);
         bool result = this->value != i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with String notEquals");
     }
 };
 
+/// ##################################################################
+/// StringView definition
+/// ##################################################################
+
+StringView::StringView(shared_ptr<MappedFile> file_mapping, size_t offset){
+    mapping = file_mapping;
+    start = mapping->data() + offset;
+    length = mapping->size() - offset;
+};
+
+StringView::StringView(string file_contents){
+    contents = file_contents;
+    start = contents.data();
+    length = contents.size();
+};
+
+Integer * StringView::getSize(){
+    return Integer::fromSize(this->length);
+};
+
+Object * StringView::index(Object * obj){
+    Integer * index = dynamic_cast<Integer*>(obj);
+    if (index == nullptr){
+        throw TypeError("cannot access string index with this type");
+    }
+    if (index->value < 0){
+        throw IndexError("cannot access index less than 0");
+    }else if (size_t(index->value) >= this->length){
+        throw IndexError("cannot access element " + std::to_string(index->value) + ", max index is " + std::to_string(this->length - 1));
+    }
+    return String::character(this->start[index->value]);
+};
+
+Iterator * StringView::iter(){
+    return new StringViewIterator(this);
+};
+
+Object * StringView::builtIn(string method_id, Array * params){
+    if (method_id == "size"){
+        return this->getSize();
+    }else if (method_id == "find"){
+        return this->find(params);
+    }else if (method_id == "count"){
+        return this->count(params);
+    }else if (method_id == "split"){
+        return this->split(params);
+    }
+    throw ValueError("'" + method_id + "' not implemented for " + this->getType());
+};
+
+Object * StringView::builtIn(string attribute){
+    throw NotImplementedError("built in attribute not implemented");
+};
+
+/** Returns the index of the first occurrence of a string, or -1. */
+Integer * StringView::find(Array * params){
+    if (params->value.size() != 1 || dynamic_cast<String*>(params->value[0]) == nullptr){
+        throw ValueError("find() takes a single string object");
+    }
+    const string & needle = static_cast<String*>(params->value[0])->value;
+    const void * found = memmem(this->start, this->length, needle.data(), needle.size());
+    if (found == nullptr) return Integer::get(-1);
+    return Integer::fromSize(static_cast<const char *>(found) - this->start);
+};
+
+/** Returns the number of non-overlapping occurrences of a string. */
+Integer * StringView::count(Array * params){
+    if (params->value.size() != 1 || dynamic_cast<String*>(params->value[0]) == nullptr){
+        throw ValueError("count() takes a single string object");
+    }
+    const string & needle = static_cast<String*>(params->value[0])->value;
+    if (needle.empty()){
+        throw ValueError("count() cannot count an empty string");
+    }
+
+    size_t total = 0;
+    const char * position = this->start;
+    const char * end = this->start + this->length;
+    while (true){
+        const void * found = memmem(position, end - position, needle.data(), needle.size());
+        if (found == nullptr) break;
+        total++;
+        position = static_cast<const char *>(found) + needle.size();
+    }
+    return Integer::fromSize(total);
+};
+
+/** Splits on a single character like String.split, copying only the parts. */
+Array * StringView::split(Array * params){
+    if (params->value.size() != 1 || dynamic_cast<String*>(params->value[0]) == nullptr
+        || static_cast<String*>(params->value[0])->value.empty()){
+        throw ValueError("split() takes a single string object");
+    }
+    char separator = static_cast<String*>(params->value[0])->value[0];
+
+    Array * values = new Array();
+    const char * position = this->start;
+    const char * end = this->start + this->length;
+    while (true){
+        const char * found = static_cast<const char *>(memchr(position, separator, end - position));
+        if (found == nullptr) break;
+        values->value.push_back(new String(string(position, found - position)));
+        position = found + 1;
+    }
+    values->value.push_back(new String(string(position, end - position)));
+    return values;
+};
+
+string StringView::toString(){
+    return string(this->start, this->length);
+};
+
+void StringView::writeTo(ostream & out){
+    out.write(this->start, this->length);
+};
+
+
 /// ##################################################################
 /// Integer definition
 /// ##################################################################
@@ -354,6 +619,32 @@ Integer::Integer(string str_value){
     this->value = std::stoi(str_value);
 };
 
+/**
+ * Returns a shared Integer for small values, a new one otherwise. Integers
+ * are never modified after construction, so results can be shared.
+ */
+Integer * Integer::get(int int_value){
+    static Integer * cache[CACHE_MAX - CACHE_MIN + 1] = {};
+    if (int_value < CACHE_MIN || int_value > CACHE_MAX){
+        return new Integer(int_value);
+    }
+
+    Integer *& cached = cache[int_value - CACHE_MIN];
+    if (cached == nullptr) cached = pinned(new Integer(int_value));
+    return cached;
+};
+
+/**
+ * Returns a size, count or offset as an Integer. Views over large files
+ * can exceed what an Integer holds; those raise rather than wrap.
+ */
+Integer * Integer::fromSize(size_t size_value){
+    if (size_value > size_t(INT_MAX)){
+        throw ValueError(std::to_string(size_value) + " is too large for an Integer");
+    }
+    return Integer::get(int(size_value));
+};
+
 Object * Integer::builtIn(string attribute){
     throw NotImplementedError("built in attribute not implemented");
 }
@@ -370,7 +661,7 @@ Object * Integer::add(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         int result = this->value + i->value;
-        return new Integer(result); 
+        return Integer::get(result); 
     }
     else if(dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
@@ -386,7 +677,7 @@ Object * Integer::subtract(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         int result = this->value - i->value;
-        return new Integer(result); 
+        return Integer::get(result); 
     }
     else if(dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
@@ -402,7 +693,7 @@ Object * Integer::multiply(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         int result = this->value * i->value;
-        return new Integer(result); 
+        return Integer::get(result); 
     }else if (dynamic_cast<String *>(obj) != nullptr){
         String * value = dynamic_cast<String *>(obj);
         string result;
@@ -426,7 +717,7 @@ Object * Integer::divide(Object * obj){
         Integer * i = dynamic_cast<Integer *>(obj);
         float result = float(this->value) / float(i->value);
         if (ceil(result) == result){
-            return new Integer(result);             
+            return Integer::get(result);             
         }
         else{
             return new Decimal(result); 
@@ -447,7 +738,7 @@ Object * Integer::exponent(Object * obj){
         Integer * i = dynamic_cast<Integer *>(obj);
         float result = powf(this->value, i->value);
         if (ceil(result) == result){
-            return new Integer(result);             
+            return Integer::get(result);             
         }
         else{
             return new Decimal(result); 
@@ -467,7 +758,7 @@ Object * Integer::modulus(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         int result = this->value % i->value;
-        return new Integer(result); 
+        return Integer::get(result); 
     }
     else if(dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
@@ -483,7 +774,7 @@ Object * Integer::bitOr(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         int result = this->value | i->value;
-        return new Integer(result); 
+        return Integer::get(result); 
     }else{
         throw TypeError("error with Integer bitOr");
     }
@@ -493,7 +784,7 @@ Object * Integer::bitXor(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         int result = this->value ^ i->value;
-        return new Integer(result); 
+        return Integer::get(result); 
     }else{
         throw TypeError("error with Integer bitXor");
     }
@@ -511,7 +802,7 @@ Object * Integer::bitAnd(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         int result = this->value & i->value;
-        return new Integer(result); 
+        return Integer::get(result); 
     }else{
         throw TypeError("error with Integer bitAnd");
     }
@@ -521,12 +812,12 @@ Boolean * Integer::greaterThan(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value > i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else if(dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value > i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else{
         throw TypeError("error with Integer GT");
@@ -537,7 +828,7 @@ Integer * Integer::bitShiftRight(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         int result = this->value >> i->value;
-        return new Integer(result); 
+        return Integer::get(result); 
     }else{
         throw TypeError("error with Integer bitshiftright");
     }
@@ -547,12 +838,12 @@ Boolean * Integer::greaterThanOrEqual(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value >= i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else if(dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value >= i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else{
         throw TypeError("error with Integer GTE");
@@ -563,12 +854,12 @@ Boolean * Integer::lessThan(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value < i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else if(dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value < i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else{
         throw TypeError("error with Integer LT");
@@ -579,7 +870,7 @@ Integer * Integer::bitShiftLeft(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         int result = this->value << i->value;
-        return new Integer(result); 
+        return Integer::get(result); 
     }else{
         throw TypeError("error with Integer bitshiftleft");
     }
@@ -589,12 +880,12 @@ Boolean * Integer::lessThanOrEqual(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value <= i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else if(dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value <= i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else{
         throw TypeError("error with Integer LTE");
@@ -605,16 +896,25 @@ Object * Integer::clone(){
     return new Integer(this);
 };
 
+size_t Integer::hash(){
+    return std::hash<int>()(this->value);
+};
+
+bool Integer::keyEquals(Object * o){
+    Integer * other = dynamic_cast<Integer*>(o);
+    return other != nullptr && other->value == this->value;
+};
+
 Boolean * Integer::equals(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value == i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else if(dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value == i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else{
         throw TypeError("error with Integer equals");
@@ -625,18 +925,116 @@ Boolean * Integer::notEquals(Object * obj){
     if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value != i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else if(dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value != i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else{
         throw TypeError("error with Integer notEquals");
     }
 };
 
+/// ##################################################################
+/// SmallInteger definition
+/// ##################################################################
+
+/** Returns int_value tagged, or as an Integer where the pointer has no room for it. */
+Object * SmallInteger::tag(int int_value){
+    intptr_t bits = intptr_t(int_value);
+    if (sizeof(intptr_t) <= sizeof(int) && (bits > INTPTR_MAX / 2 || bits < INTPTR_MIN / 2)){
+        return Integer::get(int_value);
+    }
+    return reinterpret_cast<Object*>((uintptr_t(bits) << 1) | 1);
+};
+
+/** Reads a tagged value or an Integer; false for every other object. */
+bool SmallInteger::value(Object * obj, int & result){
+    if (SmallInteger::isTagged(obj)){
+        result = SmallInteger::untag(obj);
+        return true;
+    }
+    Integer * integer = dynamic_cast<Integer*>(obj);
+    if (integer == nullptr) return false;
+    result = integer->value;
+    return true;
+};
+
+// integer results wrap around like Integer::add, without signed overflow
+Object * SmallInteger::add(Object * lhs, Object * rhs){
+    int a, b;
+    if (SmallInteger::value(lhs, a) && SmallInteger::value(rhs, b)){
+        return SmallInteger::tag(int(unsigned(a) + unsigned(b)));
+    }
+    return SmallInteger::box(lhs)->add(SmallInteger::box(rhs));
+};
+
+Object * SmallInteger::subtract(Object * lhs, Object * rhs){
+    int a, b;
+    if (SmallInteger::value(lhs, a) && SmallInteger::value(rhs, b)){
+        return SmallInteger::tag(int(unsigned(a) - unsigned(b)));
+    }
+    return SmallInteger::box(lhs)->subtract(SmallInteger::box(rhs));
+};
+
+Object * SmallInteger::multiply(Object * lhs, Object * rhs){
+    int a, b;
+    if (SmallInteger::value(lhs, a) && SmallInteger::value(rhs, b)){
+        return SmallInteger::tag(int(unsigned(a) * unsigned(b)));
+    }
+    return SmallInteger::box(lhs)->multiply(SmallInteger::box(rhs));
+};
+
+Boolean * SmallInteger::equals(Object * lhs, Object * rhs){
+    int a, b;
+    if (SmallInteger::value(lhs, a) && SmallInteger::value(rhs, b)){
+        return Boolean::get(a == b);
+    }
+    return SmallInteger::box(lhs)->equals(SmallInteger::box(rhs));
+};
+
+Boolean * SmallInteger::notEquals(Object * lhs, Object * rhs){
+    int a, b;
+    if (SmallInteger::value(lhs, a) && SmallInteger::value(rhs, b)){
+        return Boolean::get(a != b);
+    }
+    return SmallInteger::box(lhs)->notEquals(SmallInteger::box(rhs));
+};
+
+Boolean * SmallInteger::lessThan(Object * lhs, Object * rhs){
+    int a, b;
+    if (SmallInteger::value(lhs, a) && SmallInteger::value(rhs, b)){
+        return Boolean::get(a < b);
+    }
+    return SmallInteger::box(lhs)->lessThan(SmallInteger::box(rhs));
+};
+
+Boolean * SmallInteger::lessThanOrEqual(Object * lhs, Object * rhs){
+    int a, b;
+    if (SmallInteger::value(lhs, a) && SmallInteger::value(rhs, b)){
+        return Boolean::get(a <= b);
+    }
+    return SmallInteger::box(lhs)->lessThanOrEqual(SmallInteger::box(rhs));
+};
+
+Boolean * SmallInteger::greaterThan(Object * lhs, Object * rhs){
+    int a, b;
+    if (SmallInteger::value(lhs, a) && SmallInteger::value(rhs, b)){
+        return Boolean::get(a > b);
+    }
+    return SmallInteger::box(lhs)->greaterThan(SmallInteger::box(rhs));
+};
+
+Boolean * SmallInteger::greaterThanOrEqual(Object * lhs, Object * rhs){
+    int a, b;
+    if (SmallInteger::value(lhs, a) && SmallInteger::value(rhs, b)){
+        return Boolean::get(a >= b);
+    }
+    return SmallInteger::box(lhs)->greaterThanOrEqual(SmallInteger::box(rhs));
+};
+
 /// ##################################################################
 /// Decimal definition
 /// ##################################################################
@@ -795,12 +1193,12 @@ Boolean * Decimal::greaterThan(Object * obj){
     if (dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value > i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value > i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else{
         throw TypeError("error with Decimal GT");
@@ -811,12 +1209,12 @@ Boolean * Decimal::greaterThanOrEqual(Object * obj){
     if (dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value >= i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value >= i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else{
         throw TypeError("error with Decimal GTE");
@@ -827,12 +1225,12 @@ Boolean * Decimal::lessThan(Object * obj){
     if (dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value < i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value < i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else{
         throw TypeError("error with Decimal LT");
@@ -843,12 +1241,12 @@ Boolean * Decimal::lessThanOrEqual(Object * obj){
     if (dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value <= i->value;
-        return new Boolean(result);
+        return Boolean::get(result);
     }
     else if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value <= i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else{
         throw TypeError("error with Decimal LTE");
@@ -859,16 +1257,25 @@ Object * Decimal::clone(){
     return new Decimal(this);
 };
 
+size_t Decimal::hash(){
+    return std::hash<float>()(this->value);
+};
+
+bool Decimal::keyEquals(Object * o){
+    Decimal * other = dynamic_cast<Decimal*>(o);
+    return other != nullptr && other->value == this->value;
+};
+
 Boolean * Decimal::equals(Object * obj){
     if (dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value == i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value == i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else{
         throw TypeError("error with Decimal equals");
@@ -879,12 +1286,12 @@ Boolean * Decimal::notEquals(Object * obj){
     if (dynamic_cast<Decimal *>(obj) != nullptr){
         Decimal * i = dynamic_cast<Decimal *>(obj);
         bool result = this->value != i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else if (dynamic_cast<Integer *>(obj) != nullptr){
         Integer * i = dynamic_cast<Integer *>(obj);
         bool result = this->value != i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }
     else{
         throw TypeError("error with Decimal notEquals");
@@ -930,6 +1337,13 @@ Boolean::Boolean(string str_value){
     }
 };
 
+/** Returns the shared 'true' or 'false' instance. */
+Boolean * Boolean::get(bool bool_value){
+    static Boolean * TRUE_VALUE = pinned(new Boolean(true));
+    static Boolean * FALSE_VALUE = pinned(new Boolean(false));
+    return bool_value ? TRUE_VALUE : FALSE_VALUE;
+};
+
 Object * Boolean::builtIn(string method_id, Array * params){
     throw NotImplementedError("built in method not implemented");
 }
@@ -979,7 +1393,7 @@ Boolean * Boolean::boolOr(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * b = dynamic_cast<Boolean *>(obj);
         bool result = this->value || b->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with Boolean OR");
     }
@@ -993,7 +1407,7 @@ Boolean * Boolean::boolAnd(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * b = dynamic_cast<Boolean *>(obj);
         bool result = this->value && b->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with Boolean AND");
     }
@@ -1003,7 +1417,7 @@ Boolean * Boolean::greaterThan(Object * obj){
     Integer intA = Integer(this);
     Integer intB = Integer(obj);
     bool result = intA.value > intB.value;
-    return new Boolean(result);
+    return Boolean::get(result);
 };
 
 Integer * Boolean::bitShiftRight(Object * obj){
@@ -1014,14 +1428,14 @@ Boolean * Boolean::greaterThanOrEqual(Object * obj){
     Integer intA = Integer(this);
     Integer intB = Integer(obj);
     bool result = intA.value >= intB.value;
-    return new Boolean(result);
+    return Boolean::get(result);
 };
 
 Boolean * Boolean::lessThan(Object * obj){
     Integer intA = Integer(this);
     Integer intB = Integer(obj);
     bool result = intA.value < intB.value;
-    return new Boolean(result);
+    return Boolean::get(result);
 };
 
 Integer * Boolean::bitShiftLeft(Object * obj){
@@ -1032,18 +1446,27 @@ Boolean * Boolean::lessThanOrEqual(Object * obj){
     Integer intA = Integer(this);
     Integer intB = Integer(obj);
     bool result = intA.value <= intB.value;
-    return new Boolean(result);
+    return Boolean::get(result);
 };
 
 Object * Boolean::clone(){
     return new Boolean(this);
 };
 
+size_t Boolean::hash(){
+    return std::hash<bool>()(this->value);
+};
+
+bool Boolean::keyEquals(Object * o){
+    Boolean * other = dynamic_cast<Boolean*>(o);
+    return other != nullptr && other->value == this->value;
+};
+
 Boolean * Boolean::equals(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * i = dynamic_cast<Boolean *>(obj);
         bool result = this->value == i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with Boolean equals");
     }
@@ -1053,7 +1476,7 @@ Boolean * Boolean::notEquals(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * i = dynamic_cast<Boolean *>(obj);
         bool result = this->value != i->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with Boolean notEquals");
     }
@@ -1073,6 +1496,12 @@ Array::Array(vector<Object*> elements){
     this->value = elements;
 };
 
+void Array::trace(Heap * heap){
+    for (int i=0; i<this->value.size(); i++){
+        heap->mark(this->value[i]);
+    }
+};
+
 Object * Array::builtIn(string attribute){
     throw NotImplementedError("built in attribute not implemented");
 }
@@ -1083,6 +1512,7 @@ Object * Array::builtIn(string method_id, Array * params){
     }
     else if (method_id == "push"){
         this->push(params);
+        return None::get();
     }
     else if (method_id == "pop"){
         return this->pop(params);
@@ -1125,28 +1555,42 @@ void Array::push(Array * params){
     }
     Object * paramValue = params->value[0];
     this->value.push_back(paramValue);
+    Heap::instance().writeBarrier(this, paramValue);
 }
 
 string Array::toString(){
-    string output = "["; 
+    ostringstream output;
+    this->writeTo(output);
+    return output.str();
+};
+
+/**
+ * Writes the elements one after the other, escaping control characters
+ * as they pass rather than escaping a copy of each element's string.
+ */
+void Array::writeTo(ostream & out){
+    ToRawStringBuffer raw(out);
+    ostream escaped(&raw);
+
+    out << "[";
     for (int i=0; i<this->value.size(); i++){
         Object * element = this->value[i];
 
         // include quotes if a string
-        string elementStr = Util::to_raw_string(element->toString());
         if (dynamic_cast<String*>(element) != nullptr){
-            output += "\"" + elementStr + "\"";            
+            out << "\"";
+            element->writeTo(escaped);
+            out << "\"";
         }else{
-            output += elementStr;
+            element->writeTo(escaped);
         }
-        if ((i+1) < this->value.size()) output += ", ";
+        if ((i+1) < this->value.size()) out << ", ";
     }
-    output.append("]");
-    return output;
+    out << "]";
 };
 
 Integer * Array::getSize(){
-    return new Integer(size(this->value));
+    return Integer::get(this->value.size());
 }
 
 Object * Array::add(Object * obj){
@@ -1217,6 +1661,10 @@ Boolean * Array::lessThanOrEqual(Object * obj){
     throw TypeError("cannot <= Array values");
 };
 
+Iterator * Array::iter(){
+    return new ArrayIterator(this);
+};
+
 Object * Array::clone(){
     return new Array(this);
 };
@@ -1249,6 +1697,13 @@ Boolean * Array::notEquals(Object * obj){
 
 Dictionary::Dictionary(){};
 
+void Dictionary::trace(Heap * heap){
+    for (HashTable::iterator it = this->value.begin(); it != this->value.end(); ++it){
+        heap->mark(it->key);
+        heap->mark(it->value);
+    }
+};
+
 Dictionary::Dictionary(Object * obj){
     if (dynamic_cast<Dictionary*>(obj) != nullptr){
         Dictionary * ptr = dynamic_cast<Dictionary*>(obj);
@@ -1259,7 +1714,7 @@ Dictionary::Dictionary(Object * obj){
 };
 
 Integer * Dictionary::getSize(){
-    return new Integer(size(this->value));
+    return Integer::get(this->value.size());
 }
 
 Object * Dictionary::builtIn(string attribute){
@@ -1291,10 +1746,8 @@ Object * Dictionary::add(Object * obj){
         Dictionary * dictUnion = dynamic_cast<Dictionary*>(this->clone());
         Dictionary * rhs = dynamic_cast<Dictionary*>(obj);
 
-        for(map<Object*,Object*>::iterator it = rhs->value.begin(); it != rhs->value.end(); ++it) {
-            Object* key = it->first;
-            Object* val = it->second;
-            dictUnion->value[key] = val;
+        for (HashTable::iterator it = rhs->value.begin(); it != rhs->value.end(); ++it){
+            dictUnion->value.put(it->key, it->value);
         }
 
         return dictUnion;
@@ -1316,14 +1769,11 @@ Object * Dictionary::pop(Array * params){
         throw TypeError("Array pop() accepts an integer or string value only.");
     }
 
-    for(map<Object*,Object*>::iterator it = this->value.begin(); it != this->value.end(); ++it) {
-        Object* key = it->first;
-        Object* val = it->second;
-
-        if (key->toString() == param->toString() && key->getType() == param->getType()){
-            this->value.erase(key);
-            return val;
-        }
+    HashTable::Entry * entry = this->value.find(param);
+    if (entry != nullptr){
+        Object * val = entry->value;
+        this->value.remove(param);
+        return val;
     }
 
     throw IndexError("Key '" + param->toString() + "' not found");
@@ -1358,12 +1808,9 @@ Boolean * Dictionary::lessThanOrEqual(Object *){
 };
 
 Object * Dictionary::index(Object * obj){
-    for(map<Object*,Object*>::iterator it = this->value.begin(); it != this->value.end(); ++it) {
-        Object* key = it->first;
-        Object* val = it->second;
-        if (key->toString() == obj->toString() && key->getType() == obj->getType()){
-            return val;
-        }
+    HashTable::Entry * entry = this->value.find(obj);
+    if (entry != nullptr){
+        return entry->value;
     }
     throw IndexError("Key '" + obj->toString() + "' not found");
 };
@@ -1372,30 +1819,280 @@ Object * Dictionary::clone(){
     return new Dictionary(this);
 };
 
+Iterator * Dictionary::iter(){
+    return new DictionaryIterator(this);
+};
+
 string Dictionary::toString(){
-    string dict = "{";
-    
-    for(map<Object*,Object*>::iterator it = this->value.begin(); it != this->value.end(); ++it) {
-        Object* key = it->first;
-        Object* val = it->second;
+    ostringstream output;
+    this->writeTo(output);
+    return output.str();
+};
+
+void Dictionary::writeTo(ostream & out){
+    out << "{";
+    bool first = true;
+    for (HashTable::iterator it = this->value.begin(); it != this->value.end(); ++it){
+        Object* key = it->key;
+        Object* val = it->value;
 
-        if (dict.size() > 1) dict += ", ";
+        if (!first) out << ", ";
+        first = false;
 
         if (dynamic_cast<String*>(key) != nullptr){
-            dict += "\"" + key->toString() + "\": ";
+            out << "\"";
+            key->writeTo(out);
+            out << "\": ";
         }else{
-            dict += key->toString() + ": ";
+            key->writeTo(out);
+            out << ": ";
         }
 
         if (dynamic_cast<String*>(val) != nullptr){
-            dict += "\"" + val->toString() + "\"";
+            out << "\"";
+            val->writeTo(out);
+            out << "\"";
         }else{
-            dict += val->toString();
+            val->writeTo(out);
+        }
+    }
+    out << "}";
+};
+
+// /// ##################################################################
+// /// Range definition
+// /// ##################################################################
+
+Range::Range(int start_value, int stop_value, int step_value){
+    if (step_value == 0){
+        throw ValueError("range step cannot be zero");
+    }
+    this->start = start_value;
+    this->stop = stop_value;
+    this->step = step_value;
+    this->elements = nullptr;
+};
+
+/** Number of elements, zero when start is already past stop. */
+int Range::length(){
+    if (this->elements != nullptr){
+        return int(this->elements->value.size());
+    }
+    long long span = (long long)this->stop - this->start;
+    if (this->step > 0 && span > 0){
+        return int((span + this->step - 1) / this->step);
+    }
+    if (this->step < 0 && span < 0){
+        return int((span + this->step + 1) / this->step);
+    }
+    return 0;
+};
+
+int Range::at(int position){
+    return this->start + position * this->step;
+};
+
+Integer * Range::getSize(){
+    return Integer::get(this->length());
+};
+
+/** Returns the Array holding the elements, copying them on first use. */
+Array * Range::materialize(){
+    if (this->elements == nullptr){
+        Array * copy = new Array();
+        int size = this->length();
+        copy->value.reserve(size);
+        for (int i=0; i<size; i++){
+            copy->value.push_back(Integer::get(this->at(i)));
         }
+        this->elements = copy;
+        Heap::instance().writeBarrier(this, copy);
+    }
+    return this->elements;
+};
+
+Object * Range::index(Object * obj){
+    if (this->elements != nullptr){
+        return this->elements->index(obj);
     }
+    Integer * index = dynamic_cast<Integer*>(obj);
+    if (index == nullptr){
+        throw TypeError("cannot access range index with this type");
+    }
+    if (index->value >= this->length()){
+        throw IndexError("cannot access element " + std::to_string(index->value) + ", max index is " + std::to_string(this->length()-1));
+    }else if (index->value < 0){
+        throw IndexError("cannot access index less than 0");
+    }
+    return Integer::get(this->at(index->value));
+};
 
-    dict += "}";
-    return dict;
+Object * Range::clone(){
+    Range * copy = new Range(this->start, this->stop, this->step);
+    if (this->elements != nullptr){
+        copy->elements = new Array(this->elements->value);
+    }
+    return copy;
+};
+
+Iterator * Range::iter(){
+    return new RangeIterator(this);
+};
+
+Object * Range::builtIn(string attribute){
+    throw NotImplementedError("built in attribute not implemented");
+};
+
+Object * Range::builtIn(string method_id, Array * params){
+    if (method_id == "size"){
+        return this->getSize();
+    }
+    else if (method_id == "push" || method_id == "pop"){
+        return this->materialize()->builtIn(method_id, params);
+    }
+    else{
+        throw ValueError("'" + method_id + "' not implemented for " + this->getType());
+    }
+};
+
+/** Prints like the Array that range() used to return. */
+string Range::toString(){
+    ostringstream output;
+    this->writeTo(output);
+    return output.str();
+};
+
+void Range::writeTo(ostream & out){
+    if (this->elements != nullptr){
+        this->elements->writeTo(out);
+        return;
+    }
+    out << "[";
+    int size = this->length();
+    for (int i=0; i<size; i++){
+        out << this->at(i);
+        if ((i+1) < size) out << ", ";
+    }
+    out << "]";
+};
+
+void Range::trace(Heap * heap){
+    heap->mark(this->elements);
+};
+
+// /// ##################################################################
+// /// Iterator definitions
+// /// ##################################################################
+
+IndexIterator::IndexIterator(Object * obj){
+    iterable = obj;
+    position = 0;
+};
+
+Object * IndexIterator::next(){
+    if (this->position < this->iterable->getSize()->value){
+        return this->iterable->index(Integer::get(this->position++));
+    }
+    return nullptr;
+};
+
+void IndexIterator::trace(Heap * heap){
+    heap->mark(this->iterable);
+};
+
+/** Checks the size on every step, so elements pushed by the loop are seen. */
+ArrayIterator::ArrayIterator(Array * arr){
+    array = arr;
+    position = 0;
+};
+
+Object * ArrayIterator::next(){
+    if (this->position < this->array->value.size()){
+        return this->array->value[this->position++];
+    }
+    return nullptr;
+};
+
+void ArrayIterator::trace(Heap * heap){
+    heap->mark(this->array);
+};
+
+StringIterator::StringIterator(String * s){
+    str = s;
+    position = 0;
+};
+
+Object * StringIterator::next(){
+    if (this->position < this->str->value.size()){
+        return String::character(this->str->value[this->position++]);
+    }
+    return nullptr;
+};
+
+void StringIterator::trace(Heap * heap){
+    heap->mark(this->str);
+};
+
+/** Keys are copied up front, so the loop body may add or remove entries. */
+DictionaryIterator::DictionaryIterator(Dictionary * dict){
+    position = 0;
+    keys.reserve(dict->value.size());
+    for (HashTable::iterator it = dict->value.begin(); it != dict->value.end(); ++it){
+        keys.push_back(it->key);
+    }
+};
+
+Object * DictionaryIterator::next(){
+    if (this->position < this->keys.size()){
+        return this->keys[this->position++];
+    }
+    return nullptr;
+};
+
+void DictionaryIterator::trace(Heap * heap){
+    for (int i=0; i<this->keys.size(); i++){
+        heap->mark(this->keys[i]);
+    }
+};
+
+StringViewIterator::StringViewIterator(StringView * v){
+    view = v;
+    position = 0;
+};
+
+Object * StringViewIterator::next(){
+    if (this->position < this->view->size()){
+        return String::character(this->view->data()[this->position++]);
+    }
+    return nullptr;
+};
+
+void StringViewIterator::trace(Heap * heap){
+    heap->mark(this->view);
+};
+
+RangeIterator::RangeIterator(Range * r){
+    range = r;
+    position = 0;
+    size = r->length();
+};
+
+Object * RangeIterator::next(){
+    Array * elements = this->range->elements;
+    if (elements != nullptr){
+        if (this->position < int(elements->value.size())){
+            return elements->value[this->position++];
+        }
+        return nullptr;
+    }
+    if (this->position < this->size){
+        return Integer::get(this->range->at(this->position++));
+    }
+    return nullptr;
+};
+
+void RangeIterator::trace(Heap * heap){
+    heap->mark(this->range);
 };
 
 // /// ##################################################################
@@ -1404,6 +2101,12 @@ string Dictionary::toString(){
 
 None::None(){};
 
+/** Returns the shared 'none' instance. */
+None * None::get(){
+    static None * NONE_VALUE = pinned(new None());
+    return NONE_VALUE;
+};
+
 Object * None::builtIn(string attribute){
     throw NotImplementedError("built in attribute not implemented");
 }
@@ -1424,7 +2127,7 @@ Boolean * None::boolOr(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * b = dynamic_cast<Boolean *>(obj);
         bool result = false || b->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with None OR");
     }
@@ -1434,7 +2137,7 @@ Boolean * None::boolAnd(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * b = dynamic_cast<Boolean *>(obj);
         bool result = false && b->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with None AND");
     }
@@ -1477,14 +2180,38 @@ File::File(string filePath, string fileMode, bool universalNewLines){
 };
 
 void File::open(){
+    // the buffer has to be set before the file is opened to take effect
+    this->streamBuffer.resize(BUFFER_SIZE);
+    this->fstreamFile.rdbuf()->pubsetbuf(this->streamBuffer.data(), this->streamBuffer.size());
     this->fstreamFile.open(this->filePath, ios::binary | this->mode);
     if (!this->fstreamFile.is_open()){
         throw IOError("unable to open input file: " + this->filePath); 
     }
+
+    // lines are no longer flushed one by one, so what is left in the buffer
+    // is written out at exit along with standard output
+    if (this->modeWrite || this->modeAppend){
+        Output::instance();
+        openFiles.insert(this);
+    }
 }
 
+File::~File(){
+    openFiles.erase(this);
+};
+
+/** Flushes every writable File that has not been closed. */
+void File::flushOpenFiles(){
+    for (set<File *>::iterator it = openFiles.begin(); it != openFiles.end(); ++it){
+        (*it)->fstreamFile.flush();
+    }
+};
+
 void File::processFileMode(string fileMode){
     this->fileMode = fileMode;
+    this->modeRead = false;
+    this->modeWrite = false;
+    this->modeAppend = false;
     if (fileMode == "r"){
         this->modeRead = true;
         this->mode = ios::in;
@@ -1519,7 +2246,7 @@ void File::processFileMode(string fileMode){
 
 Object * File::builtIn(string attribute){
     if (attribute == "closed"){
-        return new Boolean(!this->fstreamFile.is_open());
+        return Boolean::get(!this->fstreamFile.is_open());
     }
     else if (attribute == "encoding"){
         return new String(this->encoding);
@@ -1539,12 +2266,18 @@ Object * File::builtIn(string method_id, Array * params){
     if (method_id == "read"){
         return this->read();
     }
+    else if (method_id == "view"){
+        return this->view();
+    }
     else if (method_id == "readline"){
         return this->readline(params);
     }
     else if (method_id == "readlines"){
         return this->readlines(params);
     }
+    else if (method_id == "lines"){
+        return this->lines();
+    }
     else if (method_id == "size"){
         return this->getSize();
     }
@@ -1575,32 +2308,46 @@ Object * File::builtIn(string method_id, Array * params){
 }
 
 string File::processNewLines(string data){
-    // if universal new lines disabled, return raw data as is
-    if (!this->universalNewLines) {
+    // without carriage returns the data is returned as is, without a copy
+    if (!this->universalNewLines || findCarriageReturn(data.data(), 0, data.size()) == data.size()) {
         return data;
     }
+    return this->processNewLines(data.data(), data.size());
+};
 
-    // if universal new lines (the default), convert line endings to '\n'
-    string processedData;
-    int index = 0;
-    while (index < data.size()){
-        char c = data[index];
-        if (c == '\r' && index + 1 < data.size() && data[index+1] == '\n'){
-            processedData += '\n';
-            index += 2;
-        }
-        else if (c == '\r'){
-            processedData += '\n';
-            index += 1;
-        }
-        else{
-            processedData += c;
-            index += 1;
-        }
-    }
+/**
+ * Converts '\r\n' and '\r' to '\n' if universal new lines are enabled
+ * (the default). The text between carriage returns is copied in blocks
+ * into a buffer sized for the input, which the output can only shrink.
+ */
+string File::processNewLines(const char * data, size_t size){
+    size_t next = this->universalNewLines ? findCarriageReturn(data, 0, size) : size;
+    if (next == size) {
+        return string(data, size);
+    }
+
+    string processedData(size, '\0');
+    char * output = &processedData[0];
+    size_t length = 0;
+    size_t index = 0;
+    while (next < size){
+        memcpy(output + length, data + index, next - index);
+        length += next - index;
+        output[length++] = '\n';
+        index = next + 1;
+        if (index < size && data[index] == '\n') index++;
+        next = findCarriageReturn(data, index, size);
+    }
+    memcpy(output + length, data + index, size - index);
+    length += size - index;
+    processedData.resize(length);
     return processedData;
 };
 
+/**
+ * Reads the rest of the file. Large regular files are mapped and copied
+ * once, rather than pulled through the stream buffer.
+ */
 String * File::read(){
     if (!fstreamFile.is_open()) {
         throw ValueError("I/O operation on closed file.");
@@ -1608,10 +2355,58 @@ String * File::read(){
     if (!this->modeRead){
         throw IOError("File not opened with read permissions.");
     }
+    if (this->modeWrite) this->fstreamFile.flush();
+
+    MappedFile mapped(this->filePath);
+    streamoff position = this->fstreamFile.tellg();
+    if (mapped.isMapped() && position >= 0 && size_t(position) <= mapped.size()){
+        this->fstreamFile.seekg(0, ios::end);
+        return new String(this->processNewLines(mapped.data() + position, mapped.size() - position));
+    }
+
     string file_contents { istreambuf_iterator<char>(fstreamFile), istreambuf_iterator<char>() };
     return new String(this->processNewLines(file_contents));
 };
 
+/**
+ * Returns the rest of the file as a read-only StringView, without new
+ * line processing. Large regular files are mapped instead of copied.
+ */
+StringView * File::view(){
+    if (!fstreamFile.is_open()) {
+        throw ValueError("I/O operation on closed file.");
+    }
+    if (!this->modeRead){
+        throw IOError("File not opened with read permissions.");
+    }
+    if (this->modeWrite) this->fstreamFile.flush();
+
+    shared_ptr<MappedFile> mapping = make_shared<MappedFile>(this->filePath);
+    streamoff position = this->fstreamFile.tellg();
+    if (mapping->isMapped() && position >= 0 && size_t(position) <= mapping->size()){
+        this->fstreamFile.seekg(0, ios::end);
+        return new StringView(mapping, size_t(position));
+    }
+
+    string file_contents { istreambuf_iterator<char>(fstreamFile), istreambuf_iterator<char>() };
+    return new StringView(file_contents);
+};
+
+/**
+ * Reads up to size raw bytes into buffer, without new line processing.
+ * Returns the number of bytes read, zero at the end of the file.
+ */
+size_t File::readChunk(char * buffer, size_t size){
+    if (!fstreamFile.is_open()) {
+        throw ValueError("I/O operation on closed file.");
+    }
+    if (!this->modeRead){
+        throw IOError("File not opened with read permissions.");
+    }
+    this->fstreamFile.read(buffer, size);
+    return size_t(this->fstreamFile.gcount());
+};
+
 Array * File::readlines(Array * params){
     if (!fstreamFile.is_open()) {
         throw ValueError("I/O operation on closed file.");
@@ -1628,6 +2423,18 @@ Array * File::readlines(Array * params){
     return lines;
 };
 
+/** Returns a lazy iterator over the remaining lines, see LineIterator. */
+Iterator * File::lines(){
+    if (!fstreamFile.is_open()) {
+        throw ValueError("I/O operation on closed file.");
+    }
+    if (!this->modeRead){
+        throw IOError("File not opened with read permissions.");
+    }
+    if (this->modeWrite) this->fstreamFile.flush();
+    return new LineIterator(this, this->universalNewLines);
+};
+
 String * File::readline(Array * params){
     if (!fstreamFile.is_open()) {
         throw ValueError("I/O operation on closed file.");
@@ -1640,6 +2447,20 @@ String * File::readline(Array * params){
     return new String(this->processNewLines(line));
 };
 
+/**
+ * Writes size bytes as they are, without new line processing. Native
+ * writers format whole rows and hand them over in one call.
+ */
+void File::writeRaw(const char * data, size_t size){
+    if (!fstreamFile.is_open()) {
+        throw ValueError("I/O operation on closed file.");
+    }
+    if (!this->modeWrite && !this->modeAppend){
+        throw IOError("File not opened with write permissions.");
+    }
+    this->fstreamFile.write(data, size);
+};
+
 void File::write(Array * params){
     if (!fstreamFile.is_open()) {
         throw ValueError("I/O operation on closed file.");
@@ -1675,7 +2496,7 @@ void File::writeline(Array * params){
     }
 
     String * line = dynamic_cast<String*>(params->value[0]);
-    this->fstreamFile << line->toString() << std::endl;
+    this->fstreamFile << line->toString() << '\n';
 };
 
 void File::writelines(Array * params){
@@ -1696,12 +2517,12 @@ void File::writelines(Array * params){
     Array * lines = dynamic_cast<Array*>(params->value[0]);
     for (int i=0; i<lines->value.size(); i++){
         string output = this->processNewLines(lines->value[i]->toString());
-        this->fstreamFile << output << std::endl;
+        this->fstreamFile << output << '\n';
     }
 };
 
 Integer * File::tell(){
-    return new Integer(int(this->fstreamFile.tellg()));
+    return Integer::get(int(this->fstreamFile.tellg()));
 };
 
 void File::flush(){
@@ -1710,6 +2531,7 @@ void File::flush(){
 
 void File::close(){
     fstreamFile.close();
+    openFiles.erase(this);
 };
 
 void File::seek(Array * params){
@@ -1733,7 +2555,7 @@ Boolean * File::boolOr(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * b = dynamic_cast<Boolean *>(obj);
         bool result = false || b->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with file OR");
     }
@@ -1743,7 +2565,7 @@ Boolean * File::boolAnd(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * b = dynamic_cast<Boolean *>(obj);
         bool result = false && b->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with file AND");
     }
@@ -1757,6 +2579,132 @@ string File::toString(){
     return "<open file '" + this->filePath + "', mode '" + this->fileMode + "'>";
 };
 
+// /// ##################################################################
+// /// ChunkedInput definition
+// /// ##################################################################
+
+ChunkedInput::ChunkedInput(Object * source, string reader){
+    file = dynamic_cast<File*>(source);
+    text = dynamic_cast<String*>(source);
+    view = dynamic_cast<StringView*>(source);
+    consumed = 0;
+    if (file == nullptr && text == nullptr && view == nullptr){
+        throw TypeError("'" + reader + "' expects a File, String or StringView, not " + source->getType());
+    }
+};
+
+const char * ChunkedInput::data(){
+    if (this->file != nullptr) return this->buffer.data();
+    if (this->view != nullptr) return this->view->data() + this->consumed;
+    return this->text->value.data() + this->consumed;
+};
+
+size_t ChunkedInput::size(){
+    if (this->file != nullptr) return this->buffer.size();
+    if (this->view != nullptr) return this->view->size() - this->consumed;
+    return this->text->value.size() - this->consumed;
+};
+
+/**
+ * Appends the next chunk of the file, returns false at the end. Offsets
+ * into data() stay valid, though the pointer itself may change.
+ */
+bool ChunkedInput::fill(){
+    if (this->file == nullptr) return false;
+
+    size_t used = this->buffer.size();
+    this->buffer.resize(used + CHUNK_SIZE);
+    size_t count = this->file->readChunk(&this->buffer[used], CHUNK_SIZE);
+    this->buffer.resize(used + count);
+    return count > 0;
+};
+
+/** Drops the first count bytes, which shifts every offset down by count. */
+void ChunkedInput::discard(size_t count){
+    if (this->file != nullptr) this->buffer.erase(0, count);
+    this->consumed += count;
+};
+
+void ChunkedInput::trace(Heap * heap){
+    heap->mark(this->file);
+    heap->mark(this->text);
+    heap->mark(this->view);
+};
+
+// /// ##################################################################
+// /// LineIterator definition
+// /// ##################################################################
+
+LineIterator::LineIterator(File * file, bool fileUniversalNewLines) : input(file, "lines"){
+    pos = 0;
+    universalNewLines = fileUniversalNewLines;
+};
+
+/** Returns the first character that ends a line, or nullptr if none. */
+const char * LineIterator::lineBreak(const char * data, size_t size){
+    const char * newline = (const char *) memchr(data, '\n', size);
+    if (!this->universalNewLines) return newline;
+    size_t limit = newline == nullptr ? size : size_t(newline - data);
+    const char * carriageReturn = (const char *) memchr(data, '\r', limit);
+    return carriageReturn != nullptr ? carriageReturn : newline;
+};
+
+Object * LineIterator::next(){
+    // drop the lines already returned, once they are at least a chunk
+    if (this->pos >= ChunkedInput::CHUNK_SIZE){
+        this->input.discard(this->pos);
+        this->pos = 0;
+    }
+
+    size_t end = this->pos;  // where the search for a line break resumes
+    while (true){
+        const char * data = this->input.data();
+        const char * found = this->lineBreak(data + end, this->input.size() - end);
+        if (found != nullptr){
+            end = found - data;
+            // a '\r' at the end of the chunk may be the start of '\r\n'
+            if (*found == '\r' && end + 1 == this->input.size() && this->input.fill()) continue;
+            break;
+        }
+        end = this->input.size();
+        if (!this->input.fill()){
+            if (end == this->pos) return nullptr;
+            String * line = new String(string(this->input.data() + this->pos, end - this->pos));
+            this->pos = end;
+            return line;
+        }
+    }
+
+    const char * data = this->input.data();
+    String * line = new String(string(data + this->pos, end - this->pos));
+    this->pos = end + 1;
+    if (data[end] == '\r' && this->pos < this->input.size() && data[this->pos] == '\n'){
+        this->pos++;
+    }
+    return line;
+};
+
+Object * LineIterator::builtIn(string method_id, Array * params){
+    if (method_id == "next"){
+        Object * result = this->next();
+        if (result == nullptr) return None::get();
+        return result;
+    }
+    throw ValueError("method '" + method_id + "' not found in " + this->getType());
+};
+
+Object * LineIterator::builtIn(string attribute){
+    throw ValueError(this->getType() + " has no member '" + attribute + "'");
+};
+
+string LineIterator::toString(){
+    return "<LineIterator>";
+};
+
+void LineIterator::trace(Heap * heap){
+    this->input.trace(heap);
+};
+
 // /// ##################################################################
 // /// Socket definition
 // /// ##################################################################
@@ -1783,7 +2731,7 @@ Boolean * Socket::boolOr(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * b = dynamic_cast<Boolean *>(obj);
         bool result = false || b->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with None OR");
     }
@@ -1793,7 +2741,7 @@ Boolean * Socket::boolAnd(Object * obj){
     if (dynamic_cast<Boolean *>(obj) != nullptr){
         Boolean * b = dynamic_cast<Boolean *>(obj);
         bool result = false && b->value;
-        return new Boolean(result); 
+        return Boolean::get(result); 
     }else{
         throw TypeError("error with None AND");
     }
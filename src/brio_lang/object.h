@@ -4,26 +4,46 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <cstdint>
 #include <brio_lang/symbol.h>
+#include <brio_lang/heap.h>
+#include <brio_lang/hashtable.h>
 
 using namespace std;
 
 class Boolean;  // forward reference
 class Integer;  // forward reference
 class Array;  // forward referene
+class Iterator;  // forward reference
+class MappedFile;  // forward reference: util.h
 
 class Object {
     public:
         Object();
+        Object(const Object & obj);
+        virtual ~Object(){};
+        static void * operator new(size_t size);
+        static void operator delete(void * memory);
+        virtual void trace(Heap * heap){};  // marks the objects this one refers to
+        bool marked;  // reached in the current collection, see Heap
+        bool young;  // allocated since the last collection
+        bool old;  // survived a collection
+        bool remembered;  // old object recorded by the write barrier
         virtual string toString(){return "Object";};
+        virtual void writeTo(ostream & out){ out << this->toString(); };  // same text as toString, without building it
         virtual string getType(){return "Object";};
         virtual Integer * getSize();
         virtual Object * index(Object *);
         virtual Object * clone();
         virtual Boolean * equals(Object *);
         virtual Boolean * notEquals(Object *);
+        virtual size_t hash();  // dictionary key protocol, see HashTable
+        virtual bool keyEquals(Object *);
+        virtual Iterator * iter();  // elements for 'each', see Iterator
         virtual Object * add(Object *);
         virtual Object * subtract(Object *);
         virtual Object * multiply(Object *);
@@ -51,6 +71,7 @@ class String : public Object {
         String();
         String(Object * obj);
         String(string str_value);
+        static String * character(char c);
         string getType(){return "String";};
         Integer * getSize();
         Boolean * equals(Object *);
@@ -71,9 +92,44 @@ class String : public Object {
         Boolean * isDigit(Array * params);
         Boolean * isAlpha(Array * params);
         Array * split(Array * params);
+        Iterator * iter();
+        size_t hash();
+        bool keyEquals(Object *);
         string toString();
+        void writeTo(ostream & out);
         string value;
     private:
+        size_t hashValue;  // computed on first use, strings are not modified
+        bool hashed;
+};
+
+/**
+ * Read-only string over the contents of a file, returned by File.view().
+ * Large files are mapped rather than copied, so scanning them with
+ * find(), count(), split() or iteration never copies the whole file.
+ */
+class StringView : public Object {
+    public:
+        StringView(shared_ptr<MappedFile> mapping, size_t start);
+        StringView(string contents);
+        string getType(){return "StringView";};
+        const char * data(){ return start; };
+        size_t size(){ return length; };
+        Integer * getSize();
+        Object * index(Object *);
+        Iterator * iter();
+        Object * builtIn(string method_id, Array * params);
+        Object * builtIn(string attribute);
+        Integer * find(Array * params);
+        Integer * count(Array * params);
+        Array * split(Array * params);
+        string toString();
+        void writeTo(ostream & out);
+    private:
+        shared_ptr<MappedFile> mapping;
+        string contents;  // when the file could not be mapped
+        const char * start;
+        size_t length;
 };
 
 class Integer : public Object {
@@ -82,6 +138,10 @@ class Integer : public Object {
         Integer(Object * obj);
         Integer(int int_value);
         Integer(string str_value);
+        static Integer * get(int int_value);
+        static Integer * fromSize(size_t size_value);
+        inline static const int CACHE_MIN = -128;  // shared small integers
+        inline static const int CACHE_MAX = 1024;
         string getType(){return "Integer";};
         Boolean * equals(Object *);
         Boolean * notEquals(Object *);
@@ -103,6 +163,8 @@ class Integer : public Object {
         Integer * bitShiftLeft(Object *);
         Boolean * lessThanOrEqual(Object *);
         Object * clone();
+        size_t hash();
+        bool keyEquals(Object *);
         Object * builtIn(string method_id, Array * params);
         Object * builtIn(string attribute);
         string toString();
@@ -110,6 +172,34 @@ class Integer : public Object {
     private:
 };
 
+/**
+ * Integers carried in the pointer itself: an Object * with its low bit set
+ * holds the value in the remaining bits and points at nothing. Method slots
+ * and the vm operand stack may hold them, so counting loops allocate no
+ * Integers. Anything else must box() a value before dereferencing it.
+ *
+ * The arithmetic and comparison helpers take tagged values or Integers and
+ * fall back to the Object operators for every other type.
+ */
+class SmallInteger {
+    public:
+        static Object * tag(int int_value);
+        static bool isTagged(Object * obj){ return (reinterpret_cast<uintptr_t>(obj) & 1) != 0; };
+        static int untag(Object * obj){ return int(intptr_t(reinterpret_cast<uintptr_t>(obj)) >> 1); };
+        static Object * box(Object * obj){ return isTagged(obj) ? Integer::get(untag(obj)) : obj; };
+        static Object * add(Object * lhs, Object * rhs);
+        static Object * subtract(Object * lhs, Object * rhs);
+        static Object * multiply(Object * lhs, Object * rhs);
+        static Boolean * equals(Object * lhs, Object * rhs);
+        static Boolean * notEquals(Object * lhs, Object * rhs);
+        static Boolean * lessThan(Object * lhs, Object * rhs);
+        static Boolean * lessThanOrEqual(Object * lhs, Object * rhs);
+        static Boolean * greaterThan(Object * lhs, Object * rhs);
+        static Boolean * greaterThanOrEqual(Object * lhs, Object * rhs);
+    private:
+        static bool value(Object * obj, int & result);
+};
+
 class Decimal : public Object {
     public:
         Decimal();
@@ -132,6 +222,8 @@ class Decimal : public Object {
         Boolean * lessThan(Object *);
         Boolean * lessThanOrEqual(Object *);
         Object * clone();
+        size_t hash();
+        bool keyEquals(Object *);
         Object * builtIn(string method_id, Array * params);
         Object * builtIn(string attribute);
         string toString();
@@ -145,6 +237,7 @@ class Boolean : public Object {
         Boolean(Object * obj);
         Boolean(bool bool_value);
         Boolean(string str_value);
+        static Boolean * get(bool bool_value);
         string getType(){return "Boolean";};
         Boolean * equals(Object *);
         Boolean * notEquals(Object *);
@@ -166,6 +259,8 @@ class Boolean : public Object {
         Integer * bitShiftLeft(Object *);
         Boolean * lessThanOrEqual(Object *);
         Object * clone();
+        size_t hash();
+        bool keyEquals(Object *);
         Object * builtIn(string method_id, Array * params);
         Object * builtIn(string attribute);
         string toString();
@@ -201,11 +296,14 @@ class Array : public Object {
         Boolean * lessThanOrEqual(Object *);
         Object * index(Object *);
         Object * clone();
+        Iterator * iter();
         void push(Array *);
         Object * pop(Array *);
         Object * builtIn(string method_id, Array * params);
         Object * builtIn(string attribute);
         string toString();
+        void writeTo(ostream & out);
+        void trace(Heap * heap);
         vector<Object*> value;
     private:
 };
@@ -228,17 +326,124 @@ class Dictionary : public Object {
         Boolean * lessThanOrEqual(Object *);
         Object * index(Object *);
         Object * clone();
+        Iterator * iter();
         Object * pop(Array *);
         Object * builtIn(string method_id, Array * params);
         Object * builtIn(string attribute);
         string toString();
-        map<Object*, Object*> value;
+        void writeTo(ostream & out);
+        void trace(Heap * heap);
+        HashTable value;
+    private:
+};
+
+/**
+ * Integers from start up to, but not including, stop. Elements are
+ * computed on access rather than stored, so large ranges cost nothing.
+ * The first push, pop or index assignment copies the elements into an
+ * Array, which the range then reads and updates like range() used to.
+ */
+class Range : public Object {
+    public:
+        Range(int start_value, int stop_value, int step_value);
+        string getType(){return "Range";};
+        Integer * getSize();
+        int length();
+        int at(int position);
+        Array * materialize();
+        Object * index(Object *);
+        Object * clone();
+        Iterator * iter();
+        Object * builtIn(string method_id, Array * params);
+        Object * builtIn(string attribute);
+        string toString();
+        void writeTo(ostream & out);
+        void trace(Heap * heap);
+        int start;
+        int stop;
+        int step;
+        Array * elements;  // copy made on the first mutation, else nullptr
     private:
 };
 
+/**
+ * Steps through the elements of an iterable object for 'each'. Built-in
+ * types return their own iterator from Object::iter, so a loop does not
+ * allocate to compute sizes or indexes.
+ */
+class Iterator : public Object {
+    public:
+        string getType(){return "Iterator";};
+        virtual Object * next(){return nullptr;};  // nullptr once exhausted
+};
+
+/** Iterates any object through getSize() and index(). */
+class IndexIterator : public Iterator {
+    public:
+        IndexIterator(Object * iterable);
+        Object * next();
+        void trace(Heap * heap);
+    private:
+        Object * iterable;
+        int position;
+};
+
+class ArrayIterator : public Iterator {
+    public:
+        ArrayIterator(Array * array);
+        Object * next();
+        void trace(Heap * heap);
+    private:
+        Array * array;
+        size_t position;
+};
+
+class StringIterator : public Iterator {
+    public:
+        StringIterator(String * str);
+        Object * next();
+        void trace(Heap * heap);
+    private:
+        String * str;
+        size_t position;
+};
+
+class StringViewIterator : public Iterator {
+    public:
+        StringViewIterator(StringView * view);
+        Object * next();
+        void trace(Heap * heap);
+    private:
+        StringView * view;
+        size_t position;
+};
+
+/** Iterates the keys present when the loop started. */
+class DictionaryIterator : public Iterator {
+    public:
+        DictionaryIterator(Dictionary * dict);
+        Object * next();
+        void trace(Heap * heap);
+    private:
+        vector<Object *> keys;
+        size_t position;
+};
+
+class RangeIterator : public Iterator {
+    public:
+        RangeIterator(Range * range);
+        Object * next();
+        void trace(Heap * heap);
+    private:
+        Range * range;
+        int position;
+        int size;
+};
+
 class None : public Object {
     public:
         None();
+        static None * get();
         string getType(){return "None";};
         Boolean * equals(Object *);
         Boolean * notEquals(Object *);
@@ -257,6 +462,7 @@ class File : public Object {
         File(string filePath);
         File(string filePath, string fileMode);
         File(string filePath, string fileMode, bool universalNewLines);
+        ~File();
         string getType(){return "File";};
         Boolean * equals(Object *);
         Boolean * notEquals(Object *);
@@ -268,6 +474,9 @@ class File : public Object {
         Object * builtIn(string attribute);
         string toString();
         String * read();
+        StringView * view();
+        size_t readChunk(char * buffer, size_t size);
+        void writeRaw(const char * data, size_t size);
         void write(Array * params);
         void writeline(Array * params);
         void writelines(Array * params);
@@ -276,21 +485,72 @@ class File : public Object {
         void seek(Array * params);
         Array * readlines(Array * params);
         String * readline(Array * params);
+        Iterator * lines();
         void close();
+        static void flushOpenFiles();
+        inline static const size_t BUFFER_SIZE = 64 * 1024;  // writes reach the disk in blocks this large
     private:
+        inline static set<File *> openFiles;  // writable files, flushed at exit
         bool universalNewLines;
         string filePath;
         string fileMode;
         string encoding;
+        vector<char> streamBuffer;  // outlives fstreamFile, which flushes into it on close
         fstream fstreamFile;
         void processFileMode(string);
         string processNewLines(string);
+        string processNewLines(const char * data, size_t size);
         ios_base::openmode mode;
         bool modeWrite;
         bool modeRead;
         bool modeAppend;
 };
 
+/**
+ * Buffered input for the readers that scan a File, String or StringView
+ * ahead of what they return. Files are read in chunks on demand; data()
+ * and size() cover what has been read and not yet discarded.
+ */
+class ChunkedInput {
+    public:
+        ChunkedInput(Object * source, string reader);
+        const char * data();
+        size_t size();
+        bool fill();
+        void discard(size_t count);
+        void trace(Heap * heap);
+        size_t getConsumed(){ return consumed; };
+        inline static const size_t CHUNK_SIZE = 64 * 1024;
+    private:
+        File * file;
+        String * text;
+        StringView * view;
+        string buffer;  // unread part of the file
+        size_t consumed;  // bytes discarded from the front
+};
+
+/**
+ * Reads a File one line at a time for 'each', so memory stays constant no
+ * matter how large the file is. Lines are returned without their line
+ * break; with universal new lines '\r\n' and '\r' end a line too.
+ */
+class LineIterator : public Iterator {
+    public:
+        LineIterator(File * file, bool universalNewLines);
+        string getType(){return "LineIterator";};
+        Object * next();
+        Iterator * iter(){return this;};
+        Object * builtIn(string method_id, Array * params);
+        Object * builtIn(string attribute);
+        string toString();
+        void trace(Heap * heap);
+    private:
+        const char * lineBreak(const char * data, size_t size);
+        ChunkedInput input;
+        size_t pos;
+        bool universalNewLines;
+};
+
 class Socket : public Object {
     public:
         Socket();
@@ -0,0 +1,82 @@
+///
+/// Brio Lang
+/// output.cc
+///
+/// Buffered standard output
+///
+
+#include <brio_lang/output.h>
+#include <brio_lang/object.h>
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <unistd.h>
+
+
+static terminate_handler previousTerminate = nullptr;
+
+/** Writes out everything still buffered: standard output and open Files. */
+static void flushAtExit(){
+    Output::instance().flush();
+    File::flushOpenFiles();
+};
+
+static void flushAndTerminate(){
+    flushAtExit();
+    if (previousTerminate != nullptr) previousTerminate();
+    std::abort();
+};
+
+/** Returns the process wide output buffer, which is never destroyed. */
+Output & Output::instance(){
+    static Output * output = new Output();
+    return *output;
+};
+
+Output::Output() : out(this){
+    lineBuffered = isatty(STDOUT_FILENO);
+    buffer.reserve(BUFFER_SIZE);
+    std::atexit(flushAtExit);
+    previousTerminate = std::set_terminate(flushAndTerminate);
+};
+
+/**
+ * Appends text to the buffer. Text that does not fit is preceded by a
+ * flush, and text at least as large as the buffer is written directly.
+ */
+void Output::write(const char * data, size_t size){
+    if (this->buffer.size() + size > BUFFER_SIZE){
+        this->flush();
+    }
+    if (size >= BUFFER_SIZE){
+        std::cout.write(data, size);
+        std::cout.flush();
+        return;
+    }
+    this->buffer.append(data, size);
+    if (this->lineBuffered && memchr(data, '\n', size) != nullptr){
+        this->flush();
+    }
+};
+
+int Output::overflow(int c){
+    if (c == traits_type::eof()) return traits_type::not_eof(c);
+    char ch = char(c);
+    this->write(&ch, 1);
+    return c;
+};
+
+streamsize Output::xsputn(const char * data, streamsize size){
+    this->write(data, size_t(size));
+    return size;
+};
+
+void Output::flush(){
+    if (!this->buffer.empty()){
+        std::cout.write(this->buffer.data(), this->buffer.size());
+        this->buffer.clear();
+    }
+    std::cout.flush();
+};
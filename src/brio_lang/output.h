@@ -0,0 +1,40 @@
+#ifndef BRIOLANG_SRC_OUTPUT_H_
+#define BRIOLANG_SRC_OUTPUT_H_
+
+#include <string>
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+
+using namespace std;
+
+
+/**
+ * Buffers what print() writes to standard output, so a script printing
+ * millions of lines makes one write per block rather than per line. The
+ * buffer is written to std::cout once full, on flush() and at exit, even
+ * when the program ends with an uncaught exception. When standard output
+ * is a terminal each complete line is flushed right away. Values are
+ * serialized straight into the buffer through stream().
+ */
+class Output : public streambuf {
+    public:
+        static Output & instance();
+        void write(const string & text){ write(text.data(), text.size()); };
+        void write(const char * data, size_t size);
+        ostream & stream(){ return out; };
+        void flush();
+        void setLineBuffered(bool enabled){ lineBuffered = enabled; };
+        bool isLineBuffered(){ return lineBuffered; };
+        inline static const size_t BUFFER_SIZE = 64 * 1024;
+    protected:
+        int overflow(int c);
+        streamsize xsputn(const char * data, streamsize size);
+    private:
+        Output();
+        ostream out;  // writes through this buffer
+        string buffer;
+        bool lineBuffered;
+};
+
+#endif  // BRIOLANG_SRC_OUTPUT_H_
@@ -16,8 +16,9 @@ Ref::Ref(SymbolTable * sym_table){
 
 void Ref::downUp(AST * node){
     // pre-order actions
-    if (node->getType() == IdentifierNode::type){
-        
+    if (node->getKind() == IdentifierNode::kind){
+        this->slot(node);
+
         // resolve if not prefixed with "@"
         if(node->parent->children[0]->getNodeText() != Literals::THIS ||
            node->getNodeText() == Literals::THIS){
@@ -32,6 +33,25 @@ void Ref::downUp(AST * node){
     }
 };
 
+/**
+ * Annotates an identifier with its (depth, slot) in the MethodSpace when
+ * it names a local of the enclosing method. Methods do not nest, so locals
+ * are always at depth 0; other names are looked up by name at runtime.
+ */
+void Ref::slot(AST * id){
+    id->slotDepth = -1;
+    id->slotIndex = -1;
+
+    MethodSymbol * method = SymbolTable::getEnclosingMethod(id->scope);
+    if (method == nullptr) return;
+
+    int index = method->resolveSlot(id->getNodeText());
+    if (index >= 0){
+        id->slotDepth = 0;
+        id->slotIndex = index;
+    }
+};
+
 void Ref::identifier(AST * id){
     string identifier = id->getNodeText();
 
@@ -41,13 +61,13 @@ void Ref::identifier(AST * id){
     else if (identifier == Literals::SUPER){
         id->symbol = table->getEnclosingClass(id->scope);
     }
-    else if (id->parent->getType() == SuperClassNode::type){
+    else if (id->parent->getKind() == SuperClassNode::kind){
         // set the superClass reference
         AST * descClassId = id->parent->parent->children[0];
         ClassSymbol * descClassSym = dynamic_cast<ClassSymbol*>(table->resolveId(descClassId));
         descClassSym->superClass = dynamic_cast<ClassSymbol*>(table->resolveId(id));
     }
-    else if (id->hasAncestor(ImportNode::type)){
+    else if (id->hasAncestor(ImportNode::kind)){
         if (id->getNodeText() == id->getSibling(id->parent->getChildCount()-1)->getNodeText()){
             id->symbol = table->resolveId(id);
             if (id->symbol == nullptr){
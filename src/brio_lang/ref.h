@@ -10,6 +10,7 @@ class Ref {
         Ref(SymbolTable * sym_table);
         void downUp(AST * tree);
         void identifier(AST * node);
+        void slot(AST * node);
     private:
         SymbolTable * table;
         Scope * currentScope;
@@ -16,6 +16,7 @@
 #include <brio_lang/util.h>
 #include <brio_lang/exceptions.h>
 #include <brio_lang/visitor.h>
+#include <brio_lang/output.h>
 
 #include <brio_lang/linenoise.h>
 
@@ -82,6 +83,8 @@ void REPL::eval(string input){
             // enforce operator precedence
             OperatorPrecedenceVisitor opVisitor;
             opVisitor.visit(&stmt);
+            ConstantVisitor constVisitor;
+            constVisitor.visit(&stmt);
 
             // update symbol talbe
             Def def(interpreter->table);
@@ -92,10 +95,12 @@ void REPL::eval(string input){
             // execute statement
             interpreter->root = &stmt;
             Object * result = interpreter->exec(stmt.children[0]);
+            Output::instance().flush();
             if (result != nullptr){
                 std::cout << result->toString() << std::endl;
             }
         }catch(const std::exception &e){
+            Output::instance().flush();
             std::cout << e.what() << "\n";
         }
     }
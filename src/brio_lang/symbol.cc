@@ -69,6 +69,31 @@ ImportedModuleSymbol::ImportedModuleSymbol(string sym_name, Scope * parent):
 MethodSymbol::MethodSymbol(string sym_name, Scope * parent):
     ScopedSymbol(sym_name, parent) { };
 
+/**
+ * Returns the slot index for a local name in the method's memory space,
+ * assigning the next free slot on first definition.
+ */
+int MethodSymbol::defineSlot(string name){
+    int index = this->resolveSlot(name);
+    if (index >= 0) return index;
+
+    index = int(this->slotNames.size());
+    this->slots[name] = index;
+    this->slotNames.push_back(name);
+    return index;
+};
+
+/** Returns the slot index for a local name, or -1 if not a local. */
+int MethodSymbol::resolveSlot(string name){
+    map<string, int>::iterator it = this->slots.find(name);
+    if (it == this->slots.end()) return -1;
+    return it->second;
+};
+
+int MethodSymbol::getSlotCount(){
+    return int(this->slotNames.size());
+};
+
 VariableSymbol::VariableSymbol(string sym_name) :
     Symbol(sym_name, nullptr) { };
 
@@ -142,9 +167,15 @@ void SymbolTable::initTypeSystem(){
     this->globals.define(new BuiltInTypeSymbol("Boolean"));
     this->globals.define(new BuiltInTypeSymbol("Array"));
     this->globals.define(new BuiltInTypeSymbol("Dictionary"));
+    this->globals.define(new BuiltInTypeSymbol("Range"));
     this->globals.define(new BuiltInTypeSymbol("None"));
     this->globals.define(new BuiltInTypeSymbol("File"));
     this->globals.define(new BuiltInTypeSymbol("Socket"));
+    this->globals.define(new BuiltInTypeSymbol("StringView"));
+    this->globals.define(new BuiltInTypeSymbol("LineIterator"));
+    this->globals.define(new BuiltInTypeSymbol("JsonReader"));
+    this->globals.define(new BuiltInTypeSymbol("CsvReader"));
+    this->globals.define(new BuiltInTypeSymbol("CsvWriter"));
 
     // init built-in exception symbols
     this->globals.define(new BuiltInTypeSymbol("BaseException"));
@@ -183,6 +214,7 @@ void SymbolTable::initTypeSystem(){
     
     // init built-in method symbols
     this->globals.define(new BuiltInMethodSymbol("print"));
+    this->globals.define(new BuiltInMethodSymbol("flush"));
     this->globals.define(new BuiltInMethodSymbol("range"));
     this->globals.define(new BuiltInMethodSymbol("traceback"));
     this->globals.define(new BuiltInMethodSymbol("input"));
@@ -196,10 +228,17 @@ void SymbolTable::initTypeSystem(){
     this->globals.define(new BuiltInMethodSymbol("decimal"));
     this->globals.define(new BuiltInMethodSymbol("arg"));
     this->globals.define(new BuiltInMethodSymbol("getEnv"));
+    this->globals.define(new BuiltInMethodSymbol("jsonParse"));
+    this->globals.define(new BuiltInMethodSymbol("jsonStringify"));
+    this->globals.define(new BuiltInMethodSymbol("jsonReader"));
+    this->globals.define(new BuiltInMethodSymbol("csvReader"));
+    this->globals.define(new BuiltInMethodSymbol("csvWriter"));
 
     // init temp built-in method symbols (will go away)
     this->globals.define(new BuiltInMethodSymbol("httpGet"));
     this->globals.define(new BuiltInMethodSymbol("httpPost"));
+    this->globals.define(new BuiltInMethodSymbol("httpMulti"));
+    this->globals.define(new BuiltInMethodSymbol("httpDownload"));
 };
 
 string SymbolTable::toString(){
@@ -243,4 +282,19 @@ ClassSymbol * SymbolTable::getEnclosingClass(Scope * scope){
         scope = scope->getParentScope();
     };
     return nullptr;
-};
\ No newline at end of file
+};
+
+MethodSymbol * SymbolTable::getEnclosingMethod(Scope * scope){
+    // locals live in the memory space of their enclosing method
+    while (scope != nullptr){
+        if (dynamic_cast<MethodSymbol*>(scope) != nullptr){
+            return dynamic_cast<MethodSymbol*>(scope);
+        }
+        if (dynamic_cast<ClassSymbol*>(scope) != nullptr ||
+            dynamic_cast<ImportedModuleSymbol*>(scope) != nullptr){
+            return nullptr;
+        }
+        scope = scope->getEnclosingScope();
+    };
+    return nullptr;
+};
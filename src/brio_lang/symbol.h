@@ -2,6 +2,7 @@
 #define BRIOLANG_SRC_SYMBOL_H_
 
 #include <string>
+#include <vector>
 #include <map>
 #include <brio_lang/tree.h>
 
@@ -90,7 +91,12 @@ class MethodSymbol : public ScopedSymbol {
     public:
         MethodSymbol(string name, Scope * parent);
         virtual string getSymbolType() override { return "MethodSymbol"; };
+        int defineSlot(string name);
+        int resolveSlot(string name);
+        int getSlotCount();
+        vector<string> slotNames;
     private:
+        map<string, int> slots;
 };
 
 class ImportedModuleSymbol : public ScopedSymbol {
@@ -121,6 +127,7 @@ class SymbolTable {
         void initTypeSystem();
         Symbol * resolveId(AST * idAST);
         static ClassSymbol * getEnclosingClass(Scope * scope);
+        static MethodSymbol * getEnclosingMethod(Scope * scope);
         string toString();
         GlobalScope globals;
     private:
@@ -13,10 +13,26 @@ using namespace std;
 
 AST::AST() { 
     token = Token(); 
+    nodeKind = N_AST;
+    slotDepth = -1;
+    slotIndex = -1;
+    constant = nullptr;
 };
 
 AST::AST(Token node_token){
     token = node_token;
+    nodeKind = N_AST;
+    slotDepth = -1;
+    slotIndex = -1;
+    constant = nullptr;
+};
+
+AST::AST(Token node_token, NodeKind node_kind){
+    token = node_token;
+    nodeKind = node_kind;
+    slotDepth = -1;
+    slotIndex = -1;
+    constant = nullptr;
 };
 
 bool AST::isNil(){
@@ -80,10 +96,10 @@ AST * AST::getSibling(int index){
     return this->parent->children[index];
 };
 
-AST * AST::getAncestor(string node_type){
+AST * AST::getAncestor(NodeKind node_kind){
     AST * node = this->parent;
-    while (node->getType() != ProgramNode::type){
-        if (node->getType() == node_type){
+    while (node->getKind() != ProgramNode::kind){
+        if (node->getKind() == node_kind){
             return node;
         }
         node = node->parent;
@@ -91,13 +107,13 @@ AST * AST::getAncestor(string node_type){
     return nullptr;
 };
 
-bool AST::hasAncestor(string node_type){
-    return this->getAncestor(node_type) != nullptr;
+bool AST::hasAncestor(NodeKind node_kind){
+    return this->getAncestor(node_kind) != nullptr;
 };
 
 bool AST::hasAncestorExpr(){
     AST * node = this->parent;
-    while (node->getType() != ProgramNode::type){
+    while (node->getKind() != ProgramNode::kind){
         if (dynamic_cast<BinExpressionNode*>(node) != nullptr){
            return true;
         }
@@ -113,196 +129,196 @@ bool AST::hasAncestorExpr(){
 };
 
 ProgramNode::ProgramNode() : 
-    AST() { };
+    AST(Token(), ProgramNode::kind) { };
 
 VarDeclarationNode::VarDeclarationNode(Token token) : 
-    AST(token) { };
+    AST(token, VarDeclarationNode::kind) { };
 
 VarAssignmentNode::VarAssignmentNode(Token token) : 
-    AST(token) { };
+    AST(token, VarAssignmentNode::kind) { };
 
 AdditionAssignNode::AdditionAssignNode(Token token) : 
-    AST(token) { };
+    AST(token, AdditionAssignNode::kind) { };
 
 SubtractionAssignNode::SubtractionAssignNode(Token token) : 
-    AST(token) { };
+    AST(token, SubtractionAssignNode::kind) { };
 
 MultiplicationAssignNode::MultiplicationAssignNode(Token token) : 
-    AST(token) { };
+    AST(token, MultiplicationAssignNode::kind) { };
 
 DivisionAssignNode::DivisionAssignNode(Token token) : 
-    AST(token) { };
+    AST(token, DivisionAssignNode::kind) { };
 
 BitOrAssignNode::BitOrAssignNode(Token token) : 
-    AST(token) { };
+    AST(token, BitOrAssignNode::kind) { };
 
 BitAndAssignNode::BitAndAssignNode(Token token) : 
-    AST(token) { };
+    AST(token, BitAndAssignNode::kind) { };
 
 ClassDeclarationNode::ClassDeclarationNode(Token token) : 
-    AST(token) { };
+    AST(token, ClassDeclarationNode::kind) { };
 
 ClassInstantiationNode::ClassInstantiationNode(Token token) : 
-    AST(token) { };
+    AST(token, ClassInstantiationNode::kind) { };
 
 MethodDeclarationNode::MethodDeclarationNode(Token token) : 
-    AST(token) { };
+    AST(token, MethodDeclarationNode::kind) { };
 
 MethodCallNode::MethodCallNode(Token token) : 
-    AST(token) { };
+    AST(token, MethodCallNode::kind) { };
 
 ModifierNode::ModifierNode(Token token) : 
-    AST(token) { };
+    AST(token, ModifierNode::kind) { };
 
 ParamsListNode::ParamsListNode(Token token) : 
-    AST(token) { };
+    AST(token, ParamsListNode::kind) { };
 
 ParenthesesNode::ParenthesesNode(Token token) : 
-    AST(token) { };
+    AST(token, ParenthesesNode::kind) { };
 
-BinExpressionNode::BinExpressionNode(Token token) : 
-    AST(token) { };
+BinExpressionNode::BinExpressionNode(Token token, NodeKind node_kind) : 
+    AST(token, node_kind) { };
 
-BoolExpressionNode::BoolExpressionNode(Token token) : 
-    AST(token) { };
+BoolExpressionNode::BoolExpressionNode(Token token, NodeKind node_kind) : 
+    AST(token, node_kind) { };
 
-BitExpressionNode::BitExpressionNode(Token token) : 
-    AST(token) { };
+BitExpressionNode::BitExpressionNode(Token token, NodeKind node_kind) : 
+    AST(token, node_kind) { };
 
 BitOrExpressionNode::BitOrExpressionNode(Token token):
-    BitExpressionNode(token) { };
+    BitExpressionNode(token, BitOrExpressionNode::kind) { };
 
 BitAndExpressionNode::BitAndExpressionNode(Token token):
-    BitExpressionNode(token) { };
+    BitExpressionNode(token, BitAndExpressionNode::kind) { };
 
 BitXorExpressionNode::BitXorExpressionNode(Token token):
-    BitExpressionNode(token) { };
+    BitExpressionNode(token, BitXorExpressionNode::kind) { };
 
 ModulusExpressionNode::ModulusExpressionNode(Token token):
-    BinExpressionNode(token) { };
+    BinExpressionNode(token, ModulusExpressionNode::kind) { };
 
 ExponentExpressionNode::ExponentExpressionNode(Token token):
-    BinExpressionNode(token) { };
+    BinExpressionNode(token, ExponentExpressionNode::kind) { };
 
 AddExpressionNode::AddExpressionNode(Token token) : 
-    BinExpressionNode(token) { };
+    BinExpressionNode(token, AddExpressionNode::kind) { };
 
 SubtractExpressionNode::SubtractExpressionNode(Token token) : 
-    BinExpressionNode(token) { };
+    BinExpressionNode(token, SubtractExpressionNode::kind) { };
 
 MultiplyExpressionNode::MultiplyExpressionNode(Token token) : 
-    BinExpressionNode(token) { };
+    BinExpressionNode(token, MultiplyExpressionNode::kind) { };
 
 DivideExpressionNode::DivideExpressionNode(Token token) : 
-    BinExpressionNode(token) { };
+    BinExpressionNode(token, DivideExpressionNode::kind) { };
 
 IfStatementNode::IfStatementNode(Token token) :
-    AST(token) { };
+    AST(token, IfStatementNode::kind) { };
 
 IfConditionBlockNode::IfConditionBlockNode(Token token) :
-    AST(token) { };
+    AST(token, IfConditionBlockNode::kind) { };
 
 ImportNode::ImportNode(Token token) :
-    AST(token) { };
+    AST(token, ImportNode::kind) { };
 
 ImportedModuleNode::ImportedModuleNode(Token token) :
-    AST(token) { };
+    AST(token, ImportedModuleNode::kind) { };
 
 FromImportNode::FromImportNode(Token token) :
-    AST(token) { };
+    AST(token, FromImportNode::kind) { };
 
 ForStatementNode::ForStatementNode(Token token) :
-    AST(token) { };
+    AST(token, ForStatementNode::kind) { };
 
 EachStatementNode::EachStatementNode(Token token) :
-    AST(token) { };
+    AST(token, EachStatementNode::kind) { };
 
 WhileStatementNode::WhileStatementNode(Token token) :
-    AST(token) { };
+    AST(token, WhileStatementNode::kind) { };
 
 SkipStatementNode::SkipStatementNode(Token token) :
-    AST(token) { };
+    AST(token, SkipStatementNode::kind) { };
 
 TryStatementNode::TryStatementNode(Token token) :
-    AST(token) { };
+    AST(token, TryStatementNode::kind) { };
 
 CatchStatementNode::CatchStatementNode(Token token) :
-    AST(token) { };
+    AST(token, CatchStatementNode::kind) { };
 
 RaiseStatementNode::RaiseStatementNode(Token token) :
-    AST(token) { };
+    AST(token, RaiseStatementNode::kind) { };
 
 AsNode::AsNode(Token token) :
-    AST(token) { };
+    AST(token, AsNode::kind) { };
 
 MemberAccessNode::MemberAccessNode(Token token) : 
-    AST(token) { };
+    AST(token, MemberAccessNode::kind) { };
 
 IndexNode::IndexNode(Token token) : 
-    AST(token) { };
+    AST(token, IndexNode::kind) { };
 
 BlockNode::BlockNode(Token token) : 
-    AST(token) { };
+    AST(token, BlockNode::kind) { };
 
 SuperClassNode::SuperClassNode(Token token) :
-    AST(token) {};
+    AST(token, SuperClassNode::kind) {};
 
 LiteralStringNode::LiteralStringNode(Token token) : 
-    AST(token) { };
+    AST(token, LiteralStringNode::kind) { };
 
 LiteralIntNode::LiteralIntNode(Token token) : 
-    AST(token) { };
+    AST(token, LiteralIntNode::kind) { };
 
 LiteralDecimalNode::LiteralDecimalNode(Token token) : 
-    AST(token) { };
+    AST(token, LiteralDecimalNode::kind) { };
 
 LiteralBooleanNode::LiteralBooleanNode(Token token) : 
-    AST(token) { };
+    AST(token, LiteralBooleanNode::kind) { };
 
 LiteralNoneNode::LiteralNoneNode(Token token) : 
-    AST(token) { };
+    AST(token, LiteralNoneNode::kind) { };
 
 ArrayNode::ArrayNode(Token token) : 
-    AST(token) { };
+    AST(token, ArrayNode::kind) { };
 
 DictionaryNode::DictionaryNode(Token token) : 
-    AST(token) { };
+    AST(token, DictionaryNode::kind) { };
 
 DictionaryKeyValueNode::DictionaryKeyValueNode(Token token) : 
-    AST(token) { };
+    AST(token, DictionaryKeyValueNode::kind) { };
 
 ReturnNode::ReturnNode(Token token) : 
-    AST(token) { };
+    AST(token, ReturnNode::kind) { };
 
 IdentifierNode::IdentifierNode(Token token) : 
-    AST(token) { };
+    AST(token, IdentifierNode::kind) { };
 
 BoolOrNode::BoolOrNode(Token token) :
-    BoolExpressionNode(token) { };
+    BoolExpressionNode(token, BoolOrNode::kind) { };
 
 BoolAndNode::BoolAndNode(Token token) :
-    BoolExpressionNode(token) { };
+    BoolExpressionNode(token, BoolAndNode::kind) { };
 
 BoolEqualsNode::BoolEqualsNode(Token token) : 
-    BoolExpressionNode(token) { };
+    BoolExpressionNode(token, BoolEqualsNode::kind) { };
 
 BoolNotEqualsNode::BoolNotEqualsNode(Token token) : 
-    BoolExpressionNode(token) { };
+    BoolExpressionNode(token, BoolNotEqualsNode::kind) { };
 
 BoolGreaterThanNode::BoolGreaterThanNode(Token token) : 
-    BoolExpressionNode(token) { };
+    BoolExpressionNode(token, BoolGreaterThanNode::kind) { };
 
 BoolGreaterThanOrEqualNode::BoolGreaterThanOrEqualNode(Token token) : 
-    BoolExpressionNode(token) { };
+    BoolExpressionNode(token, BoolGreaterThanOrEqualNode::kind) { };
 
 BoolLessThanNode::BoolLessThanNode(Token token) : 
-    BoolExpressionNode(token) { };
+    BoolExpressionNode(token, BoolLessThanNode::kind) { };
 
 BoolLessThanOrEqualNode::BoolLessThanOrEqualNode(Token token) : 
-    BoolExpressionNode(token) { };
+    BoolExpressionNode(token, BoolLessThanOrEqualNode::kind) { };
 
 BitShiftLeftNode::BitShiftLeftNode(Token token) : 
-    BitExpressionNode(token) { };
+    BitExpressionNode(token, BitShiftLeftNode::kind) { };
 
 BitShiftRightNode::BitShiftRightNode(Token token) : 
-    BitExpressionNode(token) { };
\ No newline at end of file
+    BitExpressionNode(token, BitShiftRightNode::kind) { };
\ No newline at end of file
@@ -13,13 +13,88 @@ using namespace std;
 class Scope;  // forward reference: symbol.h
 class Symbol;  // forward reference: symbol.h
 class Type;  // forward reference: symbol.h
-
+class Object;  // forward reference: object.h
+
+
+// integer node kinds, fixed at construction and used for dispatch
+enum NodeKind {
+    N_AST = 0,
+    N_PROGRAM,
+    N_VAR_DECLARATION,
+    N_VAR_ASSIGNMENT,
+    N_ADDITION_ASSIGN,
+    N_SUBTRACTION_ASSIGN,
+    N_MULTIPLICATION_ASSIGN,
+    N_DIVISION_ASSIGN,
+    N_BIT_OR_ASSIGN,
+    N_BIT_AND_ASSIGN,
+    N_MODIFIER,
+    N_METHOD_DECLARATION,
+    N_METHOD_CALL,
+    N_CLASS_DECLARATION,
+    N_CLASS_INSTANTIATION,
+    N_BLOCK,
+    N_BIN_EXPRESSION,
+    N_BOOL_EXPRESSION,
+    N_BIT_EXPRESSION,
+    N_ADD_EXPRESSION,
+    N_SUBTRACT_EXPRESSION,
+    N_MULTIPLY_EXPRESSION,
+    N_DIVIDE_EXPRESSION,
+    N_MEMBER_ACCESS,
+    N_INDEX,
+    N_PARAMS_LIST,
+    N_PARENTHESES,
+    N_SUPER_CLASS,
+    N_LITERAL_INT,
+    N_LITERAL_STRING,
+    N_LITERAL_DECIMAL,
+    N_LITERAL_BOOLEAN,
+    N_LITERAL_NONE,
+    N_ARRAY,
+    N_DICTIONARY,
+    N_DICTIONARY_KEY_VALUE,
+    N_RETURN,
+    N_IDENTIFIER,
+    N_BOOL_AND,
+    N_BOOL_OR,
+    N_BOOL_EQUALS,
+    N_BOOL_NOT_EQUALS,
+    N_BOOL_LESS_THAN,
+    N_BOOL_LESS_THAN_OR_EQUAL,
+    N_BOOL_GREATER_THAN,
+    N_BOOL_GREATER_THAN_OR_EQUAL,
+    N_BIT_SHIFT_LEFT,
+    N_BIT_SHIFT_RIGHT,
+    N_MODULUS_EXPRESSION,
+    N_EXPONENT_EXPRESSION,
+    N_BIT_AND_EXPRESSION,
+    N_BIT_OR_EXPRESSION,
+    N_BIT_XOR_EXPRESSION,
+    N_IF_STATEMENT,
+    N_IF_CONDITION_BLOCK,
+    N_IMPORT,
+    N_IMPORTED_MODULE,
+    N_FROM_IMPORT,
+    N_TRY_STATEMENT,
+    N_CATCH_STATEMENT,
+    N_RAISE_STATEMENT,
+    N_AS,
+    N_FOR_STATEMENT,
+    N_EACH_STATEMENT,
+    N_WHILE_STATEMENT,
+    N_SKIP_STATEMENT,
+    N_KIND_COUNT
+};
 
 class AST {
     public:
         AST();
         AST(Token node_token);
+        AST(Token node_token, NodeKind node_kind);
+        inline static const NodeKind kind = N_AST;
         virtual string getType() { return "AST"; };
+        NodeKind getKind() { return this->nodeKind; };
         void addChild(AST * node);
         AST * popChild();
         void replace(AST * node);
@@ -31,8 +106,8 @@ class AST {
         int getBindingPower();
         int getLineNo();
         bool hasAncestorExpr();
-        bool hasAncestor(string node_type);
-        AST * getAncestor(string node_type);
+        bool hasAncestor(NodeKind node_kind);
+        AST * getAncestor(NodeKind node_kind);
         AST * getSibling(int index);
         bool isNil();
         virtual AST * clone();
@@ -42,15 +117,20 @@ class AST {
         Scope * scope;  // set by Def.cc
         Symbol * symbol;  // set by Ref.cc
         Type * evalType;  // set by Ref.cc
+        int slotDepth;  // set by Ref.cc, 0 for method locals, else -1
+        int slotIndex;  // set by Ref.cc, index into the MethodSpace slots
+        Object * constant;  // set by ConstantVisitor, decoded literal value
     private:
         int index;
         Token token;
+        NodeKind nodeKind;
 };
 
 class ProgramNode : public AST {  
     public:
         ProgramNode();
         inline static const string type = "ProgramNode";
+        inline static const NodeKind kind = N_PROGRAM;
         virtual string getType() override { return this->type; };
         virtual ProgramNode * clone() override { return new ProgramNode(*this); };
     private:
@@ -60,6 +140,7 @@ class VarDeclarationNode : public AST {
     public:
         VarDeclarationNode(Token token);
         inline static const string type = "VarDeclarationNode";
+        inline static const NodeKind kind = N_VAR_DECLARATION;
         virtual string getType() override { return this->type; }; 
         virtual VarDeclarationNode * clone() override { return new VarDeclarationNode(*this); }; 
     private:
@@ -69,6 +150,7 @@ class VarAssignmentNode : public AST {
     public:
         VarAssignmentNode(Token token);
         inline static const string type = "VarAssignmentNode";
+        inline static const NodeKind kind = N_VAR_ASSIGNMENT;
         virtual string getType() override { return this->type; };  
         virtual VarAssignmentNode * clone() override { return new VarAssignmentNode(*this); };
     private:
@@ -78,6 +160,7 @@ class AdditionAssignNode : public AST {
     public:
         AdditionAssignNode(Token token);
         inline static const string type = "AdditionAssignNode";
+        inline static const NodeKind kind = N_ADDITION_ASSIGN;
         virtual string getType() override { return this->type; };  
         virtual AdditionAssignNode * clone() override { return new AdditionAssignNode(*this); };
     private:
@@ -87,6 +170,7 @@ class SubtractionAssignNode : public AST {
     public:
         SubtractionAssignNode(Token token);
         inline static const string type = "SubtractionAssignNode";
+        inline static const NodeKind kind = N_SUBTRACTION_ASSIGN;
         virtual string getType() override { return this->type; };  
         virtual SubtractionAssignNode * clone() override { return new SubtractionAssignNode(*this); };
     private:
@@ -96,6 +180,7 @@ class MultiplicationAssignNode : public AST {
     public:
         MultiplicationAssignNode(Token token);
         inline static const string type = "MultiplicationAssignNode";
+        inline static const NodeKind kind = N_MULTIPLICATION_ASSIGN;
         virtual string getType() override { return this->type; };  
         virtual MultiplicationAssignNode * clone() override { return new MultiplicationAssignNode(*this); };
     private:
@@ -105,6 +190,7 @@ class DivisionAssignNode : public AST {
     public:
         DivisionAssignNode(Token token);
         inline static const string type = "DivisionAssignNode";
+        inline static const NodeKind kind = N_DIVISION_ASSIGN;
         virtual string getType() override { return this->type; };  
         virtual DivisionAssignNode * clone() override { return new DivisionAssignNode(*this); };
     private:
@@ -114,6 +200,7 @@ class BitOrAssignNode : public AST {
     public:
         BitOrAssignNode(Token token);
         inline static const string type = "BitOrAssignNode";
+        inline static const NodeKind kind = N_BIT_OR_ASSIGN;
         virtual string getType() override { return this->type; };  
         virtual BitOrAssignNode * clone() override { return new BitOrAssignNode(*this); };
     private:
@@ -123,6 +210,7 @@ class BitAndAssignNode : public AST {
     public:
         BitAndAssignNode(Token token);
         inline static const string type = "BitAndAssignNode";
+        inline static const NodeKind kind = N_BIT_AND_ASSIGN;
         virtual string getType() override { return this->type; };  
         virtual BitAndAssignNode * clone() override { return new BitAndAssignNode(*this); };
     private:
@@ -132,6 +220,7 @@ class ModifierNode: public AST {
     public:
         ModifierNode(Token token);
         inline static const string type = "ModifierNode";
+        inline static const NodeKind kind = N_MODIFIER;
         virtual string getType() override { return this->type; };
         virtual ModifierNode * clone() override { return new ModifierNode(*this); };
     private:
@@ -141,6 +230,7 @@ class MethodDeclarationNode : public AST {
     public:
         MethodDeclarationNode(Token token);
         inline static const string type = "MethodDeclarationNode";
+        inline static const NodeKind kind = N_METHOD_DECLARATION;
         virtual string getType() override { return this->type; };  
         virtual MethodDeclarationNode * clone() override { return new MethodDeclarationNode(*this); };
     private:
@@ -150,6 +240,7 @@ class MethodCallNode : public AST {
     public:
         MethodCallNode(Token token);
         inline static const string type = "MethodCallNode";
+        inline static const NodeKind kind = N_METHOD_CALL;
         virtual string getType() override { return this->type; };  
         virtual MethodCallNode * clone() override { return new MethodCallNode(*this); };
     private:
@@ -159,6 +250,7 @@ class ClassDeclarationNode : public AST {
     public:
         ClassDeclarationNode(Token token);
         inline static const string type = "ClassDeclarationNode";
+        inline static const NodeKind kind = N_CLASS_DECLARATION;
         virtual string getType() override { return this->type; };  
         virtual ClassDeclarationNode * clone() override { return new ClassDeclarationNode(*this); };
     private:
@@ -168,6 +260,7 @@ class ClassInstantiationNode : public AST {
     public:
         ClassInstantiationNode(Token token);
         inline static const string type = "ClassInstantiationNode";
+        inline static const NodeKind kind = N_CLASS_INSTANTIATION;
         virtual string getType() override { return this->type; };  
         virtual ClassInstantiationNode * clone() override { return new ClassInstantiationNode(*this); };
     private:
@@ -177,6 +270,7 @@ class BlockNode : public AST {
     public:
         BlockNode(Token token);
         inline static const string type = "BlockNode";
+        inline static const NodeKind kind = N_BLOCK;
         virtual string getType() override { return this->type; };  
         virtual BlockNode * clone() override { return new BlockNode(*this); };
     private:
@@ -184,8 +278,9 @@ class BlockNode : public AST {
 
 class BinExpressionNode : public AST {
     public:
-        BinExpressionNode(Token token);
+        BinExpressionNode(Token token, NodeKind node_kind);
         inline static const string type = "BinExpressionNode";
+        inline static const NodeKind kind = N_BIN_EXPRESSION;
         virtual string getType() override { return this->type; };  
         virtual BinExpressionNode * clone() override { return new BinExpressionNode(*this); };
     private:
@@ -193,8 +288,9 @@ class BinExpressionNode : public AST {
 
 class BoolExpressionNode : public AST {
     public:
-        BoolExpressionNode(Token token);
+        BoolExpressionNode(Token token, NodeKind node_kind);
         inline static const string type = "BoolExpressionNode";
+        inline static const NodeKind kind = N_BOOL_EXPRESSION;
         virtual string getType() override { return this->type; };  
         virtual BoolExpressionNode * clone() override { return new BoolExpressionNode(*this); };
     private:
@@ -202,8 +298,9 @@ class BoolExpressionNode : public AST {
 
 class BitExpressionNode : public AST {
     public:
-        BitExpressionNode(Token token);
+        BitExpressionNode(Token token, NodeKind node_kind);
         inline static const string type = "BitExpressionNode";
+        inline static const NodeKind kind = N_BIT_EXPRESSION;
         virtual string getType() override { return this->type; };  
         virtual BitExpressionNode * clone() override { return new BitExpressionNode(*this); };
     private:
@@ -213,6 +310,7 @@ class AddExpressionNode : public BinExpressionNode {
     public:
         AddExpressionNode(Token token);
         inline static const string type = "AddExpressionNode";
+        inline static const NodeKind kind = N_ADD_EXPRESSION;
         virtual string getType() override { return this->type; };  
         virtual AddExpressionNode * clone() override { return new AddExpressionNode(*this); };
     private:
@@ -222,6 +320,7 @@ class SubtractExpressionNode : public BinExpressionNode {
     public:
         SubtractExpressionNode(Token token);
         inline static const string type = "SubtractExpressionNode";
+        inline static const NodeKind kind = N_SUBTRACT_EXPRESSION;
         virtual string getType() override { return this->type; };
         virtual SubtractExpressionNode * clone() override { return new SubtractExpressionNode(*this); };
     private:
@@ -231,6 +330,7 @@ class MultiplyExpressionNode : public BinExpressionNode {
     public:
         MultiplyExpressionNode(Token token);
         inline static const string type = "MultiplyExpressionNode";
+        inline static const NodeKind kind = N_MULTIPLY_EXPRESSION;
         virtual string getType() override { return this->type; };  
         virtual MultiplyExpressionNode * clone() override { return new MultiplyExpressionNode(*this); };
     private:
@@ -240,6 +340,7 @@ class DivideExpressionNode : public BinExpressionNode {
     public:
         DivideExpressionNode(Token token);
         inline static const string type = "DivideExpressionNode";
+        inline static const NodeKind kind = N_DIVIDE_EXPRESSION;
         virtual string getType() override { return this->type; }; 
         virtual DivideExpressionNode * clone() override { return new DivideExpressionNode(*this); }; 
     private:
@@ -249,6 +350,7 @@ class MemberAccessNode : public AST {
     public:
         MemberAccessNode(Token token);
         inline static const string type = "MemberAccessNode";
+        inline static const NodeKind kind = N_MEMBER_ACCESS;
         virtual string getType() override { return this->type; };
         virtual MemberAccessNode * clone() override { return new MemberAccessNode(*this); };
     private:
@@ -258,6 +360,7 @@ class IndexNode : public AST {
     public:
         IndexNode(Token token);
         inline static const string type = "IndexNode";
+        inline static const NodeKind kind = N_INDEX;
         virtual string getType() override { return this->type; };
         virtual IndexNode * clone() override { return new IndexNode(*this); };
     private:
@@ -267,6 +370,7 @@ class ParamsListNode : public AST {
     public:
         ParamsListNode(Token token);
         inline static const string type = "ParamsListNode";
+        inline static const NodeKind kind = N_PARAMS_LIST;
         virtual string getType() override { return this->type; };  
         virtual ParamsListNode * clone() override { return new ParamsListNode(*this); };
     private:
@@ -276,6 +380,7 @@ class ParenthesesNode : public AST {
     public:
         ParenthesesNode(Token token);
         inline static const string type = "ParenthesesNode";
+        inline static const NodeKind kind = N_PARENTHESES;
         virtual string getType() override { return this->type; };  
         virtual ParenthesesNode * clone() override { return new ParenthesesNode(*this); };
     private:
@@ -285,6 +390,7 @@ class SuperClassNode : public AST {
     public:
         SuperClassNode(Token token);
         inline static const string type = "SuperClassNode";
+        inline static const NodeKind kind = N_SUPER_CLASS;
         virtual string getType() override { return this->type; };  
         virtual SuperClassNode * clone() override { return new SuperClassNode(*this); };
     private:
@@ -294,6 +400,7 @@ class LiteralIntNode : public AST {
     public:
         LiteralIntNode(Token token);
         inline static const string type = "LiteralIntNode";
+        inline static const NodeKind kind = N_LITERAL_INT;
         virtual string getType() override { return this->type; };  
         virtual LiteralIntNode * clone() override { return new LiteralIntNode(*this); };
     private:
@@ -303,6 +410,7 @@ class LiteralStringNode : public AST {
     public:
         LiteralStringNode(Token token);
         inline static const string type = "LiteralStringNode";
+        inline static const NodeKind kind = N_LITERAL_STRING;
         virtual string getType() override { return this->type; };  
         virtual LiteralStringNode * clone() override { return new LiteralStringNode(*this); };
     private:
@@ -312,6 +420,7 @@ class LiteralDecimalNode : public AST {
     public:
         LiteralDecimalNode(Token token);
         inline static const string type = "LiteralDecimalNode";
+        inline static const NodeKind kind = N_LITERAL_DECIMAL;
         virtual string getType() override { return this->type; };
         virtual LiteralDecimalNode * clone() override { return new LiteralDecimalNode(*this); };
     private:
@@ -321,6 +430,7 @@ class LiteralBooleanNode : public AST {
     public:
         LiteralBooleanNode(Token token);
         inline static const string type = "LiteralBooleanNode";
+        inline static const NodeKind kind = N_LITERAL_BOOLEAN;
         virtual string getType() override { return this->type; };
         virtual LiteralBooleanNode * clone() override { return new LiteralBooleanNode(*this); };
     private:
@@ -330,6 +440,7 @@ class LiteralNoneNode : public AST {
     public:
         LiteralNoneNode(Token token);
         inline static const string type = "LiteralNoneNode";
+        inline static const NodeKind kind = N_LITERAL_NONE;
         virtual string getType() override { return this->type; };
         virtual LiteralNoneNode * clone() override { return new LiteralNoneNode(*this); };
     private:
@@ -339,6 +450,7 @@ class ArrayNode : public AST {
     public:
         ArrayNode(Token token);
         inline static const string type = "ArrayNode";
+        inline static const NodeKind kind = N_ARRAY;
         virtual string getType() override { return this->type; };
         virtual ArrayNode * clone() override { return new ArrayNode(*this); };
     private:
@@ -348,6 +460,7 @@ class DictionaryNode : public AST {
     public:
         DictionaryNode(Token token);
         inline static const string type = "DictionaryNode";
+        inline static const NodeKind kind = N_DICTIONARY;
         virtual string getType() override { return this->type; };
         virtual DictionaryNode * clone() override { return new DictionaryNode(*this); };
     private:
@@ -356,6 +469,7 @@ class DictionaryKeyValueNode : public AST {
     public:
         DictionaryKeyValueNode(Token token);
         inline static const string type = "DictionaryKeyValueNode";
+        inline static const NodeKind kind = N_DICTIONARY_KEY_VALUE;
         virtual string getType() override { return this->type; };
         virtual DictionaryKeyValueNode * clone() override { return new DictionaryKeyValueNode(*this); };
     private:
@@ -365,6 +479,7 @@ class ReturnNode : public AST {
     public:
         ReturnNode(Token token);
         inline static const string type = "ReturnNode";
+        inline static const NodeKind kind = N_RETURN;
         virtual string getType() override { return this->type; };  
         virtual ReturnNode * clone() override { return new ReturnNode(*this); };
     private:
@@ -374,6 +489,7 @@ class IdentifierNode : public AST {
     public:
         IdentifierNode(Token token);
         inline static const string type = "IdentifierNode";
+        inline static const NodeKind kind = N_IDENTIFIER;
         virtual string getType() override { return this->type; };
         virtual IdentifierNode * clone() override { return new IdentifierNode(*this); };
     private:
@@ -383,6 +499,7 @@ class BoolAndNode : public BoolExpressionNode {
     public:
         BoolAndNode(Token token);
         inline static const string type = "BoolAndNode";
+        inline static const NodeKind kind = N_BOOL_AND;
         virtual string getType() override { return this->type; };
         virtual BoolAndNode * clone() override { return new BoolAndNode(*this); };
     private:
@@ -392,6 +509,7 @@ class BoolOrNode : public BoolExpressionNode {
     public:
         BoolOrNode(Token token);
         inline static const string type = "BoolOrNode";
+        inline static const NodeKind kind = N_BOOL_OR;
         virtual string getType() override { return this->type; };
         virtual BoolOrNode * clone() override { return new BoolOrNode(*this); };
     private:
@@ -401,6 +519,7 @@ class BoolEqualsNode : public BoolExpressionNode {
     public:
         BoolEqualsNode(Token token);
         inline static const string type = "BoolEqualsNode";
+        inline static const NodeKind kind = N_BOOL_EQUALS;
         virtual string getType() override { return this->type; };
         virtual BoolEqualsNode * clone() override { return new BoolEqualsNode(*this); };
     private:
@@ -410,6 +529,7 @@ class BoolNotEqualsNode : public BoolExpressionNode {
     public:
         BoolNotEqualsNode(Token token);
         inline static const string type = "BoolNotEqualsNode";
+        inline static const NodeKind kind = N_BOOL_NOT_EQUALS;
         virtual string getType() override { return this->type; };
         virtual BoolNotEqualsNode * clone() override { return new BoolNotEqualsNode(*this); };
     private:
@@ -419,6 +539,7 @@ class BoolLessThanNode : public BoolExpressionNode {
     public:
         BoolLessThanNode(Token token);
         inline static const string type = "BoolLessThanNode";
+        inline static const NodeKind kind = N_BOOL_LESS_THAN;
         virtual string getType() override { return this->type; };
         virtual BoolLessThanNode * clone() override { return new BoolLessThanNode(*this); };
     private:
@@ -428,6 +549,7 @@ class BoolLessThanOrEqualNode : public BoolExpressionNode {
     public:
         BoolLessThanOrEqualNode(Token token);
         inline static const string type = "BoolLessThanOrEqualNode";
+        inline static const NodeKind kind = N_BOOL_LESS_THAN_OR_EQUAL;
         virtual string getType() override { return this->type; };
         virtual BoolLessThanOrEqualNode * clone() override { return new BoolLessThanOrEqualNode(*this); };
     private:
@@ -437,6 +559,7 @@ class BoolGreaterThanNode : public BoolExpressionNode {
     public:
         BoolGreaterThanNode(Token token);
         inline static const string type = "BoolGreaterThanNode";
+        inline static const NodeKind kind = N_BOOL_GREATER_THAN;
         virtual string getType() override { return this->type; };
         virtual BoolGreaterThanNode * clone() override { return new BoolGreaterThanNode(*this); };
     private:
@@ -446,6 +569,7 @@ class BoolGreaterThanOrEqualNode : public BoolExpressionNode {
     public:
         BoolGreaterThanOrEqualNode(Token token);
         inline static const string type = "BoolGreaterThanOrEqualNode";
+        inline static const NodeKind kind = N_BOOL_GREATER_THAN_OR_EQUAL;
         virtual string getType() override { return this->type; };
         virtual BoolGreaterThanOrEqualNode * clone() override { return new BoolGreaterThanOrEqualNode(*this); };
     private:
@@ -455,6 +579,7 @@ class BitShiftLeftNode : public BitExpressionNode {
     public:
         BitShiftLeftNode(Token token);
         inline static const string type = "BitShiftLeftNode";
+        inline static const NodeKind kind = N_BIT_SHIFT_LEFT;
         virtual string getType() override { return this->type; };
         virtual BitShiftLeftNode * clone() override { return new BitShiftLeftNode(*this); };
     private:
@@ -464,6 +589,7 @@ class BitShiftRightNode : public BitExpressionNode {
     public:
         BitShiftRightNode(Token token);
         inline static const string type = "BitShiftRightNode";
+        inline static const NodeKind kind = N_BIT_SHIFT_RIGHT;
         virtual string getType() override { return this->type; };
         virtual BitShiftRightNode * clone() override { return new BitShiftRightNode(*this); };
     private:
@@ -473,6 +599,7 @@ class ModulusExpressionNode : public BinExpressionNode {
     public:
         ModulusExpressionNode(Token token);
         inline static const string type = "ModulusExpressionNode";
+        inline static const NodeKind kind = N_MODULUS_EXPRESSION;
         virtual string getType() override { return this->type; };
         virtual ModulusExpressionNode * clone() override { return new ModulusExpressionNode(*this); };
     private:
@@ -482,6 +609,7 @@ class ExponentExpressionNode : public BinExpressionNode {
     public:
         ExponentExpressionNode(Token token);
         inline static const string type = "ExponentExpressionNode";
+        inline static const NodeKind kind = N_EXPONENT_EXPRESSION;
         virtual string getType() override { return this->type; };
         virtual ExponentExpressionNode * clone() override { return new ExponentExpressionNode(*this); };
     private:
@@ -491,6 +619,7 @@ class BitAndExpressionNode : public BitExpressionNode {
     public:
         BitAndExpressionNode(Token token);
         inline static const string type = "BitAndExpressionNode";
+        inline static const NodeKind kind = N_BIT_AND_EXPRESSION;
         virtual string getType() override { return this->type; };
         virtual BitAndExpressionNode * clone() override { return new BitAndExpressionNode(*this); };
     private:
@@ -500,6 +629,7 @@ class BitOrExpressionNode : public BitExpressionNode {
     public:
         BitOrExpressionNode(Token token);
         inline static const string type = "BitOrExpressionNode";
+        inline static const NodeKind kind = N_BIT_OR_EXPRESSION;
         virtual string getType() override { return this->type; };
         virtual BitOrExpressionNode * clone() override { return new BitOrExpressionNode(*this); };
     private:
@@ -509,6 +639,7 @@ class BitXorExpressionNode : public BitExpressionNode {
     public:
         BitXorExpressionNode(Token token);
         inline static const string type = "BitXorExpressionNode";
+        inline static const NodeKind kind = N_BIT_XOR_EXPRESSION;
         virtual string getType() override { return this->type; };
         virtual BitXorExpressionNode * clone() override { return new BitXorExpressionNode(*this); };
     private:
@@ -518,6 +649,7 @@ class IfStatementNode : public AST {
     public:
         IfStatementNode(Token token);
         inline static const string type = "IfStatementNode";
+        inline static const NodeKind kind = N_IF_STATEMENT;
         virtual string getType() override { return this->type; };
         virtual IfStatementNode * clone() override { return new IfStatementNode(*this); };
     private:
@@ -527,6 +659,7 @@ class IfConditionBlockNode : public AST {
     public:
         IfConditionBlockNode(Token token);
         inline static const string type = "IfConditionBlockNode";
+        inline static const NodeKind kind = N_IF_CONDITION_BLOCK;
         virtual string getType() override { return this->type; };
         virtual IfConditionBlockNode * clone() override { return new IfConditionBlockNode(*this); };
     private:
@@ -536,6 +669,7 @@ class ImportNode : public AST {
     public:
         ImportNode(Token token);
         inline static const string type = "ImportNode";
+        inline static const NodeKind kind = N_IMPORT;
         virtual string getType() override { return this->type; };
         virtual ImportNode * clone() override { return new ImportNode(*this); };
     private:
@@ -545,6 +679,7 @@ class ImportedModuleNode : public AST {
     public:
         ImportedModuleNode(Token token);
         inline static const string type = "ImportedModuleNode";
+        inline static const NodeKind kind = N_IMPORTED_MODULE;
         virtual string getType() override { return this->type; };
         virtual ImportedModuleNode * clone() override { return new ImportedModuleNode(*this); };
     private:
@@ -555,6 +690,7 @@ class FromImportNode : public AST {
     public:
         FromImportNode(Token token);
         inline static const string type = "FromImportNode";
+        inline static const NodeKind kind = N_FROM_IMPORT;
         virtual string getType() override { return this->type; };
         virtual FromImportNode * clone() override { return new FromImportNode(*this); };
     private:
@@ -564,6 +700,7 @@ class TryStatementNode : public AST {
     public:
         TryStatementNode(Token token);
         inline static const string type = "TryStatementNode";
+        inline static const NodeKind kind = N_TRY_STATEMENT;
         virtual string getType() override { return this->type; };
         virtual TryStatementNode * clone() override { return new TryStatementNode(*this); };
     private:
@@ -573,6 +710,7 @@ class CatchStatementNode : public AST {
     public:
         CatchStatementNode(Token token);
         inline static const string type = "CatchStatementNode";
+        inline static const NodeKind kind = N_CATCH_STATEMENT;
         virtual string getType() override { return this->type; };
         virtual CatchStatementNode * clone() override { return new CatchStatementNode(*this); };
     private:
@@ -582,6 +720,7 @@ class RaiseStatementNode : public AST {
     public:
         RaiseStatementNode(Token token);
         inline static const string type = "RaiseStatementNode";
+        inline static const NodeKind kind = N_RAISE_STATEMENT;
         virtual string getType() override { return this->type; };
         virtual RaiseStatementNode * clone() override { return new RaiseStatementNode(*this); };
     private:
@@ -591,6 +730,7 @@ class AsNode : public AST {
     public:
         AsNode(Token token);
         inline static const string type = "AsNode";
+        inline static const NodeKind kind = N_AS;
         virtual string getType() override { return this->type; };
         virtual AsNode * clone() override { return new AsNode(*this); };
     private:
@@ -600,6 +740,7 @@ class ForStatementNode : public AST {
     public:
         ForStatementNode(Token token);
         inline static const string type = "ForStatementNode";
+        inline static const NodeKind kind = N_FOR_STATEMENT;
         virtual string getType() override { return this->type; };
         virtual ForStatementNode * clone() override { return new ForStatementNode(*this); };
     private:
@@ -609,6 +750,7 @@ class EachStatementNode : public AST {
     public:
         EachStatementNode(Token token);
         inline static const string type = "EachStatementNode";
+        inline static const NodeKind kind = N_EACH_STATEMENT;
         virtual string getType() override { return this->type; };
         virtual EachStatementNode * clone() override { return new EachStatementNode(*this); };
     private:
@@ -618,6 +760,7 @@ class WhileStatementNode : public AST {
     public:
         WhileStatementNode(Token token);
         inline static const string type = "WhileStatementNode";
+        inline static const NodeKind kind = N_WHILE_STATEMENT;
         virtual string getType() override { return this->type; };
         virtual WhileStatementNode * clone() override { return new WhileStatementNode(*this); };
     private:
@@ -627,6 +770,7 @@ class SkipStatementNode : public AST {
     public:
         SkipStatementNode(Token token);
         inline static const string type = "SkipStatementNode";
+        inline static const NodeKind kind = N_SKIP_STATEMENT;
         virtual string getType() override { return this->type; };
         virtual SkipStatementNode * clone() override { return new SkipStatementNode(*this); };
     private:
@@ -10,26 +10,66 @@
 
 #include <fstream>
 #include <string>
+#include <iterator>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /**
- * Reads a file and returns the contents as a string.
- * 
+ * Maps path if it is a regular file of at least MMAP_THRESHOLD bytes;
+ * otherwise, or if mapping fails, isMapped() is false.
+ */
+MappedFile::MappedFile(string path){
+    mapping = nullptr;
+    length = 0;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && size_t(info.st_size) >= MMAP_THRESHOLD){
+        void * memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory != MAP_FAILED){
+            mapping = static_cast<char *>(memory);
+            length = info.st_size;
+            madvise(memory, length, MADV_SEQUENTIAL);
+        }
+    }
+
+    // the mapping stays valid once the descriptor is closed
+    ::close(fd);
+};
+
+MappedFile::~MappedFile(){
+    if (mapping != nullptr) munmap(mapping, length);
+};
+
+/**
+ * Reads a file and returns the contents as a string, ending with a new
+ * line. Large files are mapped and copied once.
+ *
  * @param file The input file path
  * @return string containing contents of the file
  */
 string Util::read_file(string file){
     string sourcecode;
-    string line;
-    ifstream myfile;
-    myfile.open(file);
-    if (myfile.is_open()){
-        while (getline(myfile, line)){
-            sourcecode += line + "\n";
+    MappedFile mapped(file);
+    if (mapped.isMapped()){
+        sourcecode.assign(mapped.data(), mapped.size());
+    }
+    else{
+        ifstream myfile;
+        myfile.open(file, ios::binary);
+        if (!myfile.is_open()){
+            throw IOError("unable to open input file: " + file); 
         }
-        myfile.close();
+        sourcecode.assign(istreambuf_iterator<char>(myfile), istreambuf_iterator<char>());
     }
-    else {
-        throw IOError("unable to open input file: " + file); 
+
+    if (!sourcecode.empty() && sourcecode.back() != '\n'){
+        sourcecode.push_back('\n');
     }
     return sourcecode;
 }
@@ -78,54 +118,38 @@ bool Util::string_has_ending(string const &fullString, string const &ending) {
     }
 }
 
+/**
+ * Returns the escape sequence to_raw_string prints for a character, or
+ * nullptr if it is printed as it is.
+ */
+const char * Util::raw_sequence(char c){
+    switch (c){
+        case '\n': return "\\n";
+        case '\t': return "\\t";
+        case '\v': return "\\v";
+        case '\b': return "\\b";
+        case '\r': return "\\r";
+        case '\f': return "\\f";
+        case '\a': return "\\a";
+        case '\\': return "\\\\";
+        case '\0': return "\\0";
+        default: return nullptr;
+    }
+}
+
 /**
  * Escapes control characters so they are included when printing to the screen.
  */
 string Util::to_raw_string(string const& in)
 {
     string ret;
-    int i = 0;
-    while (i < in.size()){
-        char index = in[i];
-        if (index == '\n'){
-            ret += "\\n";
-            i += 1;
-        }
-        else if (index == '\t'){
-            ret += "\\t";
-            i += 1;
-        }
-        else if (index == '\v'){
-            ret += "\\v";
-            i += 1;
-        }
-        else if (index == '\b'){
-            ret += "\\b";
-            i += 1;
-        }
-        else if (index == '\r'){
-            ret += "\\r";
-            i += 1;
-        }
-        else if (index == '\f'){
-            ret += "\\f";
-            i += 1;
-        }
-        else if (index == '\a'){
-            ret += "\\a";
-            i += 1;
-        }
-        else if (index == '\\'){
-            ret += "\\\\";
-            i += 1;
-        }
-        else if (index == '\0'){
-            ret += "\\0";
-            i += 1;
-        }
-        else{
-            ret += index;
-            i += 1;
+    ret.reserve(in.size());
+    for (int i=0; i<in.size(); i++){
+        const char * sequence = Util::raw_sequence(in[i]);
+        if (sequence != nullptr){
+            ret += sequence;
+        }else{
+            ret += in[i];
         }
     }
     return ret;
@@ -182,4 +206,61 @@ string Util::escape_raw_string(string input){
         }
     }
     return newString;
-}
\ No newline at end of file
+}
+
+int ToRawStringBuffer::overflow(int c){
+    if (c == traits_type::eof()) return traits_type::not_eof(c);
+    char ch = char(c);
+    this->xsputn(&ch, 1);
+    return c;
+}
+
+/** Passes runs of plain characters on in one write. */
+streamsize ToRawStringBuffer::xsputn(const char * data, streamsize size){
+    streamsize start = 0;
+    for (streamsize i=0; i<size; i++){
+        const char * sequence = Util::raw_sequence(data[i]);
+        if (sequence == nullptr) continue;
+        this->target.write(data + start, i - start);
+        this->target << sequence;
+        start = i + 1;
+    }
+    this->target.write(data + start, size - start);
+    return size;
+}
+
+int EscapeRawStringBuffer::overflow(int c){
+    if (c == traits_type::eof()) return traits_type::not_eof(c);
+    char ch = char(c);
+    if (!this->pendingBackslash){
+        if (ch == '\\') this->pendingBackslash = true;
+        else this->target.put(ch);
+        return c;
+    }
+
+    this->pendingBackslash = false;
+    switch (ch){
+        case 'n': this->target.put('\n'); break;
+        case 't': this->target.put('\t'); break;
+        case 'v': this->target.put('\v'); break;
+        case 'b': this->target.put('\b'); break;
+        case 'r': this->target.put('\r'); break;
+        case 'f': this->target.put('\f'); break;
+        case 'a': this->target.put('\a'); break;
+        case '\\': this->target.put('\\'); break;
+        case '0': this->target.put('\0'); break;
+        default:
+            this->target.put('\\');
+            this->overflow(c);
+    }
+    return c;
+}
+
+/** A trailing backslash has nothing left to escape, so it is passed on. */
+int EscapeRawStringBuffer::sync(){
+    if (this->pendingBackslash){
+        this->target.put('\\');
+        this->pendingBackslash = false;
+    }
+    return 0;
+}
@@ -4,9 +4,65 @@
 #include <brio_lang/exceptions.h>
 
 #include <string>
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
 
 using namespace std;
 
+/**
+ * Read-only memory mapping of a regular file. Pipes, special files and
+ * files smaller than MMAP_THRESHOLD are not mapped; callers read those
+ * through a stream instead. The file should not be truncated while it is
+ * mapped.
+ */
+class MappedFile {
+    public:
+        MappedFile(string path);
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator=(const MappedFile &) = delete;
+        ~MappedFile();
+        bool isMapped(){ return mapping != nullptr; };
+        const char * data(){ return mapping; };
+        size_t size(){ return length; };
+        inline static const size_t MMAP_THRESHOLD = 64 * 1024;
+    private:
+        char * mapping;
+        size_t length;
+};
+
+/**
+ * Stream buffer that escapes control characters the way to_raw_string
+ * does while passing everything on to another stream, so nested values
+ * can be escaped without building their string first.
+ */
+class ToRawStringBuffer : public streambuf {
+    public:
+        ToRawStringBuffer(ostream & target) : target(target){};
+    protected:
+        int overflow(int c);
+        streamsize xsputn(const char * data, streamsize size);
+    private:
+        ostream & target;
+};
+
+/**
+ * Stream buffer that decodes escape sequences the way escape_raw_string
+ * does while passing everything on to another stream. Unknown sequences
+ * are passed on as they are.
+ */
+class EscapeRawStringBuffer : public streambuf {
+    public:
+        EscapeRawStringBuffer(ostream & target) : target(target), pendingBackslash(false){};
+        ~EscapeRawStringBuffer(){ sync(); };
+    protected:
+        int overflow(int c);
+        int sync();
+    private:
+        ostream & target;
+        bool pendingBackslash;  // the last character was a backslash
+};
+
 class Util {
     public:
         static void write_file(string file, string data);
@@ -14,6 +70,7 @@ class Util {
         static bool string_has_ending(string const &fullString, string const &ending);
         static string escape_raw_string(string input);
         static string to_raw_string(string const& in);
+        static const char * raw_sequence(char c);
         static bool file_exists(string path);
     private:
 };
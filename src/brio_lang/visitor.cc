@@ -7,6 +7,8 @@
 
 #include <brio_lang/visitor.h>
 #include <brio_lang/tree.h>
+#include <brio_lang/object.h>
+#include <brio_lang/util.h>
 
 
 /**
@@ -31,7 +33,7 @@ void IndependentPrintVisitor::visit(AST * node, int depth){
 AST * getMainMethod(ProgramNode * node){
     for (int i=0; i < node->children.size(); i++){
         AST * child = node->children[i];
-        if (child->getType() == MethodDeclarationNode::type){
+        if (child->getKind() == MethodDeclarationNode::kind){
             AST * identifier = child->children[0];
             if (identifier->getNodeText() == "main"){
                 return child;
@@ -55,7 +57,7 @@ void InvokeMainMethodPrint::visit(ProgramNode * node){
         AST * block_elem = main_block->children[z];
         
         // look for method call
-        if (block_elem->getType() == MethodCallNode::type){
+        if (block_elem->getKind() == MethodCallNode::kind){
             string method_name = block_elem->children[0]->getNodeText();
             if (method_name == "print"){
 
@@ -102,4 +104,47 @@ void OperatorPrecedenceVisitor::visit(AST * node){
     for (int i=0; i < nextNode->children.size(); i++){
         this->visit(nextNode->children[i]);
     }
-};
\ No newline at end of file
+};
+
+/** Visitor that decodes each literal once, after parsing, and keeps the
+ * value on its node so literals are not re-parsed on every execution.
+ * Literal objects are never modified in place, so the value is shared.
+ */
+void ConstantVisitor::visit(AST * node){
+    ConstantVisitor::materialize(node);
+
+    for (int i=0; i < node->children.size(); i++){
+        this->visit(node->children[i]);
+    }
+};
+
+/**
+ * Returns the decoded value of a literal node, decoding it on first use
+ * for trees that were not visited. Returns nullptr for other nodes.
+ */
+Object * ConstantVisitor::materialize(AST * node){
+    if (node->constant != nullptr) return node->constant;
+
+    switch (node->getKind()){
+        case LiteralIntNode::kind:
+            node->constant = new Integer(node->getNodeText());
+            break;
+        case LiteralStringNode::kind:
+            node->constant = new String(Util::escape_raw_string(node->getNodeText()));
+            break;
+        case LiteralDecimalNode::kind:
+            node->constant = new Decimal(node->getNodeText());
+            break;
+        case LiteralBooleanNode::kind:
+            node->constant = new Boolean(node->getNodeText());
+            break;
+        case LiteralNoneNode::kind:
+            node->constant = None::get();
+            break;
+        default:
+            break;
+    }
+    // literals live as long as the tree, never collected
+    if (node->constant != nullptr) Heap::instance().pin(node->constant);
+    return node->constant;
+};
@@ -32,4 +32,11 @@ class OperatorPrecedenceVisitor : TreeVisitor {
     private:
 };
 
+class ConstantVisitor : TreeVisitor {
+    public:
+        void visit(AST * node);
+        static Object * materialize(AST * node);
+    private:
+};
+
 #endif  // BRIOLANG_SRC_VISITOR_H_
\ No newline at end of file
@@ -0,0 +1,618 @@
+///
+/// Brio Lang
+/// vm.cc
+///
+/// Bytecode Virtual Machine
+///
+
+#include <brio_lang/vm.h>
+#include <brio_lang/exceptions.h>
+#include <brio_lang/object.h>
+
+#include <string>
+#include <iostream>
+
+
+Frame::Frame(CodeObject * frame_code, MethodSpace * frame_space){
+    code = frame_code;
+    space = frame_space;
+    saveSpace = nullptr;
+    instance = nullptr;
+    exceptionObject = nullptr;
+    pc = 0;
+    sp = 0;
+};
+
+VM::VM(Interpreter * interp) : compiler(interp->table){
+    interpreter = interp;
+};
+
+/**
+ * Calls a method with the provided arguments and runs it to completion,
+ * on class_inst when it is not nullptr.
+ */
+Object * VM::invoke(MethodSymbol * method, vector<Object*> params, ClassInstance * class_inst){
+    int base = int(this->frames.size());
+    int sp = int(this->stack.size());
+    for (int i=0; i<int(params.size()); i++){
+        this->push(params[i]);
+    }
+
+    try{
+        this->call(method, class_inst, nullptr, int(params.size()), int(params.size()));
+    }catch (...){
+        this->stack.resize(sp);
+        throw;
+    }
+    return this->run(base);
+};
+
+/**
+ * Compiles and runs a single node, returning the value of expressions.
+ */
+Object * VM::exec(AST * node){
+    int base = int(this->frames.size());
+    Frame * frame = new Frame(this->compiler.compileNode(node), nullptr);
+    this->enter(frame);
+    return this->run(base);
+};
+
+/**
+ * Runs frames above base until the bottom one returns. Exceptions are
+ * routed to the nearest try handler, else propagated to the caller.
+ */
+Object * VM::run(int base){
+    while (true){
+        try{
+            return this->dispatch(base);
+        }
+        catch (...){
+            if (!this->unwind(base, std::current_exception())) throw;
+        }
+    }
+};
+
+/**
+ * Pops frames until one with a try handler is found. Only Brio exceptions
+ * (raised nodes and BaseException) may be caught.
+ */
+bool VM::unwind(int base, exception_ptr e){
+    bool catchable = true;
+    string exceptionId;
+    string exceptionMessage;
+    void * exceptionObject = nullptr;
+
+    try{
+        std::rethrow_exception(e);
+    }
+    catch (const AST * raiseNode){
+        exceptionId = raiseNode->children[0]->getNodeText();
+        exceptionMessage = this->interpreter->raiseMessage;
+    }
+    catch (BaseException & exc){
+        exceptionId = exc.getType();
+        exceptionMessage = exc.what();
+        exceptionObject = &exc;
+    }
+    catch (...){
+        catchable = false;
+    }
+
+    while (int(this->frames.size()) > base){
+        Frame * frame = this->frames.back();
+        if (catchable && frame->handlers.size() > 0){
+            Handler handler = frame->handlers.back();
+            frame->handlers.pop_back();
+            this->stack.resize(handler.sp);
+            frame->pc = handler.target;
+
+            // keep the exception alive while its catch block runs
+            frame->exception = e;
+            frame->exceptionId = exceptionId;
+            frame->exceptionMessage = exceptionMessage;
+            frame->exceptionObject = exceptionObject;
+            return true;
+        }
+        this->leave();
+    }
+    return false;
+};
+
+Object * VM::dispatch(int base){
+    Frame * frame = this->frames.back();
+
+    while (true){
+        CodeObject * code = frame->code;
+        Instruction ins = code->code[frame->pc++];
+
+        switch (ins.op){
+            case OP_LOAD_CONST:
+                this->push(code->constants[ins.a]);
+                break;
+            case OP_LOAD_NAME:
+                this->push(this->interpreter->load(code->nodes[ins.a]));
+                break;
+            case OP_STORE_NAME:
+                this->interpreter->store(code->nodes[ins.a], this->pop());
+                break;
+            case OP_DECLARE_NAME:
+                this->interpreter->currentSpace->put(code->names[ins.a], this->pop());
+                break;
+            case OP_LOAD_LOCAL: {
+                // unset slots fall back to module and global lookup
+                Object * value = frame->space->slots[ins.a];
+                if (value == nullptr) value = this->interpreter->load(code->nodes[ins.b]);
+                this->push(value);
+                break;
+            }
+            case OP_STORE_LOCAL:
+                if (frame->space->slots[ins.a] != nullptr){
+                    frame->space->slots[ins.a] = this->popValue();
+                }else{
+                    this->interpreter->store(code->nodes[ins.b], this->pop());
+                }
+                break;
+            case OP_DECLARE_LOCAL:
+                frame->space->slots[ins.a] = this->popValue();
+                break;
+            case OP_LOAD_ATTR: {
+                Object * obj = this->pop();
+                string id = code->names[ins.a];
+                MemorySpace * space = dynamic_cast<MemorySpace*>(obj);
+                if (space == nullptr){
+                    throw AttributeError(obj->toString() + " is not a class instance");
+                }
+                Object * value = space->get(id);
+                if (value == nullptr){
+                    throw AttributeError(obj->toString() + " has no member '" + id + "'");
+                }
+                this->push(value);
+                break;
+            }
+            case OP_STORE_ATTR: {
+                Object * obj = this->pop();
+                Object * value = this->pop();
+                ClassInstance * class_inst = dynamic_cast<ClassInstance*>(obj);
+                if (class_inst == nullptr){
+                    throw RuntimeError("invalid member assignment");
+                }
+                class_inst->put(code->names[ins.a], value);
+                break;
+            }
+            case OP_INDEX: {
+                Object * idx = this->pop();
+                Object * obj = this->pop();
+                this->push(obj->index(idx));
+                break;
+            }
+            case OP_STORE_INDEX: {
+                Object * idx = this->pop();
+                Object * obj = this->pop();
+                Object * value = this->pop();
+
+                // a range is copied into an Array the first time it is assigned to
+                if (dynamic_cast<Range*>(obj) != nullptr){
+                    obj = static_cast<Range*>(obj)->materialize();
+                }
+                if (dynamic_cast<Array*>(obj) != nullptr){
+                    Array * arrayObj = dynamic_cast<Array*>(obj);
+                    if (dynamic_cast<Integer*>(idx) == nullptr){
+                        throw IndexError("array index must be integer, not '" + idx->toString() + "'");
+                    }
+
+                    // make sure index is valid
+                    int i = dynamic_cast<Integer*>(idx)->value;
+                    if (i < 0){
+                        throw IndexError("array index cannot be less than 0");
+                    }
+                    else if (i > int(arrayObj->value.size()) - 1){
+                        throw IndexError("index cannot be larger than size of array");
+                    }
+                    arrayObj->value[i] = value;
+                    Heap::instance().writeBarrier(arrayObj, value);
+                }
+                else if (dynamic_cast<Dictionary*>(obj) != nullptr){
+                    Dictionary * dictObj = dynamic_cast<Dictionary*>(obj);
+
+                    // overwrite key if already exists, otherwise add new
+                    dictObj->value.put(idx, value);
+                    Heap::instance().writeBarrier(dictObj, idx);
+                    Heap::instance().writeBarrier(dictObj, value);
+                }
+                else{
+                    throw RuntimeError("invalid member assignment");
+                }
+                break;
+            }
+            case OP_ADD: {
+                Object * rhs = this->popValue();
+                this->push(SmallInteger::add(this->popValue(), rhs));
+                break;
+            }
+            case OP_SUBTRACT: {
+                Object * rhs = this->popValue();
+                this->push(SmallInteger::subtract(this->popValue(), rhs));
+                break;
+            }
+            case OP_MULTIPLY: {
+                Object * rhs = this->popValue();
+                this->push(SmallInteger::multiply(this->popValue(), rhs));
+                break;
+            }
+            case OP_DIVIDE: {
+                Object * rhs = this->pop();
+                if (dynamic_cast<Integer*>(rhs) != nullptr && dynamic_cast<Integer*>(rhs)->value == 0){
+                    throw ZeroDivisionError("division by zero", ins.b);
+                }
+                if (dynamic_cast<Decimal*>(rhs) != nullptr && dynamic_cast<Decimal*>(rhs)->value == 0.0){
+                    throw ZeroDivisionError("decimal division by zero", ins.b);
+                }
+                this->push(this->pop()->divide(rhs));
+                break;
+            }
+            case OP_MODULUS: {
+                Object * rhs = this->pop();
+                this->push(this->pop()->modulus(rhs));
+                break;
+            }
+            case OP_EXPONENT: {
+                Object * rhs = this->pop();
+                this->push(this->pop()->exponent(rhs));
+                break;
+            }
+            case OP_BIT_AND: {
+                Object * rhs = this->pop();
+                this->push(this->pop()->bitAnd(rhs));
+                break;
+            }
+            case OP_BIT_OR: {
+                Object * rhs = this->pop();
+                this->push(this->pop()->bitOr(rhs));
+                break;
+            }
+            case OP_BIT_XOR: {
+                Object * rhs = this->pop();
+                this->push(this->pop()->bitXor(rhs));
+                break;
+            }
+            case OP_BIT_SHIFT_LEFT: {
+                Object * rhs = this->pop();
+                this->push(this->pop()->bitShiftLeft(rhs));
+                break;
+            }
+            case OP_BIT_SHIFT_RIGHT: {
+                Object * rhs = this->pop();
+                this->push(this->pop()->bitShiftRight(rhs));
+                break;
+            }
+            case OP_BOOL_AND: {
+                Object * rhs = this->pop();
+                this->push(this->pop()->boolAnd(rhs));
+                break;
+            }
+            case OP_BOOL_OR: {
+                Object * rhs = this->pop();
+                this->push(this->pop()->boolOr(rhs));
+                break;
+            }
+            case OP_BOOL_EQUALS: {
+                Object * rhs = this->popValue();
+                this->push(SmallInteger::equals(this->popValue(), rhs));
+                break;
+            }
+            case OP_BOOL_NOT_EQUALS: {
+                Object * rhs = this->popValue();
+                this->push(SmallInteger::notEquals(this->popValue(), rhs));
+                break;
+            }
+            case OP_BOOL_LESS_THAN: {
+                Object * rhs = this->popValue();
+                this->push(SmallInteger::lessThan(this->popValue(), rhs));
+                break;
+            }
+            case OP_BOOL_LESS_THAN_OR_EQUAL: {
+                Object * rhs = this->popValue();
+                this->push(SmallInteger::lessThanOrEqual(this->popValue(), rhs));
+                break;
+            }
+            case OP_BOOL_GREATER_THAN: {
+                Object * rhs = this->popValue();
+                this->push(SmallInteger::greaterThan(this->popValue(), rhs));
+                break;
+            }
+            case OP_BOOL_GREATER_THAN_OR_EQUAL: {
+                Object * rhs = this->popValue();
+                this->push(SmallInteger::greaterThanOrEqual(this->popValue(), rhs));
+                break;
+            }
+            case OP_BUILD_ARRAY:
+                this->push(new Array(this->popArguments(ins.a)));
+                break;
+            case OP_BUILD_DICTIONARY: {
+                vector<Object*> items = this->popArguments(ins.a * 2);
+                Dictionary * dict = new Dictionary();
+                for (int i=0; i<int(items.size()); i+=2){
+                    dict->value.put(items[i], items[i+1]);
+                }
+                this->push(dict);
+                break;
+            }
+            case OP_POP:
+                this->stack.pop_back();
+                break;
+            case OP_SWAP: {
+                int top = int(this->stack.size()) - 1;
+                std::swap(this->stack[top], this->stack[top-1]);
+                break;
+            }
+            case OP_JUMP:
+                if (ins.a < frame->pc) this->safepoint();
+                frame->pc = ins.a;
+                break;
+            case OP_JUMP_IF_FALSE: {
+                Object * cond = this->pop();
+                Boolean * boolCond = dynamic_cast<Boolean*>(cond);
+                bool truthy = (boolCond != nullptr) ? boolCond->value : cond->toString() == Literals::TRUE;
+                if (!truthy) frame->pc = ins.a;
+                break;
+            }
+            case OP_CALL:
+                this->call(code->methods[ins.a], nullptr, nullptr, ins.b, ins.b);
+                frame = this->frames.back();
+                break;
+            case OP_CALL_MEMBER:
+            case OP_CALL_SUPER: {
+                string method_id = code->names[ins.a];
+                Object * obj = SmallInteger::box(this->stack[this->stack.size() - ins.b - 1]);
+
+                // built-in types dispatch to their own methods
+                if (this->interpreter->isBuiltInType(obj)){
+                    Array * params = new Array(this->popArguments(ins.b));
+                    this->stack.pop_back();
+                    this->push(obj->builtIn(method_id, params));
+                    break;
+                }
+
+                // obj must be a class instance or imported instance
+                MethodSymbol * method_sym = nullptr;
+                ClassInstance * class_inst = dynamic_cast<ClassInstance*>(obj);
+                ImportedInstance * import_inst = dynamic_cast<ImportedInstance*>(obj);
+                if (class_inst != nullptr){
+                    ClassSymbol * class_sym = class_inst->symbol;
+                    if (ins.op == OP_CALL_SUPER) class_sym = class_sym->superClass;
+                    if (class_sym != nullptr){
+                        method_sym = dynamic_cast<MethodSymbol*>(class_sym->resolveMember(method_id));
+                    }
+                }
+                else if (import_inst != nullptr){
+                    method_sym = dynamic_cast<MethodSymbol*>(import_inst->symbol->resolveMember(method_id));
+                }
+                else{
+                    throw RuntimeError("invalid method call, not a class instance");
+                }
+
+                if (method_sym == nullptr){
+                    throw NameError("method '" + method_id + "' not found in " + this->interpreter->currentSpace->toString());
+                }
+                this->call(method_sym, class_inst, nullptr, ins.b, ins.b + 1);
+                frame = this->frames.back();
+                break;
+            }
+            case OP_CALL_BUILT_IN: {
+                vector<Object*> args = this->popArguments(ins.b);
+                this->push(this->interpreter->builtInMethodCall(code->names[ins.a], args));
+                break;
+            }
+            case OP_NEW:
+            case OP_NEW_FROM_MODULE: {
+                string className = code->names[ins.a];
+                Object * obj = this->stack[this->stack.size() - ins.b - 1];
+
+                ClassInstance * classTemplate = nullptr;
+                if (ins.op == OP_NEW_FROM_MODULE){
+                    ImportedInstance * import_inst = dynamic_cast<ImportedInstance*>(obj);
+                    if (import_inst == nullptr){
+                        throw RuntimeError("invalid class instatiation access");
+                    }
+                    classTemplate = dynamic_cast<ClassInstance*>(import_inst->get(className));
+                }else{
+                    classTemplate = dynamic_cast<ClassInstance*>(obj);
+                }
+                if (classTemplate == nullptr){
+                    throw RuntimeError("invalid ClassSymbol '" + className + "'");
+                }
+
+                // run the init method, if any, in a frame returning the instance
+                ClassInstance * class_instance = static_cast<ClassInstance*>(classTemplate->clone());
+                MethodSymbol * initSymbol = dynamic_cast<MethodSymbol*>(class_instance->symbol->resolveMember("init"));
+                if (initSymbol == nullptr){
+                    this->stack.resize(this->stack.size() - ins.b - 1);
+                    this->push(class_instance);
+                    break;
+                }
+                this->call(initSymbol, class_instance, class_instance, ins.b, ins.b + 1);
+                frame = this->frames.back();
+                break;
+            }
+            case OP_RETURN:
+            case OP_RETURN_NONE: {
+                Object * result = (ins.op == OP_RETURN) ? this->pop() : nullptr;
+                if (frame->instance != nullptr) result = frame->instance;
+                this->leave();
+                if (int(this->frames.size()) == base) return result;
+                this->push(result);
+                frame = this->frames.back();
+                break;
+            }
+            case OP_ITER_INIT: {
+                // the iterable stays on the stack while a class 'iter' runs
+                Iterator * iter = this->interpreter->iter(SmallInteger::box(this->stack.back()));
+                this->stack.back() = iter;
+                break;
+            }
+            case OP_ITER_NEXT: {
+                Iterator * iter = static_cast<Iterator*>(this->stack.back());
+                Object * element = iter->next();
+                if (element == nullptr){
+                    this->stack.pop_back();
+                    frame->pc = ins.a;
+                }else{
+                    this->push(element);
+                }
+                break;
+            }
+            case OP_SETUP_TRY: {
+                Handler handler = {ins.a, int(this->stack.size())};
+                frame->handlers.push_back(handler);
+                break;
+            }
+            case OP_POP_TRY:
+                frame->handlers.pop_back();
+                break;
+            case OP_CATCH: {
+                AST * catchBlock = this->interpreter->selectCatch(
+                    code->nodes[ins.a], frame->exceptionId,
+                    frame->exceptionMessage, frame->exceptionObject);
+                frame->pc = code->blockTargets[catchBlock];
+                break;
+            }
+            case OP_RAISE:
+                this->interpreter->raiseMessage = ins.b ? this->pop()->toString() : "";
+                throw code->nodes[ins.a];
+            case OP_NAME_ERROR:
+                throw NameError("method '" + code->names[ins.a] + "' not found in " + this->interpreter->currentSpace->toString());
+            case OP_SKIP_ERROR:
+                throw SyntaxError("syntax error: 'skip' not properly in loop");
+            default:
+                throw NotImplementedError("vm: unimplemented opcode");
+        }
+    }
+};
+
+/**
+ * Binds argc arguments from the operand stack into a new method space and
+ * enters its frame. drop also counts the receiver below the arguments.
+ */
+void VM::call(MethodSymbol * method_sym, ClassInstance * class_inst, ClassInstance * instance, int argc, int drop){
+    string method_id = method_sym->getSymbolName();
+
+    // verify arguments
+    AST * methParams = method_sym->def_node->parent->children[2];
+    if (methParams->getChildCount() > argc){
+        throw TypeError("too few parameters provided for '" + method_id + "'");
+    }else if (methParams->getChildCount() < argc){
+        throw TypeError("too many parameters provided for '" + method_id + "'");
+    }
+
+    // add class instance and super to method space
+    MethodSpace * methSpace = new MethodSpace(method_sym);
+    if (class_inst != nullptr){
+        methSpace->put(Literals::THIS, class_inst);
+
+        if (class_inst->symbol->superClass != nullptr){
+            methSpace->put(Literals::SUPER, class_inst);
+        }
+    }
+
+    // define arguments
+    int first = int(this->stack.size()) - argc;
+    for (int i=0; i<argc; i++){
+        AST * formalName = methParams->children[i];
+        methSpace->put(formalName->getNodeText(), SmallInteger::box(this->stack[first + i]));
+    }
+    this->stack.resize(this->stack.size() - drop);
+
+    Frame * frame = new Frame(this->getCode(method_sym), methSpace);
+    frame->instance = instance;
+    this->enter(frame);
+};
+
+void VM::enter(Frame * frame){
+    frame->sp = int(this->stack.size());
+    frame->saveSpace = this->interpreter->currentSpace;
+    if (frame->space != nullptr){
+        this->interpreter->currentSpace = frame->space;
+        this->interpreter->stack.push(frame->space);
+    }
+    this->frames.push_back(frame);
+    this->safepoint();
+};
+
+/** Pops the top frame, restoring the operand stack and memory space. */
+void VM::leave(){
+    Frame * frame = this->frames.back();
+    this->frames.pop_back();
+    this->stack.resize(frame->sp);
+    if (frame->space != nullptr){
+        this->interpreter->stack.pop();
+    }
+    this->interpreter->currentSpace = frame->saveSpace;
+    delete frame->space;
+    delete frame;
+};
+
+/**
+ * Collects garbage once the heap has grown past its threshold. Called on
+ * backward jumps and frame entry, where every live value is on the operand
+ * stack or in a frame.
+ */
+void VM::safepoint(){
+    if (Heap::instance().shouldCollect()){
+        this->interpreter->collectGarbage();
+    }
+};
+
+/** Marks the operand stack and the spaces and instances held by frames. */
+void VM::trace(Heap * heap){
+    for (int i=0; i<this->stack.size(); i++){
+        heap->mark(this->stack[i]);
+    }
+    for (int i=0; i<this->frames.size(); i++){
+        Frame * frame = this->frames[i];
+        if (frame->space != nullptr) frame->space->trace(heap);
+        if (frame->saveSpace != nullptr){
+            heap->mark(dynamic_cast<Object*>(frame->saveSpace));
+            frame->saveSpace->trace(heap);
+        }
+        heap->mark(frame->instance);
+    }
+};
+
+/** Returns the bytecode for a method, compiling it on first use. */
+CodeObject * VM::getCode(MethodSymbol * method){
+    map<MethodSymbol *, CodeObject *>::iterator it = this->codeCache.find(method);
+    if (it != this->codeCache.end()){
+        return it->second;
+    }
+    CodeObject * code = this->compiler.compileMethod(method);
+    this->codeCache[method] = code;
+    return code;
+};
+
+vector<Object*> VM::popArguments(int argc){
+    vector<Object*> args(this->stack.end() - argc, this->stack.end());
+    this->stack.resize(this->stack.size() - argc);
+    for (int i=0; i<argc; i++){
+        args[i] = SmallInteger::box(args[i]);
+    }
+    return args;
+};
+
+/** Pops the top value, boxing a tagged integer into an Integer. */
+Object * VM::pop(){
+    return SmallInteger::box(this->popValue());
+};
+
+/**
+ * Pops the top value as it is, so a tagged integer stays tagged. Only for
+ * method slots and the arithmetic and comparison paths.
+ */
+Object * VM::popValue(){
+    Object * value = this->stack.back();
+    this->stack.pop_back();
+    return value;
+};
+
+void VM::push(Object * value){
+    this->stack.push_back(value);
+};
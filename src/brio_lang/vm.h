@@ -0,0 +1,65 @@
+#ifndef BRIOLANG_SRC_VM_H_
+#define BRIOLANG_SRC_VM_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <exception>
+
+#include <brio_lang/compiler.h>
+#include <brio_lang/interpreter.h>
+#include <brio_lang/object.h>
+
+using namespace std;
+
+
+struct Handler {
+    int target;
+    int sp;
+};
+
+class Frame {
+    public:
+        Frame(CodeObject * frame_code, MethodSpace * frame_space);
+        CodeObject * code;
+        MethodSpace * space;
+        MemorySpace * saveSpace;
+        ClassInstance * instance;
+        vector<Handler> handlers;
+        exception_ptr exception;
+        string exceptionId;
+        string exceptionMessage;
+        void * exceptionObject;
+        int pc;
+        int sp;
+    private:
+};
+
+class VM {
+    public:
+        VM(Interpreter * interpreter);
+        Object * invoke(MethodSymbol * method, vector<Object*> params, ClassInstance * class_inst);
+        Object * exec(AST * node);
+        bool isRunning(){ return !frames.empty(); };
+        void trace(Heap * heap);
+    private:
+        void safepoint();
+        Object * run(int base);
+        Object * dispatch(int base);
+        bool unwind(int base, exception_ptr e);
+        void call(MethodSymbol * method, ClassInstance * class_inst, ClassInstance * instance, int argc, int drop);
+        void enter(Frame * frame);
+        void leave();
+        CodeObject * getCode(MethodSymbol * method);
+        vector<Object*> popArguments(int argc);
+        Object * pop();
+        Object * popValue();
+        void push(Object * value);
+        Interpreter * interpreter;
+        BytecodeCompiler compiler;
+        map<MethodSymbol *, CodeObject *> codeCache;
+        vector<Frame *> frames;
+        vector<Object *> stack;
+};
+
+#endif  // BRIOLANG_SRC_VM_H_
@@ -6,8 +6,31 @@
 #include <brio_lang/visitor.h>
 #include <brio_lang/def.h>
 #include <brio_lang/ref.h>
+#include <brio_lang/vm.h>
+#include <brio_lang/exceptions.h>
+#include <brio_lang/heap.h>
+#include <brio_lang/http.h>
+#include <brio_lang/util.h>
+#include <brio_lang/output.h>
 
-Object * exec(string code){
+#include <cstdio>
+#include <climits>
+#include <fstream>
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** Runs each test on both the tree-walker and the bytecode vm. */
+class InterpreterTest : public ::testing::TestWithParam<string> {};
+
+Object * exec(string code, string engine){
     BrioLexer lexer(code);
     BrioParser parser(&lexer);
     ProgramNode tree = parser.program();
@@ -23,47 +46,797 @@ Object * exec(string code){
     Ref ref(&symbol_table);
     ref.downUp(&tree);
 
-    // execute the tree-based interpreter
+    // execute with the selected engine
     Interpreter interpreter(&tree, &symbol_table);
+    if (engine == "vm"){
+        VM vm(&interpreter);
+        return vm.exec(tree.children[0]);
+    }
     return interpreter.exec(tree.children[0]);
 };
 
-TEST(InterpreterTest, IntegerAddition){
-    Object * result = exec("1 + 1");
+Object * run(string code, string engine){
+    BrioLexer lexer(code);
+    BrioParser parser(&lexer);
+    ProgramNode tree = parser.program();
+
+    OperatorPrecedenceVisitor opVisitor;
+    opVisitor.visit(&tree);
+
+    SymbolTable symbol_table;
+    Def def(&symbol_table);
+    def.downUp(&tree);
+
+    Ref ref(&symbol_table);
+    ref.downUp(&tree);
+
+    // execute the program, then its main method
+    Interpreter interpreter(&tree, &symbol_table);
+    interpreter.setEngine(engine);
+    interpreter.exec(&tree);
+    return interpreter.main();
+};
+
+/**
+ * Minimal keep-alive HTTP server on a free local port, standing in for a
+ * remote host. Answers every request with its path followed by its body
+ * and counts the connections it accepts.
+ */
+class LocalHttpServer {
+    public:
+        LocalHttpServer(){
+            connections = 0;
+            stopped = false;
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            bind(listener, (sockaddr *) &address, sizeof(address));
+            socklen_t length = sizeof(address);
+            getsockname(listener, (sockaddr *) &address, &length);
+            port = ntohs(address.sin_port);
+            listen(listener, 8);
+            worker = std::thread(&LocalHttpServer::serve, this);
+        };
+        ~LocalHttpServer(){
+            stopped = true;
+            worker.join();
+            close(listener);
+        };
+        string url(){ return "http://127.0.0.1:" + std::to_string(port); };
+        std::atomic<int> connections;
+    private:
+        void serve(){
+            std::vector<pollfd> fds = {{listener, POLLIN, 0}};
+            std::map<int, string> requests;
+            while (!stopped){
+                if (poll(fds.data(), fds.size(), 20) <= 0) continue;
+                for (size_t i=fds.size(); i-- > 0;){
+                    if ((fds[i].revents & (POLLIN | POLLHUP)) == 0) continue;
+                    int fd = fds[i].fd;
+                    if (fd == listener){
+                        fds.push_back({accept(listener, nullptr, nullptr), POLLIN, 0});
+                        connections++;
+                        continue;
+                    }
+                    char buffer[4096];
+                    ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+                    if (count <= 0){
+                        close(fd);
+                        requests.erase(fd);
+                        fds.erase(fds.begin() + i);
+                        continue;
+                    }
+                    string & request = requests[fd];
+                    request.append(buffer, count);
+                    size_t end;
+                    while ((end = request.find("\r\n\r\n")) != string::npos){
+                        size_t length = request.find("Content-Length: ");
+                        size_t bodySize = length < end ? std::stoul(request.substr(length + 16)) : 0;
+                        if (request.size() < end + 4 + bodySize) break;
+
+                        size_t start = request.find(' ') + 1;
+                        string path = request.substr(start, request.find(' ', start) - start);
+                        string body = path + request.substr(end + 4, bodySize);
+                        string response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+                        send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+                        request.erase(0, end + 4 + bodySize);
+                    }
+                }
+            }
+            for (size_t i=1; i<fds.size(); i++) close(fds[i].fd);
+        };
+        int listener;
+        int port;
+        std::atomic<bool> stopped;
+        std::thread worker;
+};
+
+TEST_P(InterpreterTest, IntegerAddition){
+    Object * result = exec("1 + 1", GetParam());
     ASSERT_EQ(result->toString(), "2");
 };
 
-TEST(InterpreterTest, IntegerSubtraction){
-    Object * result = exec("1 - 1");
+TEST_P(InterpreterTest, IntegerSubtraction){
+    Object * result = exec("1 - 1", GetParam());
     ASSERT_EQ(result->toString(), "0");
 };
 
-TEST(InterpreterTest, IntegerMultiplication){
-    Object * result = exec("2 * 2");
+TEST_P(InterpreterTest, IntegerMultiplication){
+    Object * result = exec("2 * 2", GetParam());
     ASSERT_EQ(result->toString(), "4");
 };
 
-TEST(InterpreterTest, IntegerDivision){
-    Object * result = exec("2 / 2");
+TEST_P(InterpreterTest, IntegerDivision){
+    Object * result = exec("2 / 2", GetParam());
     ASSERT_EQ(result->toString(), "1");
 };
 
-TEST(InterpreterTest, IntegerExponent){
-    Object * result = exec("2 ** 2");
+TEST_P(InterpreterTest, IntegerDivisionByZero){
+    ASSERT_THROW(exec("2 / 0", GetParam()), ZeroDivisionError);
+};
+
+TEST_P(InterpreterTest, IntegerExponent){
+    Object * result = exec("2 ** 2", GetParam());
     ASSERT_EQ(result->toString(), "4");
 };
 
-TEST(InterpreterTest, IntegerModulus){
-    Object * result = exec("2 % 4");
+TEST_P(InterpreterTest, IntegerModulus){
+    Object * result = exec("2 % 4", GetParam());
     ASSERT_EQ(result->toString(), "2");
 };
 
-TEST(InterpreterTest, IntegerNegativeExponent){
-    Object * result = exec("2 ** -2");
+TEST_P(InterpreterTest, IntegerNegativeExponent){
+    Object * result = exec("2 ** -2", GetParam());
     ASSERT_EQ(result->toString(), "0.25");
 };
 
-TEST(InterpreterTest, OpPrecedence){
-    Object * result = exec("2 + 3 * 3");
+TEST_P(InterpreterTest, OpPrecedence){
+    Object * result = exec("2 + 3 * 3", GetParam());
     ASSERT_EQ(result->toString(), "11");
-};
\ No newline at end of file
+};
+
+TEST_P(InterpreterTest, RecursiveLocals){
+    Object * result = run(
+        "method fib(n){\n"
+        "    if (n < 2){\n"
+        "        return n\n"
+        "    }\n"
+        "    let a = fib(n - 1)\n"
+        "    let b = fib(n - 2)\n"
+        "    return a + b\n"
+        "}\n"
+        "method main(){\n"
+        "    return fib(10)\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "55");
+};
+
+TEST_P(InterpreterTest, GlobalAssignFromMethod){
+    Object * result = run(
+        "let x = 1\n"
+        "method bump(){\n"
+        "    x += 1\n"
+        "}\n"
+        "method main(){\n"
+        "    bump()\n"
+        "    bump()\n"
+        "    return x\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "3");
+};
+
+TEST_P(InterpreterTest, ReturnFromLoop){
+    Object * result = run(
+        "method find(){\n"
+        "    let i = 0\n"
+        "    while (i < 10){\n"
+        "        if (i == 3){\n"
+        "            return i\n"
+        "        }\n"
+        "        i += 1\n"
+        "    }\n"
+        "    return -1\n"
+        "}\n"
+        "method main(){\n"
+        "    return find() + find()\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "6");
+};
+
+TEST_P(InterpreterTest, SkipLoop){
+    Object * result = run(
+        "method main(){\n"
+        "    let i = 0\n"
+        "    while (true){\n"
+        "        i += 1\n"
+        "        if (i == 5){\n"
+        "            skip\n"
+        "        }\n"
+        "    }\n"
+        "    return i\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "5");
+};
+
+TEST_P(InterpreterTest, SharedImmediates){
+    ASSERT_EQ(exec("1 < 2", GetParam()), Boolean::get(true));
+    ASSERT_EQ(exec("2 + 3", GetParam()), Integer::get(5));
+    ASSERT_NE(Integer::get(5000), Integer::get(5000));
+};
+
+TEST_P(InterpreterTest, CountingAllocatesNothing){
+    Heap & heap = Heap::instance();
+    string loop =
+        "method main(){\n"
+        "    let i = 0\n"
+        "    let last = 0\n"
+        "    while (i < N){\n"
+        "        last = (i + 1) * 3\n"
+        "        last -= 1\n"
+        "        i += 1\n"
+        "    }\n"
+        "    let expected = 3 * i\n"
+        "    expected -= 1\n"
+        "    return last == expected\n"
+        "}\n";
+    string shortLoop = loop;
+    string longLoop = loop;
+    shortLoop.replace(shortLoop.find("N"), 1, "10");
+    longLoop.replace(longLoop.find("N"), 1, "100000");
+
+    size_t start = heap.getAllocations();
+    ASSERT_EQ(run(shortLoop, GetParam()), Boolean::get(true));
+    size_t shortAllocations = heap.getAllocations() - start;
+    start = heap.getAllocations();
+    ASSERT_EQ(run(longLoop, GetParam()), Boolean::get(true));
+    size_t longAllocations = heap.getAllocations() - start;
+
+    // only the literal 100000 is outside the shared small integers
+    ASSERT_LE(longAllocations, shortAllocations + 1);
+};
+
+TEST_P(InterpreterTest, LazyRange){
+    Object * result = run(
+        "method count(){\n"
+        "    let total = 0\n"
+        "    each (let i : range(10000000)){\n"
+        "        total += 1\n"
+        "        if (i > 999){\n"
+        "            return total\n"
+        "        }\n"
+        "    }\n"
+        "    return total\n"
+        "}\n"
+        "method main(){\n"
+        "    let total = count()\n"
+        "    let down = range(10, 0, -3)\n"
+        "    let empty = range(5, 2)\n"
+        "    let result = [total, range(2, 5), down, down.size(), down[3], empty.size()]\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[1001, [2, 3, 4], [10, 7, 4, 1], 4, 1, 0]");
+};
+
+TEST_P(InterpreterTest, RangeMutation){
+    Object * result = run(
+        "method main(){\n"
+        "    let r = range(3)\n"
+        "    r.push(7)\n"
+        "    let last = r.pop()\n"
+        "    let first = r.pop(0)\n"
+        "    r[0] = \"x\"\n"
+        "    r.push(last)\n"
+        "    let seen = []\n"
+        "    each (let v : r){\n"
+        "        seen.push(v)\n"
+        "    }\n"
+        "    let result = [r, r.size(), r[2], first, seen]\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[[\"x\", 2, 7], 3, 7, 0, [\"x\", 2, 7]]");
+};
+
+TEST_P(InterpreterTest, IteratorProtocol){
+    Object * result = run(
+        "class Countdown{\n"
+        "    method init(start){\n"
+        "        @n = start\n"
+        "    }\n"
+        "    method next(){\n"
+        "        if (@n == 0){\n"
+        "            return none\n"
+        "        }\n"
+        "        @n -= 1\n"
+        "        return @n\n"
+        "    }\n"
+        "}\n"
+        "class Letters{\n"
+        "    method iter(){\n"
+        "        return \"abc\"\n"
+        "    }\n"
+        "}\n"
+        "method main(){\n"
+        "    let result = []\n"
+        "    each (let n : new Countdown(3)){\n"
+        "        result.push(n)\n"
+        "    }\n"
+        "    each (let c : new Letters()){\n"
+        "        result.push(c)\n"
+        "    }\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[2, 1, 0, \"a\", \"b\", \"c\"]");
+};
+
+TEST_P(InterpreterTest, JsonCodec){
+    Object * result = run(
+        "method main(){\n"
+        "    let data = jsonParse('{\"s\": \"a\\\\tb\\\\u00e9\", \"n\": [1, -2.5, 1e2, null, true], \"o\": {}}')\n"
+        "    let result = [data[\"s\"], data[\"n\"][1], jsonStringify(data)]\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[\"a\\tb\xc3\xa9\", -2.5, \"{\"s\": \"a\\\\tb\xc3\xa9\", \"n\": [1, -2.5, 100.0, null, true], \"o\": {}}\"]");
+
+    result = run(
+        "method main(){\n"
+        "    let result = []\n"
+        "    try {\n"
+        "        result.push(jsonParse('[12345678901]'))\n"
+        "    }\n"
+        "    catch {\n"
+        "        result.push('integer')\n"
+        "    }\n"
+        "    try {\n"
+        "        result.push(jsonParse('[1e300]'))\n"
+        "    }\n"
+        "    catch {\n"
+        "        result.push('exponent')\n"
+        "    }\n"
+        "    let infinite = 10.0\n"
+        "    let i = 0\n"
+        "    while (i < 8){\n"
+        "        infinite *= infinite\n"
+        "        i += 1\n"
+        "    }\n"
+        "    try {\n"
+        "        result.push(jsonStringify([infinite]))\n"
+        "    }\n"
+        "    catch {\n"
+        "        result.push('infinite')\n"
+        "    }\n"
+        "    result.push(jsonParse('[-2147483648]'))\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[\"integer\", \"exponent\", \"infinite\", [-2147483648]]");
+};
+
+TEST_P(InterpreterTest, JsonReader){
+    Object * result = run(
+        "method main(){\n"
+        "    let result = []\n"
+        "    each (let item : jsonReader(' [1, {\"a\": \"],\"}, [2, [3]], null] ')){\n"
+        "        result.push(item)\n"
+        "    }\n"
+        "    let pairs = jsonReader('{\"k\": true, \"v\": []}')\n"
+        "    result.push(pairs.next())\n"
+        "    result.push(pairs.next())\n"
+        "    result.push(pairs.next())\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[1, {\"a\": \"],\"}, [2, [3]], none, [\"k\", true], [\"v\", []], none]");
+};
+
+TEST_P(InterpreterTest, CsvReader){
+    Object * result = run(
+        "method main(){\n"
+        "    let result = []\n"
+        "    each (let row : csvReader('a,\"b,\"\"c\"\"\"\\n1,\"x\\ny\",\\n')){\n"
+        "        result.push(row)\n"
+        "    }\n"
+        "    let tabs = csvReader('k;v', ';')\n"
+        "    result.push(tabs.next())\n"
+        "    result.push(tabs.next())\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[[\"a\", \"b,\"c\"\"], [\"1\", \"x\\\\ny\", \"\"], [\"k\", \"v\"], none]");
+};
+
+TEST_P(InterpreterTest, CsvWriter){
+    string path = testing::TempDir() + "brio_csv_writer_" + GetParam() + ".csv";
+    Object * result = run(
+        "method main(){\n"
+        "    let f = open(\"" + path + "\", \"w\")\n"
+        "    let writer = csvWriter(f)\n"
+        "    writer.writerow([1, \"a,b\", 'say \"hi\"'])\n"
+        "    writer.writerows([[2.5, none], [true]])\n"
+        "    f.close()\n"
+        "    let result = []\n"
+        "    each (let row : csvReader(open(\"" + path + "\", \"r\"))){\n"
+        "        result.push(row)\n"
+        "    }\n"
+        "    return result\n"
+        "}\n", GetParam());
+    std::remove(path.c_str());
+    ASSERT_EQ(result->toString(), "[[\"1\", \"a,b\", \"say \"hi\"\"], [\"2.5\", \"\"], [\"true\"]]");
+};
+
+TEST_P(InterpreterTest, FileView){
+    // large enough to be memory mapped
+    string path = testing::TempDir() + "brio_file_view_" + GetParam() + ".txt";
+    string contents;
+    for (int i=0; i<10000; i++) contents += "row " + std::to_string(i) + "\r\n";
+    Util::write_file(path, contents);
+
+    Object * result = run(
+        "method main(){\n"
+        "    let f = open(\"" + path + "\", \"r\")\n"
+        "    let view = f.view()\n"
+        "    let rows = view.split('\\n')\n"
+        "    let g = open(\"" + path + "\", \"r\")\n"
+        "    let line = g.readline()\n"
+        "    let text = g.read()\n"
+        "    let result = [view.size(), view.count('row'), view.find('row 10'), view[4], rows.size(), text.size()]\n"
+        "    return result\n"
+        "}\n", GetParam());
+    std::remove(path.c_str());
+    ASSERT_EQ(result->toString(), "[98890, 10000, 70, \"0\", 10001, 88884]");
+};
+
+TEST_P(InterpreterTest, FileViewTooLarge){
+    // a sparse file just over 2 GiB, with a word past the last Integer offset
+    string path = testing::TempDir() + "brio_file_view_large_" + GetParam() + ".txt";
+    std::ofstream large(path, std::ios::binary);
+    large.seekp(std::streamoff(INT_MAX) + 16);
+    large << "needle";
+    large.close();
+
+    Object * result = run(
+        "method main(){\n"
+        "    let f = open(\"" + path + "\", \"r\")\n"
+        "    let view = f.view()\n"
+        "    let result = []\n"
+        "    try {\n"
+        "        result.push(view.size())\n"
+        "    }\n"
+        "    catch {\n"
+        "        result.push('size')\n"
+        "    }\n"
+        "    try {\n"
+        "        result.push(view.find('needle'))\n"
+        "    }\n"
+        "    catch {\n"
+        "        result.push('find')\n"
+        "    }\n"
+        "    result.push(view.find(''))\n"
+        "    return result\n"
+        "}\n", GetParam());
+    std::remove(path.c_str());
+    ASSERT_EQ(result->toString(), "[\"size\", \"find\", 0]");
+};
+
+TEST_P(InterpreterTest, FileLines){
+    // the first '\r\n' straddles two chunks
+    string path = testing::TempDir() + "brio_file_lines_" + GetParam() + ".txt";
+    Util::write_file(path, string(65535, 'x') + "\r\nb\rc\n\nlast");
+
+    Object * result = run(
+        "method main(){\n"
+        "    let f = open(\"" + path + "\", \"r\")\n"
+        "    let result = []\n"
+        "    each (let line : f.lines()){\n"
+        "        result.push(line.size())\n"
+        "    }\n"
+        "    let g = open(\"" + path + "\", \"r\")\n"
+        "    let lines = g.lines()\n"
+        "    let first = lines.next()\n"
+        "    result.push(lines.next())\n"
+        "    return result\n"
+        "}\n", GetParam());
+    std::remove(path.c_str());
+    ASSERT_EQ(result->toString(), "[65535, 1, 1, 0, 4, \"b\"]");
+};
+
+TEST_P(InterpreterTest, FileNewLines){
+    // line breaks on both sides of a 16 and a 32 byte block
+    string path = testing::TempDir() + "brio_file_new_lines_" + GetParam() + ".txt";
+    Util::write_file(path, string(15, 'a') + "\r\n" + string(14, 'b') + "\r" + string(20, 'c') + "\r\r\nd\r");
+
+    Object * result = run(
+        "method main(){\n"
+        "    let f = open(\"" + path + "\", \"r\")\n"
+        "    let text = f.read()\n"
+        "    let result = text.split('\\n')\n"
+        "    result.push(text.size())\n"
+        "    return result\n"
+        "}\n", GetParam());
+    std::remove(path.c_str());
+    ASSERT_EQ(result->toString(), "[\"aaaaaaaaaaaaaaa\", \"bbbbbbbbbbbbbb\", \"cccccccccccccccccccc\", \"\", \"d\", 55]");
+};
+
+TEST_P(InterpreterTest, BufferedPrint){
+    Output & output = Output::instance();
+    bool lineBuffered = output.isLineBuffered();
+    output.setLineBuffered(false);
+
+    testing::internal::CaptureStdout();
+    run("method main(){\n"
+        "    print(1)\n"
+        "    print(2, '')\n"
+        "    flush()\n"
+        "    print(3)\n"
+        "}\n", GetParam());
+    string flushed = testing::internal::GetCapturedStdout();
+
+    testing::internal::CaptureStdout();
+    output.flush();
+    string buffered = testing::internal::GetCapturedStdout();
+    output.setLineBuffered(lineBuffered);
+
+    ASSERT_EQ(flushed, "1\n2");
+    ASSERT_EQ(buffered, "3\n");
+};
+
+TEST_P(InterpreterTest, PrintStreamsValues){
+    testing::internal::CaptureStdout();
+    Object * result = run(
+        "method main(){\n"
+        "    let result = [1, 'a\\tb', [2.5, 'c\\nd', none], {'k': [true], 3: 'v'}, range(3)]\n"
+        "    print(result)\n"
+        "    flush()\n"
+        "    return result\n"
+        "}\n", GetParam());
+    string printed = testing::internal::GetCapturedStdout();
+
+    ASSERT_EQ(printed, result->toString() + "\n");
+    ASSERT_EQ(printed, "[1, \"a\\tb\", [2.5, \"c\\\\nd\", none], {\"k\": [true], 3: \"v\"}, [0, 1, 2]]\n");
+};
+
+TEST_P(InterpreterTest, HttpConnectionReuse){
+    LocalHttpServer server;
+    Object * result = run(
+        "method main(){\n"
+        "    let result = []\n"
+        "    each (let path : ['/a', '/b', '/c']){\n"
+        "        let url = '" + server.url() + "' + path\n"
+        "        let response = httpGet(url)\n"
+        "        result.push(response)\n"
+        "    }\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[\"/a\", \"/b\", \"/c\"]");
+    ASSERT_EQ(server.connections, 1);
+};
+
+TEST_P(InterpreterTest, HttpMulti){
+    LocalHttpServer server;
+    string url = server.url();
+    Object * result = run(
+        "method main(){\n"
+        "    let headers = {'url': '" + url + "/b', 'headers': ['X-Id: 1'], 'timeout': 5}\n"
+        "    let post = {'url': '" + url + "/c', 'body': 'x=1'}\n"
+        "    let requests = ['" + url + "/a', headers, post]\n"
+        "    let result = httpMulti(requests, 2)\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[\"/a\", \"/b\", \"/cx=1\"]");
+    ASSERT_LE(server.connections, 2);
+};
+
+TEST_P(InterpreterTest, HttpDownload){
+    // the server answers with the path, long enough to arrive in pieces
+    LocalHttpServer server;
+    string url = server.url() + "/" + string(40000, 'x');
+    string path = testing::TempDir() + "brio_http_download_" + GetParam() + ".txt";
+    Object * result = run(
+        "class Pieces{\n"
+        "    method init(){\n"
+        "        @sizes = []\n"
+        "    }\n"
+        "    method write(piece){\n"
+        "        @sizes.push(piece.size())\n"
+        "    }\n"
+        "}\n"
+        "method main(){\n"
+        "    let f = open(\"" + path + "\", \"w\")\n"
+        "    let written = httpDownload('" + url + "', f)\n"
+        "    f.close()\n"
+        "    let pieces = new Pieces()\n"
+        "    let received = httpDownload('" + url + "', pieces)\n"
+        "    let total = 0\n"
+        "    each (let size : pieces.sizes){\n"
+        "        total += size\n"
+        "    }\n"
+        "    let result = [written, received, total, pieces.sizes.size() > 1]\n"
+        "    return result\n"
+        "}\n", GetParam());
+    string contents = Util::read_file(path);
+    std::remove(path.c_str());
+    ASSERT_EQ(result->toString(), "[40001, 40001, 40001, true]");
+    ASSERT_EQ(contents, "/" + string(40000, 'x') + "\n");
+};
+
+TEST_P(InterpreterTest, DictionaryKeys){
+    Object * result = run(
+        "method main(){\n"
+        "    let d = {1: \"int\", \"1\": \"string\"}\n"
+        "    let i = 0\n"
+        "    while (i < 100){\n"
+        "        d[i] = i\n"
+        "        i += 1\n"
+        "    }\n"
+        "    d[\"k\"] = 1\n"
+        "    d[\"k\"] = 2\n"
+        "    d.pop(50)\n"
+        "    let result = [d.size(), d[1], d[\"1\"], d[\"k\"], d[99]]\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[101, 1, \"string\", 2, 99]");
+};
+
+TEST_P(InterpreterTest, DictionaryStridedKeys){
+    Object * result = run(
+        "method main(){\n"
+        "    let d = {}\n"
+        "    let i = 0\n"
+        "    while (i < 20000){\n"
+        "        d[i * 65536] = i\n"
+        "        i += 1\n"
+        "    }\n"
+        "    let found = 0\n"
+        "    i = 0\n"
+        "    while (i < 20000){\n"
+        "        if (d[i * 65536] == i){\n"
+        "            found += 1\n"
+        "        }\n"
+        "        i += 1\n"
+        "    }\n"
+        "    let result = [d.size(), found, d[65536 * 19999]]\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[20000, 20000, 19999]");
+};
+
+TEST_P(InterpreterTest, DictionaryInsertionOrder){
+    Object * result = run(
+        "method main(){\n"
+        "    let d = {\"b\": 1, \"a\": 2}\n"
+        "    d[\"c\"] = 3\n"
+        "    d.pop(\"b\")\n"
+        "    d[\"b\"] = 4\n"
+        "    d[\"a\"] = 5\n"
+        "    let keys = []\n"
+        "    each (let k : d){\n"
+        "        keys.push(k)\n"
+        "    }\n"
+        "    let result = [d, keys]\n"
+        "    return result\n"
+        "}\n", GetParam());
+    ASSERT_EQ(result->toString(), "[{\"a\": 5, \"c\": 3, \"b\": 4}, [\"a\", \"c\", \"b\"]]");
+};
+
+TEST_P(InterpreterTest, CollectsGarbage){
+    Heap & heap = Heap::instance();
+    size_t collections = heap.getCollections();
+    heap.setThreshold(100);
+    Object * result = run(
+        "let kept = [0]\n"
+        "method main(){\n"
+        "    let i = 0\n"
+        "    while (i < 500){\n"
+        "        let tmp = [i, i + 1, \"garbage\"]\n"
+        "        if (i > 497){\n"
+        "            kept.push(tmp)\n"
+        "        }\n"
+        "        i += 1\n"
+        "    }\n"
+        "    return kept\n"
+        "}\n", GetParam());
+    heap.setThreshold(Heap::INITIAL_THRESHOLD);
+    ASSERT_GT(heap.getCollections(), collections);
+    ASSERT_EQ(result->toString(), "[0, [498, 499, \"garbage\"], [499, 500, \"garbage\"]]");
+};
+
+TEST_P(InterpreterTest, RequestArena){
+    BrioLexer lexer(
+        "let seen = []\n"
+        "method main(env){\n"
+        "    let i = 0\n"
+        "    while (i < 50){\n"
+        "        let tmp = [i, \"garbage\"]\n"
+        "        i += 1\n"
+        "    }\n"
+        "    seen.push(env[\"id\"])\n"
+        "    return seen\n"
+        "}\n");
+    BrioParser parser(&lexer);
+    ProgramNode tree = parser.program();
+
+    OperatorPrecedenceVisitor opVisitor;
+    opVisitor.visit(&tree);
+
+    SymbolTable symbol_table;
+    Def def(&symbol_table);
+    def.downUp(&tree);
+
+    Ref ref(&symbol_table);
+    ref.downUp(&tree);
+
+    Interpreter interpreter(&tree, &symbol_table);
+    interpreter.setEngine(GetParam());
+    interpreter.exec(&tree);
+
+    // each request keeps only the id it stored in the global
+    Heap & heap = Heap::instance();
+    vector<size_t> live;
+    Object * output = nullptr;
+    for (int i=0; i<3; i++){
+        heap.openArena();
+        Dictionary * env = new Dictionary();
+        env->value.put(new String("id"), new String("request"));
+        vector<Object*> params;
+        params.push_back(env);
+        output = interpreter.main(params);
+        heap.closeArena();
+        interpreter.collectGarbage();
+        live.push_back(heap.getLiveCount());
+    }
+    ASSERT_EQ(live[1] - live[0], 1);
+    ASSERT_EQ(live[2] - live[1], 1);
+    ASSERT_EQ(output->toString(), "[\"request\", \"request\", \"request\"]");
+};
+
+TEST(HeapTest, WriteBarrierKeepsYoungObjects){
+    Heap & heap = Heap::instance();
+    heap.setThreshold(heap.getLiveCount() + 1000);  // minor collections only
+    Array * owner = new Array();
+    heap.mark(owner);
+    heap.collect();
+    ASSERT_TRUE(owner->old);
+
+    // only the write barrier reaches these, nothing else is marked
+    Array * young = new Array();
+    young->value.push_back(new String("child"));
+    owner->value.push_back(young);
+    heap.writeBarrier(owner, young);
+
+    size_t live = heap.getLiveCount();
+    size_t minorCollections = heap.getMinorCollections();
+    heap.collect();
+    heap.setThreshold(Heap::INITIAL_THRESHOLD);
+    ASSERT_EQ(heap.getMinorCollections(), minorCollections + 1);
+    ASSERT_EQ(heap.getLiveCount(), live);
+    ASSERT_TRUE(young->old);
+    ASSERT_EQ(owner->toString(), "[[\"child\"]]");
+};
+
+TEST(ConstantVisitorTest, LiteralDecodedOnce){
+    BrioLexer lexer("42");
+    BrioParser parser(&lexer);
+    ProgramNode tree = parser.program();
+
+    ConstantVisitor constVisitor;
+    constVisitor.visit(&tree);
+
+    AST * literal = tree.children[0];
+    ASSERT_NE(literal->constant, nullptr);
+    ASSERT_EQ(literal->constant->toString(), "42");
+    ASSERT_EQ(ConstantVisitor::materialize(literal), literal->constant);
+};
+
+TEST(HttpClientTest, DownloadLimit){
+    LocalHttpServer server;
+    string received;
+    HttpSink sink = [&received](const char * data, size_t size){
+        received.append(data, size);
+    };
+
+    // the server answers with the path, so these bodies are 100 and 101 bytes
+    HttpClient client;
+    ASSERT_EQ(client.download(server.url() + "/" + string(99, 'x'), sink, 100), 100);
+    received.clear();
+    ASSERT_THROW(client.download(server.url() + "/" + string(100, 'x'), sink, 100), ValueError);
+    ASSERT_LE(received.size(), 100);
+};
+
+INSTANTIATE_TEST_SUITE_P(Engines, InterpreterTest, ::testing::Values("tree", "vm"));